@@ -56,6 +56,19 @@ public:
 	*/
 	virtual bool STDispose( ISimHost *host ) = 0;
 
+	/**
+	 Called by the host before STUpdate when files in the virtual filesystem have changed since the previous
+	 simulation timestep. All the changes are batched into a single call, and the changes have already been
+	 applied to the virtual filesystem, so the module can reload whatever has changed. If too many changes were made
+	 at once for them to be tracked individually, the root path (an empty string) is included and the module should
+	 reload all of its content. This is only called if the host is watching the content for changes
+	 \param host the simulation thread host
+	 \param logicalPaths the logical paths of the files and folders which were added, removed or modified
+	 \param count the number of paths
+	 \return false if the module experiences a fatal error reloading the changed content
+	*/
+	virtual bool STContentChanged( ISimHost *host, const wchar_t * const *logicalPaths, UINT32 count ) = 0;
+
 	/**
 	 Called by the host immediately before the first call to RTDrawScene
 	 \param host the render thread host
@@ -21,6 +21,35 @@ public:
 	virtual bool Accept( const wchar_t *childname ) const = 0;
 };
 
+/**
+Provides direct read only access to the contents of a file which is held in memory
+*/
+class IFileView
+{
+public:
+	/**
+	get a pointer to the entire contents of the file. The data remains valid until the reader which provided the view is closed
+	\return a pointer to the contents of the file
+	*/
+	virtual const void *GetData() const = 0;
+
+	/**
+	get the size of the data in bytes
+	\return the size of the data in bytes
+	*/
+	virtual INT64 GetDataSize() const = 0;
+};
+
+/**
+a range of a file to read with IFileReader::ReadMany
+*/
+struct ReadRange {
+	INT64 offset; // the position in the file to start reading from
+	UINT64 length; // the maximum number of bytes to read
+	void *buffer; // the buffer to read into, which must be at least length bytes
+	UINT64 read; // set to the number of bytes actually read into the buffer
+};
+
 /**
  Provides an interface for reading data from a file
  */
@@ -33,12 +62,12 @@ public:
 	virtual void Close() = 0;
 
 	/**
-	reads the specified number of bytes into the buffer
+	reads the specified number of bytes into the buffer. Reads are not limited to 4GB, so files of any size can be read in one call
 	\param buffer a buffer to store the read data
 	\param length the max amount of data that can be read into the buffer
 	\return the amount of bytes actually read into the buffer
 	*/
-	virtual UINT32 Read( void* buffer, UINT32 length ) = 0;
+	virtual UINT64 Read( void* buffer, UINT64 length ) = 0;
 
 	/**
 	sets the read position of the file in bytes
@@ -63,6 +92,34 @@ public:
 	\return the filesize in bytes (for compressed archives this value is the uncompressed size)
 	*/
 	virtual INT64 GetSize() const = 0;
+
+	/**
+	get direct access to the contents of the file without copying it into a separate buffer. This allows
+	large files to be parsed in place, but not all readers support it
+	\return a view of the file contents which is valid until the reader is closed, or nullptr if the reader cannot provide one
+	*/
+	virtual const IFileView *GetView() {
+		return nullptr;
+	}
+
+	/**
+	read a number of ranges of the file in one call. vfs readers service the ranges in offset order regardless of the
+	order they are given in, so entries which have to be read sequentially (such as compressed archive entries) are only
+	read through once. Ranges may overlap. The read position of the file after the call is unspecified, so it should be
+	set before the next call to Read
+	\param ranges the ranges to read, the number of bytes read into each range is stored in the range
+	\param count the number of ranges
+	\return the total number of bytes read into all the ranges
+	*/
+	virtual UINT64 ReadMany( ReadRange *ranges, UINT32 count ) {
+		UINT64 total = 0;
+		for ( UINT32 i = 0; i < count; ++i ) {
+			SetPosition( ranges[i].offset );
+			ranges[i].read = Read( ranges[i].buffer, ranges[i].length );
+			total += ranges[i].read;
+		}
+		return total;
+	}
 };
 
 /**
@@ -115,19 +172,40 @@ public:
 	virtual bool  IsFolder() const = 0;
 
 	/**
-	determines if the file has an open reader
-	\return true if the file has an open reader
+	determines if the file has any open readers
+	\return true if the file has any open readers
 	*/
 	virtual bool  IsOpen() const = 0;
 
 	/**
-	attempt to open the file for reading. Only one fileReader can be open for a file at any time.
-	Because of this, you should ensure that any reader is closed after it is no longer needed.
+	attempt to open the file for reading. Each call creates a new reader with its own position, so a file
+	can be read by more than one reader (or thread) at a time. Readers share any resources held for the file
+	(such as a mapping or decompressed data) which are freed once every reader has been closed, so you
+	should ensure that any reader is closed after it is no longer needed.
 	\param reader will point to any reader that is created
-	\return nullptr if the file cannot be opened or is already open
+	\return MGDF_OK if the file was opened, otherwise an error code
 	*/
 	virtual MGDFError Open( IFileReader **reader ) = 0;
 
+	/**
+	open the file for reading without sharing a decompressed copy of its data with other readers. Compressed archive entries
+	are decompressed straight into the buffer passed to each IFileReader::Read, so every byte is only written once. This suits
+	reading a file from start to end into a buffer owned by the caller (such as a staging buffer), but seeking backwards
+	may require the entry to be decompressed again. Files which aren't compressed are opened the same way as with Open
+	\param reader will point to any reader that is created
+	\return MGDF_OK if the file was opened, otherwise an error code
+	*/
+	virtual MGDFError OpenUnbuffered( IFileReader **reader ) = 0;
+
+	/**
+	read the entire file into a caller supplied buffer without opening a reader. Compressed archive entries are decompressed
+	directly into the buffer
+	\param buffer the buffer to read into, or nullptr to only get the size of the file
+	\param length the length of the buffer. Will be set to the size of the file when the method returns
+	\return MGDF_OK if the file was read, MGDF_ERR_BUFFER_TOO_SMALL if the buffer can't hold the whole file, otherwise an error code
+	*/
+	virtual MGDFError ReadAll( void *buffer, UINT64 *length ) = 0;
+
 	/**
 	determines if the file is a (or is a member of) an archive file
 	\return true if the file is a (or is a member of) an archive file
@@ -157,6 +235,12 @@ public:
 	\return a timestamp indicating the last write time
 	*/
 	virtual time_t GetLastWriteTime() const = 0;
+
+	/**
+	get the size of the file without opening it
+	\return the size of the file in bytes, folders always have a size of 0
+	*/
+	virtual INT64 GetSize() const = 0;
 };
 
 /**
@@ -171,6 +255,7 @@ public:
 	\param physicalPath the physical path on disk containing the archive
 	\param parent the VFS parent node of the archive
 	\return the root node of the mapped vfs subtree
+	\note when the host is configured to map its content in the background this may be called from more than one thread at once
 	*/
 	virtual IFile * MapArchive( const wchar_t *name, const wchar_t *physicalPath, IFile *parent ) = 0;
 
@@ -193,6 +278,109 @@ public:
 	virtual void Dispose() = 0;
 };
 
+/**
+Provides a callback which is notified when an asynchronous read completes. The callback is made on one of the vfs I/O threads,
+so implementations must be threadsafe and should return quickly
+*/
+class IReadCompletionHandler
+{
+public:
+	/**
+	called once an asynchronous read has completed
+	\param result MGDF_OK if the read succeeded, otherwise an error code
+	\param bytesRead the number of bytes copied into the destination buffer
+	*/
+	virtual void OnReadComplete( MGDFError result, UINT64 bytesRead ) = 0;
+};
+
+/**
+Provides an interface for polling or waiting on an asynchronous read
+*/
+class IAsyncRead
+{
+public:
+	/**
+	determines if the read has completed
+	\return true if the read has completed
+	*/
+	virtual bool IsComplete() const = 0;
+
+	/**
+	block until the read has completed
+	*/
+	virtual void Wait() = 0;
+
+	/**
+	get the result of the read, if the read hasn't completed this blocks until it has
+	\param bytesRead will contain the number of bytes copied into the destination buffer
+	\return MGDF_OK if the read succeeded, otherwise an error code
+	*/
+	virtual MGDFError GetResult( UINT64 *bytesRead ) = 0;
+
+	/**
+	release the handle. This can be called before the read has completed, but the destination buffer must remain valid until it has
+	*/
+	virtual void Dispose() = 0;
+};
+
+/**
+The priority of a prefetch, the files in higher priority prefetches are prefetched before those in lower priority prefetches
+*/
+enum PrefetchPriority {PREFETCH_LOW, PREFETCH_NORMAL, PREFETCH_HIGH};
+
+/**
+Provides an interface for polling, waiting on or cancelling a prefetch
+*/
+class IPrefetch
+{
+public:
+	/**
+	determines if the prefetch has completed (or has been cancelled and has stopped)
+	\return true if the prefetch has completed
+	*/
+	virtual bool IsComplete() const = 0;
+
+	/**
+	block until the prefetch has completed
+	*/
+	virtual void Wait() = 0;
+
+	/**
+	stop prefetching any files which haven't been prefetched yet. Any file which is being prefetched when this is called
+	is allowed to finish, so the prefetch may not be complete immediately after this returns
+	*/
+	virtual void Cancel() = 0;
+
+	/**
+	get the number of files which have been prefetched so far
+	*/
+	virtual UINT32 GetPrefetchedCount() const = 0;
+
+	/**
+	release the handle. This can be called before the prefetch has completed, in which case the prefetch continues in the background
+	*/
+	virtual void Dispose() = 0;
+};
+
+/**
+Provides an iterator over the files, folders and archives which match a query. Matches are found as the iterator
+advances, so only as much of the vfs is mapped as is needed to find the next match
+*/
+class IFileQuery
+{
+public:
+	/**
+	get the next match. Matches are returned depth first, in name order
+	\return the next file/folder/archive which matches the query, or nullptr if there are no more matches
+	*/
+	virtual IFile * Next() = 0;
+
+	/**
+	release the query
+	*/
+	virtual void Dispose() = 0;
+};
+
 /**
 Provides an interface for accessing the virtual filesystem, which is a fast read only interface to access game content files. 
 The root MGDF virtual filesystem is mounted from the game/content folder.
@@ -213,6 +401,45 @@ public:
 	\return the root node of the virtual filesystem
 	*/
 	virtual IFile * GetRoot() const = 0;
+
+	/**
+	read part of a file on one of the vfs I/O threads rather than the calling thread. Each read opens its own reader
+	so any number of reads (including reads of the same file) can be in flight at once. Keeping a reader open on the
+	file while issuing reads keeps any data shared between readers (such as the decompressed contents of an archive
+	entry) resident between reads
+	\param file the file to read
+	\param offset the position in the file to start reading from
+	\param length the maximum number of bytes to read
+	\param buffer the buffer to read into, this must remain valid until the read has completed
+	\param handler (optional) a callback which is notified when the read completes
+	\param read (optional) will point to a handle which can be used to poll or wait on the read. This must be disposed once no longer needed
+	\return MGDF_OK if the read was queued, otherwise an error code
+	*/
+	virtual MGDFError ReadAsync( IFile *file, INT64 offset, UINT64 length, void *buffer, IReadCompletionHandler *handler, IAsyncRead **read ) = 0;
+
+	/**
+	warm up files on the vfs prefetch threads ahead of them being opened. Folders are mapped, archive entries are decompressed
+	into the entry cache (if it is enabled) and the pages of mapped files are faulted in, so that opening and reading the files later
+	doesn't stall the calling thread. Prefetching a folder or archive prefetches everything in it
+	\param logicalPaths the vfs paths of the files, folders or archives to prefetch
+	\param count the number of paths
+	\param priority the priority of the prefetch relative to any other prefetches which are in progress
+	\param prefetch (optional) will point to a handle which can be used to poll, wait on or cancel the prefetch. This must be disposed once no longer needed
+	\return MGDF_OK if the prefetch was queued, otherwise an error code
+	*/
+	virtual MGDFError Prefetch( const wchar_t * const *logicalPaths, UINT32 count, PrefetchPriority priority, IPrefetch **prefetch ) = 0;
+
+	/**
+	find the files/folders/archives whose logical paths match a glob pattern. Patterns are made up of / delimited segments
+	which are matched against the names at each level of the vfs. Segments can contain the wildcards * (any characters),
+	? (any one character) and [abc] or [a-z] (any one of the characters in the class, or any character not in it if the class
+	starts with !). A segment which is just ** matches any number of nested folders (including none), so textures/** matches
+	everything in the textures folder, and the segments textures, ** and *.dds match every .dds file anywhere in it
+	\param pattern the pattern to match
+	\param query will point to an iterator over the matches. This must be disposed once no longer needed
+	\return MGDF_OK if the query was created, or MGDF_ERR_INVALID_PARAMETER if the pattern was empty or invalid
+	*/
+	virtual MGDFError Query( const wchar_t *pattern, IFileQuery **query ) = 0;
 };
 
 }
\ No newline at end of file
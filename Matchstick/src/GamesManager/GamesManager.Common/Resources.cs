@@ -21,7 +21,7 @@ namespace MGDF.GamesManager.Common
 			public const string GameDirOverrideArgument = "gamediroverride";
 		}
 
-        public const int InterfaceVersion = 1;
+        public const int InterfaceVersion = 2;
         public const string SupportEmail = "support@matchstickframework.org";
 
 		public const string DependencyConfig = @"dependencies.json";
@@ -346,20 +346,27 @@ MGDFError OpenALSoundManagerComponentImpl::CreateSoundBuffer( IFile *dataSource,
 		}
 	}
 
-	IFileReader *reader = nullptr;
-	MGDFError error = dataSource->Open( &reader );
+	UINT64 size = 0;
+	MGDFError error = dataSource->ReadAll( nullptr, &size );
 	if ( MGDF_OK != error ) {
-		LOG( "Buffer file could not be opened or is already open for reading", LOG_ERROR );
+		LOG( "Buffer file could not be read", LOG_ERROR );
 		return error;
-	} 
+	}
+	if ( size > INT_MAX ) {
+		LOG( "Buffer file is too large to load into memory", LOG_ERROR );
+		return MGDF_ERR_ERROR_ALLOCATING_BUFFER;
+	}
 
-	INT64 size = reader->GetSize();
-	UINT32 truncSize = size > UINT_MAX ? UINT_MAX : static_cast<UINT32>( size );
-	char *data = new char[truncSize];
-	reader->Read( ( void * ) data, truncSize );
-	reader->Close();
+	// the file is read (or decompressed) straight into the buffer handed to alut
+	char *data = new char[static_cast<size_t>( size )];
+	error = dataSource->ReadAll( data, &size );
+	if ( MGDF_OK != error ) {
+		LOG( "Buffer file could not be read", LOG_ERROR );
+		delete[] data;
+		return error;
+	}
 
-	*bufferId = alutCreateBufferFromFileImage( ( ALvoid * ) data, truncSize );
+	*bufferId = alutCreateBufferFromFileImage( ( ALvoid * ) data, static_cast<ALsizei>( size ) );
 	delete[] data;
 
 	//if the buffer loaded ok, add it to the list of loaded shared buffers
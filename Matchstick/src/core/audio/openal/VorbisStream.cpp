@@ -452,8 +452,7 @@ size_t VorbisStream::ov_read_func( void *ptr, size_t size, size_t nmemb, void *d
 	IFileReader *reader = reinterpret_cast<IFileReader *>( datasource );
 	_ASSERTE( reader );
 
-	if ( ( size * nmemb ) > UINT32_MAX ) return 0; //can't read as much as was requested
-	return reader->Read( ptr, static_cast<UINT32>( size * nmemb ) );
+	return static_cast<size_t>( reader->Read( ptr, size * nmemb ) );
 }
 
 int VorbisStream::ov_seek_func( void *datasource, ogg_int64_t offset, int whence )
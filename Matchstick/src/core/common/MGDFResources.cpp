@@ -80,6 +80,16 @@ std::wstring Resources::LogFile()
 	return UserBaseDir() + L"coreLog.txt";
 }
 
+std::wstring Resources::VFSManifestFile()
+{
+	return UserBaseDir() + L"vfsManifest.bin";
+}
+
+std::wstring Resources::VFSTraceFile()
+{
+	return UserBaseDir() + L"vfsTrace.bin";
+}
+
 std::wstring Resources::ParamsFile()
 {
 	return RootDir() + L"params.txt";
@@ -173,6 +183,11 @@ std::wstring Resources::ContentDir()
 	return GameBaseDir() + L"content/";
 }
 
+std::wstring Resources::PatchesDir()
+{
+	return GameBaseDir() + L"patches/";
+}
+
 std::wstring Resources::Module()
 {
 	return BinDir() + L"module.dll";
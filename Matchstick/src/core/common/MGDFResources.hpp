@@ -44,9 +44,12 @@ public:
 	std::wstring GameUserPreferencesFile();
 	std::wstring GameUserStatisticsFile();
 	std::wstring ContentDir();
+	std::wstring PatchesDir();
 	std::wstring Module();
 	std::wstring BinDir();
 	std::wstring LogFile();
+	std::wstring VFSManifestFile();
+	std::wstring VFSTraceFile();
 
 	static const UINT32 MIN_SCREEN_X;
 	static const UINT32 MIN_SCREEN_Y;
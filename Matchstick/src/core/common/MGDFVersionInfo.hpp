@@ -15,7 +15,7 @@ public:
 	static const std::string &MGDF_VERSION() {
 		return _mgdfVersion;
 	}
-	static const INT32 MGDF_INTERFACE_VERSION = 1;
+	static const INT32 MGDF_INTERFACE_VERSION = 2;
 private:
 #pragma warning(push)
 #pragma warning(disable: 4251)
@@ -1,5 +1,6 @@
 #include "StdAfx.h"
 
+#include <algorithm>
 #include <iomanip>
 #include <filesystem>
 
@@ -13,6 +14,7 @@
 #include "MGDFCurrentDirectoryHelper.hpp"
 
 #include "../vfs/archive/zip/ZipArchiveHandlerImpl.hpp"
+#include "../vfs/archive/pak/PakArchiveHandlerImpl.hpp"
 
 
 #if defined(_DEBUG)
@@ -84,6 +86,8 @@ MGDFError Host::Init()
 	//ensure the vfs automatically enumerates zip files
 	LOG( "Registering Zip file VFS handler...", LOG_LOW );
 	_vfs->RegisterArchiveHandler( vfs::zip::CreateZipArchiveHandlerImpl( this ) );
+	LOG( "Registering pack file VFS handler...", LOG_LOW );
+	_vfs->RegisterArchiveHandler( vfs::pak::CreatePakArchiveHandlerImpl( this ) );
 
 	//ensure the vfs enumerates any custom defined archive formats
 	LOG( "Registering custom archive VFS handlers...", LOG_LOW );
@@ -102,6 +106,39 @@ MGDFError Host::Init()
 	}
 
 	//enumerate the current games content directory
+	const char *pathIndex = _game->GetPreference( PreferenceConstants::VFS_PATH_INDEX );
+	_vfs->EnablePathIndex( pathIndex && atoi( pathIndex ) != 0 );
+	const char *eagerMapping = _game->GetPreference( PreferenceConstants::VFS_EAGER_MAPPING );
+	_vfs->EnableEagerMapping( eagerMapping && atoi( eagerMapping ) != 0 );
+	const char *manifest = _game->GetPreference( PreferenceConstants::VFS_MANIFEST );
+	if ( manifest && atoi( manifest ) != 0 ) {
+		_vfs->EnableManifest( Resources::Instance().VFSManifestFile().c_str() );
+	}
+	const char *entryCache = _game->GetPreference( PreferenceConstants::VFS_ENTRY_CACHE_MB );
+	if ( entryCache && atoi( entryCache ) > 0 ) {
+		_vfs->EnableEntryCache( static_cast<size_t>( atoi( entryCache ) ) * 1024 * 1024 );
+	}
+	const char *watcher = _game->GetPreference( PreferenceConstants::VFS_WATCHER );
+	_vfs->EnableWatcher( watcher && atoi( watcher ) != 0 );
+	const char *trace = _game->GetPreference( PreferenceConstants::VFS_TRACE );
+	if ( trace && atoi( trace ) != 0 ) {
+		LOG( "Recording VFS access trace to " << Resources::ToString( Resources::Instance().VFSTraceFile() ), LOG_LOW );
+		_vfs->EnableTrace( Resources::Instance().VFSTraceFile().c_str() );
+	}
+	const char *pathFilter = _game->GetPreference( PreferenceConstants::VFS_PATH_FILTER );
+	_vfs->EnablePathFilter( pathFilter && atoi( pathFilter ) != 0 );
+	//patches are mounted over the top of the content in name order, so each patch shadows any files in the content and earlier patches
+	if ( is_directory( Resources::Instance().PatchesDir() ) ) {
+		std::vector<std::wstring> patches;
+		for ( directory_iterator it( Resources::Instance().PatchesDir() ), end; it != end; ++it ) {
+			patches.push_back( it->path().wstring() );
+		}
+		std::sort( patches.begin(), patches.end() );
+		for ( auto &patch : patches ) {
+			LOG( "Mounting patch " << Resources::ToString( patch ) << " into VFS...", LOG_LOW );
+			_vfs->AddOverlay( patch.c_str() );
+		}
+	}
 	LOG( "Mounting content directory into VFS...", LOG_LOW );
 	_vfs->Mount( Resources::Instance().ContentDir().c_str() );
 
@@ -242,6 +279,18 @@ void Host::STUpdate( double simulationTime, HostStats &stats )
 	    _timer->ConvertDifferenceToSeconds( audioEnd, audioStart ) );
 
 	if ( _module != nullptr ) {
+		_vfs->ProcessChanges( _changedContent );
+		if ( !_changedContent.empty() ) {
+			std::vector<const wchar_t *> paths;
+			for ( auto &changed : _changedContent ) {
+				paths.push_back( changed.c_str() );
+			}
+			LOG( "Calling module STContentChanged with " << paths.size() << " changes...", LOG_MEDIUM );
+			if ( !_module->STContentChanged( this, paths.data(), static_cast<UINT32>( paths.size() ) ) ) {
+				FATALERROR( this, "Error reloading changed content in module" );
+			}
+		}
+
 		LOG( "Calling module STUpdate...", LOG_HIGH );
 		if ( !_module->STUpdate( this, simulationTime ) ) {
 			FATALERROR( this, "Error updating scene in module" );
@@ -680,7 +729,7 @@ const char* Host::GetErrorDescription( MGDFError err ) const
 	static std::string invalidFile( "Not a valid VFS file" );
 	static std::string noPending( "This save name does not match any pending save created by BeginSave" );
 	static std::string invalidSave( "Invalid save name - only alphanumeric characters and the space character are permitted" );
-	static std::string archiveToLarge( "Archive file is too large - archive files cannot be over 4GB in size" );
+	static std::string archiveToLarge( "Archive file is too large - archive files must fit in the address space to be decompressed in memory" );
 	static std::string fileInUse( "File is already open for reading elsewhere" );
 	static std::string bufferTooSmall( "Target buffer is too small to hold all required data" );
 	static std::string fatal( "Fatal error - shutting down" );
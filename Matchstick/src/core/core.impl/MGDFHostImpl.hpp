@@ -128,6 +128,7 @@ private:
 	input::IInputManagerComponent *_input;
 	audio::ISoundManagerComponent *_sound;
 	vfs::IVirtualFileSystemComponent *_vfs;
+	std::vector<std::wstring> _changedContent;
 	Game *_game;
 	StringList *_saves;
 	RenderSettingsManager _renderSettings;
@@ -25,6 +25,13 @@ const char *PreferenceConstants::INTERPOLATE_FRAMES = "host.interpolateFrames";
 const char *PreferenceConstants::WINDOW_RESIZE = "host.windowResize";
 const char *PreferenceConstants::WINDOW_SIZEX = "host.windowSizeX";
 const char *PreferenceConstants::WINDOW_SIZEY = "host.windowSizeY";
+const char *PreferenceConstants::VFS_PATH_INDEX = "host.vfsPathIndex";
+const char *PreferenceConstants::VFS_EAGER_MAPPING = "host.vfsEagerMapping";
+const char *PreferenceConstants::VFS_MANIFEST = "host.vfsManifest";
+const char *PreferenceConstants::VFS_ENTRY_CACHE_MB = "host.vfsEntryCacheMB";
+const char *PreferenceConstants::VFS_WATCHER = "host.vfsWatcher";
+const char *PreferenceConstants::VFS_TRACE = "host.vfsTrace";
+const char *PreferenceConstants::VFS_PATH_FILTER = "host.vfsPathFilter";
 
 }
 }
@@ -21,6 +21,13 @@ public:
 	static const char *WINDOW_RESIZE;
 	static const char *WINDOW_SIZEX;
 	static const char *WINDOW_SIZEY;
+	static const char *VFS_PATH_INDEX;
+	static const char *VFS_EAGER_MAPPING;
+	static const char *VFS_MANIFEST;
+	static const char *VFS_ENTRY_CACHE_MB;
+	static const char *VFS_WATCHER;
+	static const char *VFS_TRACE;
+	static const char *VFS_PATH_FILTER;
 };
 
 }
@@ -0,0 +1,212 @@
+#include "StdAfx.h"
+
+#include <fstream>
+#include "MGDFAccessTrace.hpp"
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+std::atomic<AccessTrace *> AccessTrace::_recording( nullptr );
+
+AccessTrace::AccessTrace()
+	: _start( std::chrono::steady_clock::now() )
+{
+}
+
+AccessTrace::~AccessTrace()
+{
+	Stop();
+}
+
+bool AccessTrace::Start()
+{
+	AccessTrace *expected = nullptr;
+	return _recording.compare_exchange_strong( expected, this ) || expected == this;
+}
+
+void AccessTrace::Stop()
+{
+	AccessTrace *expected = this;
+	_recording.compare_exchange_strong( expected, nullptr );
+}
+
+void AccessTrace::TraceOpen( const IFile *file, IFileReader **reader )
+{
+	_ASSERTE( file );
+	_ASSERTE( reader && *reader );
+	AccessTrace *trace = _recording.load( std::memory_order_acquire );
+	if ( trace ) {
+		trace->RecordOpen( file );
+		*reader = new TracingFileReader( trace, file, *reader );
+	}
+}
+
+void AccessTrace::TraceReadAll( const IFile *file, UINT64 length )
+{
+	_ASSERTE( file );
+	AccessTrace *trace = _recording.load( std::memory_order_acquire );
+	if ( trace ) {
+		trace->RecordOpen( file );
+		if ( length ) {
+			trace->RecordRead( file, 0, length );
+		}
+	}
+}
+
+void AccessTrace::RecordOpen( const IFile *file )
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	Record( file, TraceEvent::OPEN, 0, 0 );
+}
+
+void AccessTrace::RecordRead( const IFile *file, INT64 offset, UINT64 length )
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	Record( file, TraceEvent::READ, static_cast<UINT64>( offset ), length );
+}
+
+void AccessTrace::Record( const IFile *file, UINT32 type, UINT64 offset, UINT64 length )
+{
+	auto found = _pathIndices.find( file );
+	if ( found == _pathIndices.end() ) {
+		found = _pathIndices.insert( std::make_pair( file, static_cast<UINT32>( _paths.size() ) ) ).first;
+		_paths.push_back( file->GetLogicalPath() );
+	}
+
+	// the time is taken while holding the lock so that events are always recorded in time order
+	TraceEvent event;
+	event.time = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - _start ).count();
+	event.offset = offset;
+	event.length = length;
+	event.path = found->second;
+	event.type = type;
+	_events.push_back( event );
+}
+
+bool AccessTrace::Save( const std::wstring &file ) const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	std::ofstream out( file, std::ios::out | std::ios::binary | std::ios::trunc );
+	if ( !out.is_open() ) {
+		return false;
+	}
+
+	TraceHeader header;
+	header.signature = TRACE_SIGNATURE;
+	header.version = TRACE_VERSION;
+	header.pathCount = _paths.size();
+	header.eventCount = _events.size();
+	out.write( reinterpret_cast<const char *>( &header ), sizeof( TraceHeader ) );
+
+	for ( auto &path : _paths ) {
+		UINT32 length = static_cast<UINT32>( path.size() );
+		out.write( reinterpret_cast<const char *>( &length ), sizeof( UINT32 ) );
+		out.write( reinterpret_cast<const char *>( path.data() ), static_cast<std::streamsize>( length * sizeof( wchar_t ) ) );
+	}
+	out.write( reinterpret_cast<const char *>( _events.data() ), static_cast<std::streamsize>( _events.size() * sizeof( TraceEvent ) ) );
+	out.close();
+	return !out.fail();
+}
+
+bool AccessTrace::Load( const std::wstring &file, std::vector<std::wstring> &paths, std::vector<TraceEvent> &events )
+{
+	paths.clear();
+	events.clear();
+
+	std::ifstream in( file, std::ios::in | std::ios::binary );
+	if ( !in.is_open() ) {
+		return false;
+	}
+
+	TraceHeader header;
+	if ( !in.read( reinterpret_cast<char *>( &header ), sizeof( TraceHeader ) ) ||
+	        header.signature != TRACE_SIGNATURE ||
+	        header.version != TRACE_VERSION ) {
+		return false;
+	}
+
+	for ( UINT64 i = 0; i < header.pathCount; ++i ) {
+		UINT32 length = 0;
+		if ( !in.read( reinterpret_cast<char *>( &length ), sizeof( UINT32 ) ) ) {
+			return false;
+		}
+		std::wstring path( length, L'\0' );
+		if ( length && !in.read( reinterpret_cast<char *>( &path[0] ), static_cast<std::streamsize>( length * sizeof( wchar_t ) ) ) ) {
+			return false;
+		}
+		paths.push_back( std::move( path ) );
+	}
+
+	//the events are read one at a time so a corrupt event count can't cause a huge allocation
+	TraceEvent event;
+	for ( UINT64 i = 0; i < header.eventCount; ++i ) {
+		if ( !in.read( reinterpret_cast<char *>( &event ), sizeof( TraceEvent ) ) || event.path >= paths.size() ) {
+			return false;
+		}
+		events.push_back( event );
+	}
+	return true;
+}
+
+TracingFileReader::TracingFileReader( AccessTrace *trace, const IFile *file, IFileReader *reader )
+	: _trace( trace )
+	, _file( file )
+	, _reader( reader )
+	, _viewed( false )
+{
+	_ASSERTE( trace );
+	_ASSERTE( file );
+	_ASSERTE( reader );
+}
+
+void TracingFileReader::Close()
+{
+	_reader->Close();
+	delete this;
+}
+
+UINT64 TracingFileReader::Read( void* buffer, UINT64 length )
+{
+	const INT64 offset = _reader->GetPosition();
+	const UINT64 read = _reader->Read( buffer, length );
+	if ( read ) {
+		_trace->RecordRead( _file, offset, read );
+	}
+	return read;
+}
+
+UINT64 TracingFileReader::ReadMany( ReadRange *ranges, UINT32 count )
+{
+	const UINT64 read = _reader->ReadMany( ranges, count );
+	for ( UINT32 i = 0; i < count; ++i ) {
+		if ( ranges[i].read ) {
+			_trace->RecordRead( _file, ranges[i].offset, ranges[i].read );
+		}
+	}
+	return read;
+}
+
+const IFileView *TracingFileReader::GetView()
+{
+	// the whole file is available through the view, so it is recorded as a read of the whole file
+	const IFileView *view = _reader->GetView();
+	if ( view && !_viewed ) {
+		_viewed = true;
+		_trace->RecordRead( _file, 0, static_cast<UINT64>( view->GetDataSize() ) );
+	}
+	return view;
+}
+
+}
+}
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <MGDF/MGDF.hpp>
+#include <MGDF/MGDFVirtualFileSystem.hpp>
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+/**
+the layout of a trace file
+
+	TraceHeader
+	paths[pathCount]	each path is a UINT32 length followed by that many utf-16 characters (not null terminated)
+	TraceEvent events[eventCount]	in the order they were recorded
+*/
+
+#define TRACE_SIGNATURE 0x4352544d // "MTRC"
+#define TRACE_VERSION 1
+
+struct TraceHeader {
+	UINT32 signature;
+	UINT32 version;
+	UINT64 pathCount;
+	UINT64 eventCount;
+};
+
+struct TraceEvent {
+	static const UINT32 OPEN = 0;
+	static const UINT32 READ = 1;
+
+	UINT64 time; // in microseconds since the trace was started
+	UINT64 offset;
+	UINT64 length;
+	UINT32 path; // index into the path table
+	UINT32 type;
+};
+
+static_assert( sizeof( TraceHeader ) == 24, "TraceHeader must match the file layout" );
+static_assert( sizeof( TraceEvent ) == 32, "TraceEvent must match the file layout" );
+
+/**
+records the logical path and time of every file opened through the vfs and every read from those files, so
+that archives can be laid out in the order thier contents are used. Only one trace can be recording at once
+*/
+class AccessTrace
+{
+public:
+	AccessTrace();
+	virtual ~AccessTrace();
+
+	/**
+	start recording every file opened through the vfs
+	\return false if another trace is already recording
+	*/
+	bool Start();
+	void Stop();
+
+	bool Save( const std::wstring &file ) const;
+	static bool Load( const std::wstring &file, std::vector<std::wstring> &paths, std::vector<TraceEvent> &events );
+
+	void RecordOpen( const IFile *file );
+	void RecordRead( const IFile *file, INT64 offset, UINT64 length );
+
+	/**
+	called by files when they are opened, if a trace is recording the open is recorded and the
+	reader is wrapped so that its reads are recorded too
+	*/
+	static void TraceOpen( const IFile *file, IFileReader **reader );
+
+	/**
+	called by files when they are read in full without a reader, this is recorded as an open followed by a read of the whole file
+	*/
+	static void TraceReadAll( const IFile *file, UINT64 length );
+private:
+	static std::atomic<AccessTrace *> _recording;
+
+	// must be called with the lock held
+	void Record( const IFile *file, UINT32 type, UINT64 offset, UINT64 length );
+
+	std::chrono::steady_clock::time_point _start;
+	mutable std::mutex _mutex;
+	std::unordered_map<const IFile *, UINT32> _pathIndices;
+	std::vector<std::wstring> _paths;
+	std::vector<TraceEvent> _events;
+};
+
+/**
+forwards to another reader, recording each read in a trace
+*/
+class TracingFileReader : public IFileReader
+{
+public:
+	TracingFileReader( AccessTrace *trace, const IFile *file, IFileReader *reader );
+	virtual ~TracingFileReader() {}
+
+	void Close() override final;
+	UINT64 Read( void* buffer, UINT64 length ) override final;
+	UINT64 ReadMany( ReadRange *ranges, UINT32 count ) override final;
+	void SetPosition( INT64 pos ) override final {
+		_reader->SetPosition( pos );
+	}
+	INT64 GetPosition() const override final {
+		return _reader->GetPosition();
+	}
+	bool EndOfFile() const override final {
+		return _reader->EndOfFile();
+	}
+	INT64 GetSize() const override final {
+		return _reader->GetSize();
+	}
+	const IFileView *GetView() override final;
+private:
+	AccessTrace *_trace;
+	const IFile *_file;
+	IFileReader *_reader;
+	bool _viewed;
+};
+
+}
+}
+}
@@ -0,0 +1,203 @@
+#include "StdAfx.h"
+
+#include <algorithm>
+#include "MGDFArena.hpp"
+
+// std min&max are used instead of the macros
+#ifdef min
+#undef min
+#undef max
+#endif
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+#define INITIAL_INTERN_CAPACITY 64
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+static uintptr_t AlignUp( uintptr_t address, size_t alignment )
+{
+	return ( address + alignment - 1 ) & ~( static_cast<uintptr_t>( alignment ) - 1 );
+}
+
+// FNV-1a
+static UINT32 HashString( const wchar_t *str, size_t length )
+{
+	UINT32 hash = 2166136261U;
+	for ( size_t i = 0; i < length; ++i ) {
+		hash ^= static_cast<UINT16>( str[i] );
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+Arena::Arena( size_t blockSize )
+	: _blockSize( blockSize )
+	, _reserved( 0 )
+	, _used( 0 )
+	, _internSaved( 0 )
+	, _current( nullptr )
+	, _blocks( nullptr )
+	, _destructors( nullptr )
+{
+	_ASSERTE( blockSize );
+	for ( auto &table : _strings ) {
+		table.slots = nullptr;
+		table.capacity = 0;
+		table.count = 0;
+	}
+}
+
+Arena::~Arena()
+{
+	// the destructor list is built by pushing onto its head, so objects are destroyed in the reverse order to which they were created
+	for ( Destructor *destructor = _destructors.load(); destructor; destructor = destructor->next ) {
+		destructor->destroy( destructor->object );
+	}
+	for ( Block *block = _blocks; block; ) {
+		Block *next = block->next;
+		block->~Block();
+		free( block );
+		block = next;
+	}
+}
+
+Arena::Block *Arena::AddBlock( size_t size )
+{
+	void *memory = malloc( sizeof( Block ) + size );
+	if ( !memory ) throw std::bad_alloc();
+	Block *block = ::new( memory ) Block();
+	block->size = size;
+	block->used.store( 0, std::memory_order_relaxed );
+	block->next = _blocks;
+	_blocks = block;
+	_reserved += sizeof( Block ) + size;
+	return block;
+}
+
+void *Arena::Allocate( size_t size, size_t alignment )
+{
+	_ASSERTE( alignment && ( alignment & ( alignment - 1 ) ) == 0 );
+
+	for ( ;; ) {
+		// bump the offset into the current block, only falling back to the lock once the block is full
+		Block *block = _current.load( std::memory_order_acquire );
+		if ( block ) {
+			const uintptr_t data = reinterpret_cast<uintptr_t>( GetData( block ) );
+			size_t used = block->used.load( std::memory_order_relaxed );
+			for ( ;; ) {
+				const uintptr_t aligned = AlignUp( data + used, alignment );
+				const size_t end = static_cast<size_t>( aligned - data ) + size;
+				if ( end > block->size ) break;
+				if ( block->used.compare_exchange_weak( used, end, std::memory_order_relaxed ) ) {
+					_used.fetch_add( size, std::memory_order_relaxed );
+					return reinterpret_cast<void *>( aligned );
+				}
+			}
+		}
+
+		std::lock_guard<std::mutex> lock( _mutex );
+		if ( size + alignment > _blockSize ) {
+			// oversized allocations get a block of thier own, which doesn't replace the current block
+			Block *oversized = AddBlock( size + alignment );
+			oversized->used.store( oversized->size, std::memory_order_relaxed );
+			_used.fetch_add( size, std::memory_order_relaxed );
+			return reinterpret_cast<void *>( AlignUp( reinterpret_cast<uintptr_t>( GetData( oversized ) ), alignment ) );
+		}
+		// if another thread has already replaced the full block, try again in the new one
+		if ( _current.load( std::memory_order_relaxed ) == block ) {
+			_current.store( AddBlock( _blockSize ), std::memory_order_release );
+		}
+	}
+}
+
+void Arena::AddDestructor( void *object, void ( *destroy )( void * ) )
+{
+	Destructor *destructor = static_cast<Destructor *>( Allocate( sizeof( Destructor ), alignof( Destructor ) ) );
+	destructor->object = object;
+	destructor->destroy = destroy;
+	destructor->next = _destructors.load( std::memory_order_relaxed );
+	while ( !_destructors.compare_exchange_weak( destructor->next, destructor, std::memory_order_release, std::memory_order_relaxed ) ) {
+	}
+}
+
+const wchar_t *Arena::Copy( const wchar_t *str, size_t length )
+{
+	_ASSERTE( str );
+	wchar_t *copy = static_cast<wchar_t *>( Allocate( ( length + 1 ) * sizeof( wchar_t ), alignof( wchar_t ) ) );
+	memcpy( copy, str, length * sizeof( wchar_t ) );
+	copy[length] = '\0';
+	return copy;
+}
+
+void Arena::Grow( InternTable &table )
+{
+	const size_t capacity = table.capacity ? table.capacity * 2 : INITIAL_INTERN_CAPACITY;
+	InternedString *slots = static_cast<InternedString *>( Allocate( capacity * sizeof( InternedString ), alignof( InternedString ) ) );
+	memset( slots, 0, capacity * sizeof( InternedString ) );
+
+	// the previous slots are left in the arena, they are never more than half the size of the new ones
+	const size_t mask = capacity - 1;
+	for ( size_t i = 0; i < table.capacity; ++i ) {
+		const InternedString &entry = table.slots[i];
+		if ( !entry.str ) continue;
+		size_t index = ( entry.hash / INTERN_TABLES ) & mask;
+		while ( slots[index].str ) {
+			index = ( index + 1 ) & mask;
+		}
+		slots[index] = entry;
+	}
+	table.slots = slots;
+	table.capacity = capacity;
+}
+
+const wchar_t *Arena::Intern( const wchar_t *str, size_t length )
+{
+	_ASSERTE( str );
+	_ASSERTE( length <= MAXUINT32 );
+
+	// the low bits of the hash pick the table, and the remaining bits pick the slot within it
+	const UINT32 hash = HashString( str, length );
+	InternTable &table = _strings[hash % INTERN_TABLES];
+	std::lock_guard<std::mutex> lock( table.mutex );
+
+	if ( ( table.count + 1 ) * 4 > table.capacity * 3 ) {
+		Grow( table );
+	}
+
+	const size_t mask = table.capacity - 1;
+	size_t index = ( hash / INTERN_TABLES ) & mask;
+	for ( ; table.slots[index].str; index = ( index + 1 ) & mask ) {
+		const InternedString &entry = table.slots[index];
+		if ( entry.hash == hash && entry.length == length && wmemcmp( entry.str, str, length ) == 0 ) {
+			_internSaved.fetch_add( ( length + 1 ) * sizeof( wchar_t ), std::memory_order_relaxed );
+			return entry.str;
+		}
+	}
+
+	InternedString &entry = table.slots[index];
+	entry.str = Copy( str, length );
+	entry.length = static_cast<UINT32>( length );
+	entry.hash = hash;
+	++table.count;
+	return entry.str;
+}
+
+size_t Arena::GetReservedBytes() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return _reserved;
+}
+
+}
+}
+}
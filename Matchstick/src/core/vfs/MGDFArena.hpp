@@ -0,0 +1,185 @@
+#pragma once
+
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <type_traits>
+#include <MGDF/MGDF.hpp>
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+/**
+a bump allocator used to store all the nodes (and thier names) of a single mounted directory or archive.
+Memory is handed out from large blocks and is never freed individually, instead when the arena is destroyed
+it runs the destructors of any objects created in it which need them and then releases all of its blocks.
+Allocation only takes a lock when a new block is needed, so many threads can map into the same arena at once.
+Names are interned, so identical strings within the arena share the same storage.
+*/
+class Arena
+{
+public:
+	static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+	Arena( size_t blockSize = DEFAULT_BLOCK_SIZE );
+	virtual ~Arena();
+
+	void *Allocate( size_t size, size_t alignment );
+
+	/**
+	construct a new object in the arena. The object must not be deleted, it
+	will be destroyed when the arena is destroyed
+	*/
+	template <typename T, typename... Args>
+	T *New( Args && ... args ) {
+		void *memory = Allocate( sizeof( T ), alignof( T ) );
+		T *object = ::new( memory ) T( std::forward<Args>( args )... );
+		// trivially destructible objects (such as child lists) are released along with the blocks
+		if ( !std::is_trivially_destructible<T>::value ) {
+			AddDestructor( object, &Arena::Destroy<T> );
+		}
+		return object;
+	}
+
+	/**
+	get a copy of the string which lives for as long as the arena. Interning
+	the same string more than once returns the same copy each time
+	*/
+	const wchar_t *Intern( const wchar_t *str, size_t length );
+	const wchar_t *Intern( const std::wstring &str ) {
+		return Intern( str.c_str(), str.size() );
+	}
+
+	/**
+	get a copy of the string which lives for as long as the arena, without interning it. This should be used
+	for strings which are unlikely to be repeated (e.g. physical and logical paths)
+	*/
+	const wchar_t *Copy( const wchar_t *str, size_t length );
+	const wchar_t *Copy( const std::wstring &str ) {
+		return Copy( str.c_str(), str.size() );
+	}
+
+	/**
+	the total size of all the blocks allocated by the arena
+	*/
+	size_t GetReservedBytes() const;
+
+	/**
+	the number of bytes handed out by the arena
+	*/
+	size_t GetUsedBytes() const {
+		return _used.load( std::memory_order_relaxed );
+	}
+
+	/**
+	the number of bytes which would have been needed to store every string interned, had they not been interned
+	*/
+	size_t GetInternedBytesSaved() const {
+		return _internSaved.load( std::memory_order_relaxed );
+	}
+private:
+	struct Block {
+		Block *next;
+		size_t size; // the size of the data which follows the block header
+		std::atomic<size_t> used;
+	};
+
+	struct Destructor {
+		void *object;
+		void ( *destroy )( void * );
+		Destructor *next;
+	};
+
+	struct InternedString {
+		const wchar_t *str;
+		UINT32 length;
+		UINT32 hash;
+	};
+
+	/**
+	an open addressed hash table of interned strings, whose slots are allocated from the arena. The strings
+	are spread over a number of tables by thier hash so threads interning different names rarely contend
+	*/
+	struct InternTable {
+		std::mutex mutex;
+		InternedString *slots;
+		size_t capacity; // always a power of 2
+		size_t count;
+	};
+	static const size_t INTERN_TABLES = 16;
+
+	template <typename T>
+	static void Destroy( void *object ) {
+		static_cast<T *>( object )->~T();
+	}
+
+	static char *GetData( Block *block ) {
+		return reinterpret_cast<char *>( block + 1 );
+	}
+
+	void AddDestructor( void *object, void ( *destroy )( void * ) );
+	Block *AddBlock( size_t size );
+	void Grow( InternTable &table );
+
+	mutable std::mutex _mutex; // guards adding new blocks
+	size_t _blockSize;
+	size_t _reserved;
+	std::atomic<size_t> _used;
+	std::atomic<size_t> _internSaved;
+	std::atomic<Block *> _current;
+	Block *_blocks;
+	std::atomic<Destructor *> _destructors;
+	InternTable _strings[INTERN_TABLES];
+};
+
+/**
+an stl allocator which allocates from an arena, deallocation is a no-op as the
+memory is reclaimed when the arena is destroyed
+*/
+template <typename T>
+class ArenaAllocator
+{
+public:
+	typedef T value_type;
+
+	ArenaAllocator( Arena *arena )
+		: _arena( arena ) {
+	}
+
+	template <typename U>
+	ArenaAllocator( const ArenaAllocator<U> &other )
+		: _arena( other.GetArena() ) {
+	}
+
+	T *allocate( size_t count ) {
+		return static_cast<T *>( _arena->Allocate( count * sizeof( T ), alignof( T ) ) );
+	}
+
+	void deallocate( T *, size_t ) {
+	}
+
+	Arena *GetArena() const {
+		return _arena;
+	}
+
+	template <typename U>
+	bool operator==( const ArenaAllocator<U> &other ) const {
+		return _arena == other.GetArena();
+	}
+
+	template <typename U>
+	bool operator!=( const ArenaAllocator<U> &other ) const {
+		return _arena != other.GetArena();
+	}
+private:
+	Arena *_arena;
+};
+
+}
+}
+}
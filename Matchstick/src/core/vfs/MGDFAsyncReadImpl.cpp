@@ -0,0 +1,106 @@
+#include "StdAfx.h"
+
+#include "MGDFAsyncReadImpl.hpp"
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+AsyncReadImpl::AsyncReadImpl( IFile *file, INT64 offset, UINT64 length, void *buffer, IReadCompletionHandler *handler, bool hasHandle )
+	: _file( file )
+	, _offset( offset )
+	, _length( length )
+	, _buffer( buffer )
+	, _handler( handler )
+	, _complete( false )
+	, _result( MGDF_OK )
+	, _bytesRead( 0 )
+	, _references( hasHandle ? 2 : 1 )
+{
+	_ASSERTE( file );
+	_ASSERTE( buffer );
+}
+
+bool AsyncReadImpl::IsComplete() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return _complete;
+}
+
+void AsyncReadImpl::Wait()
+{
+	std::unique_lock<std::mutex> lock( _mutex );
+	_completed.wait( lock, [this]() {
+		return _complete;
+	} );
+}
+
+MGDFError AsyncReadImpl::GetResult( UINT64 *bytesRead )
+{
+	Wait();
+	if ( bytesRead ) {
+		*bytesRead = _bytesRead;
+	}
+	return _result;
+}
+
+void AsyncReadImpl::Dispose()
+{
+	Release();
+}
+
+void AsyncReadImpl::Release()
+{
+	bool destroy;
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+		destroy = --_references == 0;
+	}
+	if ( destroy ) {
+		delete this;
+	}
+}
+
+void AsyncReadImpl::Execute()
+{
+	UINT64 bytesRead = 0;
+	IFileReader *reader = nullptr;
+	MGDFError result = _file->IsFolder() ? MGDF_ERR_IS_FOLDER : _file->Open( &reader );
+	if ( result == MGDF_OK ) {
+		if ( _offset < 0 || _offset > reader->GetSize() ) {
+			result = MGDF_ERR_INVALID_PARAMETER;
+		} else {
+			reader->SetPosition( _offset );
+			bytesRead = reader->Read( _buffer, _length );
+		}
+		reader->Close();
+	}
+
+	// the handler is notified before the read is marked as complete, so once a waiting
+	// caller has been released it is safe for them to destroy the handler
+	if ( _handler ) {
+		_handler->OnReadComplete( result, bytesRead );
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+		_result = result;
+		_bytesRead = bytesRead;
+		_complete = true;
+	}
+	_completed.notify_all();
+	Release();
+}
+
+}
+}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <MGDF/MGDF.hpp>
+#include <MGDF/MGDFVirtualFileSystem.hpp>
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+/**
+a read which is queued on the vfs I/O pool. The read is referenced by the pool until it has been executed
+and by the caller until the handle is disposed (if the caller asked for a handle)
+*/
+class AsyncReadImpl : public IAsyncRead
+{
+public:
+	AsyncReadImpl( IFile *file, INT64 offset, UINT64 length, void *buffer, IReadCompletionHandler *handler, bool hasHandle );
+	virtual ~AsyncReadImpl() {}
+
+	bool IsComplete() const override final;
+	void Wait() override final;
+	MGDFError GetResult( UINT64 *bytesRead ) override final;
+	void Dispose() override final;
+
+	/**
+	perform the read, notify the completion handler and release the pools reference to the read
+	*/
+	void Execute();
+private:
+	void Release();
+
+	IFile *_file;
+	INT64 _offset;
+	UINT64 _length;
+	void *_buffer;
+	IReadCompletionHandler *_handler;
+
+	mutable std::mutex _mutex;
+	std::condition_variable _completed;
+	bool _complete;
+	MGDFError _result;
+	UINT64 _bytesRead;
+	UINT32 _references;
+};
+
+}
+}
+}
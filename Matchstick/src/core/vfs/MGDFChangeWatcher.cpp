@@ -0,0 +1,213 @@
+#include "StdAfx.h"
+
+#include <algorithm>
+
+#include "../common/MGDFLoggerImpl.hpp"
+#include "../common/MGDFResources.hpp"
+#include "MGDFChangeWatcher.hpp"
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+#define CHANGE_BUFFER_SIZE 16384
+
+ChangeWatcher::ChangeWatcher()
+	: _port( CreateIoCompletionPort( INVALID_HANDLE_VALUE, nullptr, 0, 1 ) )
+{
+	if ( !_port ) {
+		LOG( "Unable to create completion port to watch content for changes - " << GetLastError(), LOG_ERROR );
+	}
+}
+
+ChangeWatcher::~ChangeWatcher()
+{
+	if ( _thread.joinable() ) {
+		//a completion without an overlapped read tells the thread to stop
+		PostQueuedCompletionStatus( _port, 0, 0, nullptr );
+		_thread.join();
+	}
+	for ( auto directory : _directories ) {
+		CloseHandle( directory->handle );
+		delete directory;
+	}
+	if ( _port ) {
+		CloseHandle( _port );
+	}
+}
+
+INT32 ChangeWatcher::Watch( const std::wstring &directory )
+{
+	_ASSERTE( !_thread.joinable() );
+	if ( !_port ) {
+		return -1;
+	}
+
+	HANDLE handle = CreateFileW( directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr );
+	if ( handle == INVALID_HANDLE_VALUE ) {
+		LOG( "Unable to watch " << Resources::ToString( directory ) << " for changes", LOG_ERROR );
+		return -1;
+	}
+
+	//each directory is identified by its index when its reads complete
+	if ( !CreateIoCompletionPort( handle, _port, static_cast<ULONG_PTR>( _directories.size() ), 0 ) ) {
+		LOG( "Unable to watch " << Resources::ToString( directory ) << " for changes - " << GetLastError(), LOG_ERROR );
+		CloseHandle( handle );
+		return -1;
+	}
+
+	Directory *watched = new Directory();
+	watched->handle = handle;
+	ZeroMemory( &watched->overlapped, sizeof( OVERLAPPED ) );
+	watched->buffer.resize( CHANGE_BUFFER_SIZE / sizeof( DWORD ) );
+	watched->path = directory;
+	watched->reading = false;
+	_directories.push_back( watched );
+	return static_cast<INT32>( _directories.size() - 1 );
+}
+
+void ChangeWatcher::Start()
+{
+	_ASSERTE( !_thread.joinable() );
+	for ( auto directory : _directories ) {
+		if ( !Read( *directory ) ) {
+			LOG( "Unable to watch " << Resources::ToString( directory->path ) << " for changes - " << GetLastError(), LOG_ERROR );
+		}
+	}
+	_thread = std::thread( [this]() {
+		Run();
+	} );
+}
+
+void ChangeWatcher::GetChanges( std::vector<Change> &changes )
+{
+	changes.clear();
+	std::lock_guard<std::mutex> lock( _mutex );
+	changes.swap( _changes );
+}
+
+bool ChangeWatcher::Read( Directory &directory )
+{
+	directory.reading = ReadDirectoryChangesW(
+	                        directory.handle,
+	                        directory.buffer.data(),
+	                        static_cast<DWORD>( directory.buffer.size() * sizeof( DWORD ) ),
+	                        TRUE,
+	                        FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+	                        nullptr,
+	                        &directory.overlapped,
+	                        nullptr ) != FALSE;
+	return directory.reading;
+}
+
+void ChangeWatcher::Run()
+{
+	while ( true ) {
+		DWORD bytes = 0;
+		ULONG_PTR key = 0;
+		OVERLAPPED *overlapped = nullptr;
+		BOOL result = GetQueuedCompletionStatus( _port, &bytes, &key, &overlapped, INFINITE );
+		if ( !overlapped ) {
+			if ( !result ) {
+				LOG( "Unable to wait for changes to watched content - " << GetLastError(), LOG_ERROR );
+			}
+			break;
+		}
+
+		const size_t index = static_cast<size_t>( key );
+		Directory &directory = *_directories[index];
+		directory.reading = false;
+		if ( !result ) {
+			//the directory can no longer be watched (e.g. it was deleted), so whatever is left of it is remapped one last time
+			LOG( "Unable to continue watching " << Resources::ToString( directory.path ) << " for changes - " << GetLastError(), LOG_ERROR );
+			AddRescan( index );
+			continue;
+		}
+
+		if ( !bytes ) {
+			//the buffer overflowed, so there is no way to tell what changed
+			LOG( "Too many changes to " << Resources::ToString( directory.path ) << " at once, all of its content will be remapped", LOG_ERROR );
+			AddRescan( index );
+		} else {
+			AddChanges( index, directory );
+		}
+
+		if ( !Read( directory ) ) {
+			LOG( "Unable to continue watching " << Resources::ToString( directory.path ) << " for changes - " << GetLastError(), LOG_ERROR );
+			AddRescan( index );
+		}
+	}
+
+	//the outstanding reads write into the buffers of each directory, so wait until they have all been cancelled
+	size_t outstanding = 0;
+	for ( auto directory : _directories ) {
+		if ( directory->reading ) {
+			//reads which complete before they can be cancelled still post thier completion to the port
+			CancelIoEx( directory->handle, &directory->overlapped );
+			++outstanding;
+		}
+	}
+	while ( outstanding ) {
+		DWORD bytes = 0;
+		ULONG_PTR key = 0;
+		OVERLAPPED *overlapped = nullptr;
+		if ( !GetQueuedCompletionStatus( _port, &bytes, &key, &overlapped, INFINITE ) && !overlapped ) {
+			break;
+		}
+		if ( overlapped ) {
+			--outstanding;
+		}
+	}
+}
+
+void ChangeWatcher::AddChanges( size_t index, const Directory &directory )
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	const char *next = reinterpret_cast<const char *>( directory.buffer.data() );
+	while ( true ) {
+		const FILE_NOTIFY_INFORMATION *info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>( next );
+		Change change;
+		change.directory = index;
+		change.path.assign( info->FileName, info->FileNameLength / sizeof( wchar_t ) );
+		std::replace( change.path.begin(), change.path.end(), L'\\', L'/' );
+		switch ( info->Action ) {
+		case FILE_ACTION_ADDED:
+		case FILE_ACTION_RENAMED_NEW_NAME:
+			change.type = ADDED;
+			break;
+		case FILE_ACTION_REMOVED:
+		case FILE_ACTION_RENAMED_OLD_NAME:
+			change.type = REMOVED;
+			break;
+		default:
+			change.type = MODIFIED;
+			break;
+		}
+		_changes.push_back( change );
+
+		if ( !info->NextEntryOffset ) break;
+		next += info->NextEntryOffset;
+	}
+}
+
+void ChangeWatcher::AddRescan( size_t index )
+{
+	Change change;
+	change.directory = index;
+	change.type = RESCAN;
+	std::lock_guard<std::mutex> lock( _mutex );
+	_changes.push_back( change );
+}
+
+}
+}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <MGDF/MGDF.hpp>
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+/**
+watches one or more directory trees for changes on a background thread. Changes are queued up as they
+are reported by the filesystem, and are collected in batches by calling GetChanges. The reads for every
+directory complete on a single IO completion port, so there is no limit on how many directories can be watched
+*/
+class ChangeWatcher
+{
+public:
+	enum ChangeType {
+		ADDED,
+		REMOVED,
+		MODIFIED,
+		RESCAN // changes to the directory were missed, so everything in it has to be remapped. The path is empty
+	};
+
+	struct Change {
+		size_t directory; // the index of the watched directory which contains the change
+		std::wstring path; // relative to the watched directory, using '/' as the separator
+		ChangeType type;
+	};
+
+	ChangeWatcher();
+
+	/**
+	stops watching all directories, any changes which have not been collected are discarded
+	*/
+	virtual ~ChangeWatcher();
+
+	/**
+	add a directory to watch, this must be called before the watcher is started
+	\return the index of the directory, or -1 if the directory couldn't be opened
+	*/
+	INT32 Watch( const std::wstring &directory );
+
+	void Start();
+
+	/**
+	get all the changes reported since the last call, in the order they were reported
+	*/
+	void GetChanges( std::vector<Change> &changes );
+
+private:
+	struct Directory {
+		HANDLE handle;
+		OVERLAPPED overlapped;
+		std::vector<DWORD> buffer; // change notifications must be DWORD aligned
+		std::wstring path;
+		bool reading; // whether a read is outstanding, and so will complete on the port
+	};
+
+	bool Read( Directory &directory );
+	void Run();
+	void AddChanges( size_t index, const Directory &directory );
+	void AddRescan( size_t index );
+
+	std::vector<Directory *> _directories;
+	HANDLE _port;
+	std::thread _thread;
+	std::mutex _mutex;
+	std::vector<Change> _changes;
+};
+
+}
+}
+}
@@ -0,0 +1,92 @@
+#include "StdAfx.h"
+
+#include <algorithm>
+#include "MGDFChildList.hpp"
+
+
+#define INITIAL_CHILD_CAPACITY 8
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+ChildList::ChildList( Arena *arena )
+	: _arena( arena )
+	, _entries( nullptr )
+	, _size( 0 )
+	, _capacity( 0 )
+	, _frozen( false )
+{
+	_ASSERTE( arena );
+}
+
+void ChildList::Add( IFile *file )
+{
+	_ASSERTE( file );
+	_ASSERTE( !_frozen );
+	if ( _size == _capacity ) {
+		// the previous array is left in the arena, it is never more than half the size of the new one
+		const size_t capacity = _capacity ? _capacity * 2 : INITIAL_CHILD_CAPACITY;
+		Entry *entries = static_cast<Entry *>( _arena->Allocate( capacity * sizeof( Entry ), alignof( Entry ) ) );
+		std::copy( _entries, _entries + _size, entries );
+		_entries = entries;
+		_capacity = capacity;
+	}
+	_entries[_size].name = file->GetName();
+	_entries[_size].file = file;
+	++_size;
+}
+
+void ChildList::Freeze()
+{
+	if ( _frozen ) return;
+
+	// a stable sort ensures that the first of any duplicate names is the one kept
+	std::stable_sort( _entries, _entries + _size, []( const Entry &a, const Entry &b ) {
+		return std::wcscmp( a.name, b.name ) < 0;
+	} );
+	Entry *last = std::unique( _entries, _entries + _size, []( const Entry &a, const Entry &b ) {
+		return std::wcscmp( a.name, b.name ) == 0;
+	} );
+	_size = last - _entries;
+	_frozen = true;
+}
+
+IFile *ChildList::Find( const wchar_t *name ) const
+{
+	_ASSERTE( name );
+
+	if ( !_frozen ) {
+		for ( size_t i = 0; i < _size; ++i ) {
+			if ( std::wcscmp( _entries[i].name, name ) == 0 ) return _entries[i].file;
+		}
+		return nullptr;
+	}
+
+	size_t low = 0;
+	size_t high = _size;
+	while ( low < high ) {
+		size_t mid = low + ( ( high - low ) >> 1 );
+		int cmp = std::wcscmp( _entries[mid].name, name );
+		if ( cmp == 0 ) {
+			return _entries[mid].file;
+		} else if ( cmp < 0 ) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return nullptr;
+}
+
+}
+}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <MGDF/MGDFVirtualFileSystem.hpp>
+
+#include "MGDFArena.hpp"
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+/**
+the children of a vfs node. Children are added while the node is being mapped, after which the list is frozen
+into a contiguous array sorted by name. Once frozen the list never changes, so lookups are a binary search and
+enumeration is a linear scan over the array. The array is allocated from the arena as children are added, so
+the list holds nothing which needs releasing and is freed along with the arena.
+*/
+class ChildList
+{
+public:
+	struct Entry {
+		const wchar_t *name;
+		IFile *file;
+	};
+
+	ChildList( Arena *arena );
+
+	/**
+	add a child to the list, this can only be called before the list is frozen
+	*/
+	void Add( IFile *file );
+
+	/**
+	sort the children added so far by name. If more than one child has the same name, only the first one added is kept
+	*/
+	void Freeze();
+
+	bool IsFrozen() const {
+		return _frozen;
+	}
+
+	IFile *Find( const wchar_t *name ) const;
+
+	size_t Size() const {
+		_ASSERTE( _frozen );
+		return _size;
+	}
+
+	const Entry *begin() const {
+		_ASSERTE( _frozen );
+		return _entries;
+	}
+
+	const Entry *end() const {
+		_ASSERTE( _frozen );
+		return _entries + _size;
+	}
+private:
+	Arena *_arena;
+	Entry *_entries;
+	size_t _size;
+	size_t _capacity;
+	bool _frozen;
+};
+
+}
+}
+}
@@ -1,9 +1,16 @@
 #include "StdAfx.h"
 
+#include <algorithm>
 #include "../common/MGDFResources.hpp"
 #include "../common/MGDFLoggerImpl.hpp"
 #include "MGDFDefaultFileImpl.hpp"
 
+// std min&max are used instead of the macros
+#ifdef min
+#undef min
+#undef max
+#endif
+
 
 #if defined(_DEBUG)
 #define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
@@ -17,93 +24,176 @@ namespace core
 namespace vfs
 {
 
-DefaultFileImpl::DefaultFileImpl( const std::wstring &name, const std::wstring &physicalPath, IFile *parent, IErrorHandler *handler )
-	: FileBaseImpl( parent )
+DefaultFileImpl::DefaultFileImpl( const wchar_t *name, const wchar_t *physicalPath, IFile *parent, Arena *arena, IErrorHandler *handler )
+	: FileBaseImpl( parent, arena )
+	, _mapping( nullptr )
+	, _data( nullptr )
+	, _filesize( 0 )
+	, _readers( 0 )
+	, _mappableChecked( false )
+	, _mappable( false )
 	, _name( name )
 	, _path( physicalPath )
-	, _fileStream( nullptr )
 	, _errorHandler( handler )
-	, _filesize( 0 )
 {
+	_ASSERTE( name );
+	_ASSERTE( physicalPath );
 	_ASSERTE( handler );
 }
 
 DefaultFileImpl::~DefaultFileImpl( void )
 {
-	Close();
+	// any readers which are still open at this point are no longer valid
+	CloseMapping();
 }
 
-MGDFError DefaultFileImpl::Open( IFileReader **reader )
+MGDFError DefaultFileImpl::OpenReader( IFileReader **reader )
 {
 	std::lock_guard<std::mutex> lock( _mutex );
-	if ( !_fileStream ) {
-		_fileStream = new std::ifstream( _path.c_str(), std::ios::in | std::ios::binary | std::ios::ate );
-
-		if ( _fileStream && !_fileStream->bad() && _fileStream->is_open() ) {
-			_filesize = _fileStream->tellg();
-			_fileStream->seekg( 0, std::ios::beg );
-			*reader = this;
-			return MGDF_OK;
-		} else {
-			delete _fileStream;
-			_fileStream = nullptr;
-			LOG( "Unable to open file stream for " << Resources::ToString(_path) << " - " << GetLastError(), LOG_ERROR );
-			return MGDF_ERR_INVALID_FILE;
-		}
+
+	// if the file is already open without a mapping then it couldn't be mapped, so don't try again
+	if ( _data || ( !_readers && OpenMapping() ) ) {
+		++_readers;
+		*reader = new MemoryFileReader( this, _data, _filesize );
+		return MGDF_OK;
 	}
-	LOG( "File " << Resources::ToString(_path) << " currently in use", LOG_ERROR );
-	return MGDF_ERR_FILE_IN_USE;
-}
 
-void DefaultFileImpl::Close()
-{
-	std::lock_guard<std::mutex> lock( _mutex );
-	if ( _fileStream ) {
-		_fileStream->close();
-		delete _fileStream;
-		_fileStream = nullptr;
+	std::ifstream *stream = new std::ifstream( _path, std::ios::in | std::ios::binary | std::ios::ate );
+	if ( !stream->bad() && stream->is_open() ) {
+		_filesize = stream->tellg();
+		stream->seekg( 0, std::ios::beg );
+		++_readers;
+		*reader = new StreamFileReader( this, stream, _filesize );
+		return MGDF_OK;
+	} else {
+		delete stream;
+		LOG( "Unable to open file stream for " << Resources::ToString(_path) << " - " << GetLastError(), LOG_ERROR );
+		return MGDF_ERR_INVALID_FILE;
 	}
 }
 
-UINT32 DefaultFileImpl::Read( void* buffer, UINT32 length )
+MGDFError DefaultFileImpl::ReadData( void *buffer, UINT64 *length )
 {
-	if ( _fileStream && buffer && length ) {
-		std::ifstream::pos_type oldPosition = _fileStream->tellg();
-		_fileStream->read( ( char* ) buffer, length );
-		std::ifstream::pos_type newPosition = _fileStream->tellg();
-		return static_cast<UINT32>( newPosition - oldPosition );
+	const char *data = nullptr;
+	UINT64 size = 0;
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+		if ( _data ) {
+			// hold the mapping open while copying from it, without holding the lock
+			++_readers;
+			data = _data;
+			size = static_cast<UINT64>( _filesize );
+		}
+	}
+	if ( data ) {
+		MGDFError result = MGDF_OK;
+		if ( buffer ) {
+			if ( *length < size ) {
+				result = MGDF_ERR_BUFFER_TOO_SMALL;
+			} else {
+				memcpy( buffer, data, static_cast<size_t>( size ) );
+			}
+		}
+		*length = size;
+		ReleaseReader();
+		return result;
 	}
-	return 0;
-}
 
-void DefaultFileImpl::SetPosition( INT64 pos )
-{
-	if ( _fileStream ) {
-		_fileStream->seekg( pos );
+	HANDLE file = CreateFileW( _path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+	if ( file == INVALID_HANDLE_VALUE ) {
+		LOG( "Unable to open file " << Resources::ToString( _path ) << " - " << GetLastError(), LOG_ERROR );
+		return MGDF_ERR_INVALID_FILE;
+	}
+
+	MGDFError result = MGDF_OK;
+	LARGE_INTEGER fileSize;
+	if ( !GetFileSizeEx( file, &fileSize ) ) {
+		result = MGDF_ERR_INVALID_FILE;
+	} else {
+		size = static_cast<UINT64>( fileSize.QuadPart );
+		if ( buffer ) {
+			if ( *length < size ) {
+				result = MGDF_ERR_BUFFER_TOO_SMALL;
+			} else {
+				// ReadFile can only read up to 4GB at a time
+				char *destination = static_cast<char *>( buffer );
+				for ( UINT64 total = 0; total < size; ) {
+					DWORD read = 0;
+					if ( !ReadFile( file, destination + total, static_cast<DWORD>( std::min<UINT64>( size - total, MAXDWORD ) ), &read, nullptr ) || !read ) {
+						LOG( "Unable to read file " << Resources::ToString( _path ) << " - " << GetLastError(), LOG_ERROR );
+						result = MGDF_ERR_INVALID_FILE;
+						break;
+					}
+					total += read;
+				}
+			}
+		}
+		*length = size;
 	}
+	CloseHandle( file );
+	return result;
 }
 
-INT64 DefaultFileImpl::GetPosition() const
+void DefaultFileImpl::ReleaseReader()
 {
-	if ( _fileStream ) {
-		return _fileStream->tellg();
-	} else {
-		return 0;
+	std::lock_guard<std::mutex> lock( _mutex );
+	_ASSERTE( _readers );
+	if ( --_readers == 0 ) {
+		CloseMapping();
 	}
 }
 
-bool DefaultFileImpl::EndOfFile() const
+bool DefaultFileImpl::OpenMapping()
 {
-	if ( _fileStream ) {
-		return _fileStream->eof();
-	} else {
-		return true;
+	// reading a view raises an exception rather than returning an error if the file can't be paged in, which can
+	// happen at any time on removable or network media, so only files on local fixed drives are mapped
+	if ( !_mappableChecked ) {
+		wchar_t volume[MAX_PATH];
+		_mappable = GetVolumePathNameW( _path, volume, MAX_PATH ) && GetDriveTypeW( volume ) == DRIVE_FIXED;
+		_mappableChecked = true;
+	}
+	if ( !_mappable ) {
+		return false;
+	}
+
+	// other programs must still be able to save the file while it is open (e.g. so changes can be picked up by the watcher)
+	HANDLE file = CreateFileW( _path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if ( file == INVALID_HANDLE_VALUE ) {
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	// empty files can't be mapped and files larger than the address space can't be viewed in one piece
+	if ( GetFileSizeEx( file, &size ) && size.QuadPart > 0 && static_cast<UINT64>( size.QuadPart ) <= SIZE_MAX ) {
+		_mapping = CreateFileMappingW( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+		if ( _mapping ) {
+			_data = static_cast<const char *>( MapViewOfFile( _mapping, FILE_MAP_READ, 0, 0, 0 ) );
+			if ( !_data ) {
+				CloseHandle( _mapping );
+				_mapping = nullptr;
+			}
+		}
 	}
+	// the mapping keeps the file open, so the handle isn't needed any more
+	CloseHandle( file );
+
+	if ( !_data ) {
+		return false;
+	}
+	_filesize = size.QuadPart;
+	return true;
 }
 
-INT64 DefaultFileImpl::GetSize() const
+void DefaultFileImpl::CloseMapping()
 {
-	return _filesize;
+	if ( _data ) {
+		UnmapViewOfFile( _data );
+		_data = nullptr;
+	}
+	if ( _mapping ) {
+		CloseHandle( _mapping );
+		_mapping = nullptr;
+	}
 }
 
 }
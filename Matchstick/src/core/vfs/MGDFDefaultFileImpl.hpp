@@ -1,8 +1,7 @@
 #pragma once
 
-#include <iostream>
-#include <fstream>
 #include "MGDFFileBaseImpl.hpp"
+#include "MGDFFileReaderImpl.hpp"
 
 namespace MGDF
 {
@@ -11,19 +10,30 @@ namespace core
 namespace vfs
 {
 
-class DefaultFileImpl : public FileBaseImpl, public IFileReader
+/**
+the file is memory mapped when the first reader is opened and every reader shares that mapping until the
+last reader is closed. Files which can't be mapped (empty files, files too large to fit in the address
+space, or files which aren't on a local fixed drive) are read through a separate file stream for each reader instead. ReadAll copies from the mapping if
+there is one, otherwise the file is read straight into the callers buffer without mapping it.
+Files are opened allowing other programs to write to, rename and delete them while they are being read. As a
+result, readers of a mapping see writes made to the file in place, so a reader which is open while the file is being
+saved can see torn contents (part old and part new data)
+*/
+class DefaultFileImpl : public FileBaseImpl, public IFileReaderOwner
 {
 public:
-	DefaultFileImpl( const std::wstring &name, const std::wstring &physicalPath, IFile *parent, IErrorHandler *handler );
+	/**
+	the name and physical path are not copied, so they must live at least as long as the file
+	(i.e. they should be allocated from the same arena as the file)
+	*/
+	DefaultFileImpl( const wchar_t *name, const wchar_t *physicalPath, IFile *parent, Arena *arena, IErrorHandler *handler );
 	virtual ~DefaultFileImpl();
 
 	bool IsOpen() const override final {
 		std::lock_guard<std::mutex> lock( _mutex );
-		return ( _fileStream != nullptr );
+		return _readers > 0;
 	}
 
-	MGDFError Open( IFileReader **reader ) override final;
-
 	bool IsFolder() const override final {
 		return false;
 	}
@@ -34,24 +44,29 @@ public:
 		return nullptr;
 	}
 	const wchar_t *GetPhysicalPath() const override final {
-		return _path.c_str();
+		return _path;
 	}
 	const wchar_t *GetName() const override final {
-		return _name.c_str();
+		return _name;
 	}
-	
-	void Close() override final;
-	UINT32 Read( void* buffer, UINT32 length ) override final;
-	void SetPosition( INT64 pos ) override final;
-	INT64 GetPosition() const override final;
-	bool EndOfFile() const override final;
-	INT64 GetSize() const override final;
 
+	void ReleaseReader() override final;
+
+protected:
+	MGDFError OpenReader( IFileReader **reader ) override final;
+	MGDFError ReadData( void *buffer, UINT64 *length ) override final;
 private:
-	std::ifstream *_fileStream;
+	bool OpenMapping();
+	void CloseMapping();
+
+	HANDLE _mapping;
+	const char *_data;
 	INT64 _filesize;
-	std::wstring _name;
-	std::wstring _path;
+	UINT32 _readers;
+	bool _mappableChecked;
+	bool _mappable;
+	const wchar_t *_name;
+	const wchar_t *_path;
 	IErrorHandler *_errorHandler;
 };
 
@@ -16,8 +16,8 @@ namespace core
 namespace vfs
 {
 
-DefaultFolderImpl::DefaultFolderImpl( const std::wstring &name, const std::wstring &physicalPath, IFile *parent, VirtualFileSystemComponent *vfs )
-	: FolderBaseImpl( name, physicalPath, parent )
+DefaultFolderImpl::DefaultFolderImpl( const wchar_t *name, const wchar_t *physicalPath, IFile *parent, Arena *arena, VirtualFileSystemComponent *vfs )
+	: FolderBaseImpl( name, physicalPath, parent, arena )
 	, _vfs( vfs )
 {
 	_ASSERTE( vfs );
@@ -25,45 +25,50 @@ DefaultFolderImpl::DefaultFolderImpl( const std::wstring &name, const std::wstri
 
 DefaultFolderImpl::~DefaultFolderImpl()
 {
-	if ( !_children ) return;
+	// children are owned by the mounts arena, or in the case of archives
+	// are passed back to the archive handler that created them to clean up
+}
+
+const ChildList *DefaultFolderImpl::MapChildren() const
+{
+	const ChildList *children = GetMappedChildren();
+	if ( children ) return children;
 
-	for ( auto child : *_children ) {
-		// don't delete archives as we will explicitly pass them off to
-		// the archive handler that created them in order to clean them up
-		if ( !child.second->IsArchive() ) {
-			delete static_cast<FileBaseImpl *>( child.second );
-		}
+	// the children are built privately and only published once frozen, so other threads never see a partial list
+	std::lock_guard<std::mutex> lock( _mutex );
+	children = _children.load( std::memory_order_relaxed );
+	if ( !children ) {
+		auto mapped = _arena->New<ChildList>( _arena );
+		_vfs->MapChildren( const_cast<DefaultFolderImpl *>( this ), *mapped );
+		mapped->Freeze();
+		PublishChildren( mapped );
+		children = mapped;
 	}
+	return children;
 }
 
-void DefaultFolderImpl::MapChildren()
+void DefaultFolderImpl::ReplaceChildren( ChildList *children )
 {
+	_ASSERTE( children && children->IsFrozen() );
 	std::lock_guard<std::mutex> lock( _mutex );
-	if ( !_children ) {
-		auto children = new std::map<const wchar_t *, IFile *, WCharCmp>();
-		_vfs->MapChildren( this, *children );
-		_children = children;
-	}
+	PublishChildren( children );
 }
 
 IFile *DefaultFolderImpl::GetChild( const wchar_t *name ) const
 {
 	if ( !name ) return nullptr;
 
-	const_cast<DefaultFolderImpl *>(this)->MapChildren();
-	return FolderBaseImpl::GetChild( name );
+	return MapChildren()->Find( name );
 }
 
 size_t DefaultFolderImpl::GetChildCount()  const
 {
-	const_cast<DefaultFolderImpl *>(this)->MapChildren();
-	return FolderBaseImpl::GetChildCount();
+	return MapChildren()->Size();
 }
 
 bool DefaultFolderImpl::GetAllChildren( const IFileFilter *filter, IFile **childBuffer, size_t *bufferLength )  const
 {
-	const_cast<DefaultFolderImpl *>(this)->MapChildren();
-	return FolderBaseImpl::GetAllChildren( filter, childBuffer, bufferLength );
+	return CopyChildren( MapChildren(), filter, childBuffer, bufferLength );
 }
 
 }
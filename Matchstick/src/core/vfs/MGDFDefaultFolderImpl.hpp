@@ -18,17 +18,27 @@ that time.
 class DefaultFolderImpl : public FolderBaseImpl
 {
 public:
-	DefaultFolderImpl( const std::wstring &name, const std::wstring &physicalPath, IFile *parent, VirtualFileSystemComponent *vfs );
+	DefaultFolderImpl( const wchar_t *name, const wchar_t *physicalPath, IFile *parent, Arena *arena, VirtualFileSystemComponent *vfs );
 	virtual ~DefaultFolderImpl( void );
 
 	IFile *GetChild( const wchar_t *name ) const override final;
 	size_t GetChildCount() const override final;
 	bool GetAllChildren( const IFileFilter *filter, IFile **childBuffer, size_t *bufferLength ) const override final;
+
+	/**
+	replace the children of the folder after its contents have changed. The previous children are owned by the arena
+	so they remain valid for any thread which is still using them
+	*/
+	void ReplaceChildren( ChildList *children );
 private:
 	VirtualFileSystemComponent *_vfs;
 	IFileFilter *_filter;
 
-	void MapChildren();
+	/**
+	map the children if they haven't been mapped yet
+	\return the published children of the folder
+	*/
+	const ChildList *MapChildren() const;
 };
 
 }
@@ -0,0 +1,108 @@
+#include "StdAfx.h"
+
+#include "MGDFEntryCache.hpp"
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+EntryCache::EntryCache( size_t budget )
+	: _budget( budget )
+	, _size( 0 )
+	, _hits( 0 )
+	, _misses( 0 )
+	, _evictions( 0 )
+{
+}
+
+EntryCache::Data EntryCache::Find( const IFile *archive, UINT64 entry )
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	auto it = _index.find( Key { archive, entry } );
+	if ( it == _index.end() ) {
+		++_misses;
+		return nullptr;
+	}
+	++_hits;
+	// move the entry to the front of the list as it is now the most recently used
+	_entries.splice( _entries.begin(), _entries, it->second );
+	return it->second->data;
+}
+
+void EntryCache::Insert( const IFile *archive, UINT64 entry, const Data &data, size_t size )
+{
+	_ASSERTE( archive );
+	if ( size > _budget ) return;
+
+	const Key key { archive, entry };
+	std::lock_guard<std::mutex> lock( _mutex );
+	if ( _index.find( key ) != _index.end() ) return;
+
+	while ( _size + size > _budget && !_entries.empty() ) {
+		CacheEntry &last = _entries.back();
+		_size -= last.size;
+		_index.erase( last.key );
+		_entries.pop_back();
+		++_evictions;
+	}
+
+	CacheEntry cacheEntry;
+	cacheEntry.key = key;
+	cacheEntry.data = data;
+	cacheEntry.size = size;
+	_entries.push_front( cacheEntry );
+	_index.insert( std::make_pair( key, _entries.begin() ) );
+	_size += size;
+}
+
+void EntryCache::Remove( const IFile *archive )
+{
+	// archives are only unmapped when content changes, so scanning every entry is cheap enough
+	std::lock_guard<std::mutex> lock( _mutex );
+	for ( auto it = _entries.begin(); it != _entries.end(); ) {
+		if ( it->key.archive == archive ) {
+			_size -= it->size;
+			_index.erase( it->key );
+			it = _entries.erase( it );
+		} else {
+			++it;
+		}
+	}
+}
+
+size_t EntryCache::GetSize() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return _size;
+}
+
+size_t EntryCache::GetHits() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return _hits;
+}
+
+size_t EntryCache::GetMisses() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return _misses;
+}
+
+size_t EntryCache::GetEvictions() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return _evictions;
+}
+
+}
+}
+}
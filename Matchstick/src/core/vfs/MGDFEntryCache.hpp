@@ -0,0 +1,101 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+#include <MGDF/MGDF.hpp>
+#include <MGDF/MGDFVirtualFileSystem.hpp>
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+/**
+a cache of the decompressed contents of archive entries, shared by every archive mounted in the vfs. Entries are
+keyed by the root of the archive they belong to and thier index within that archive, and the least recently used
+entries are evicted once the total size of the cached entries exceeds the budget. The cached data is reference counted, so evicting an entry which
+is still being read only removes it from the cache
+*/
+class EntryCache
+{
+public:
+	typedef std::shared_ptr<char> Data;
+
+	EntryCache( size_t budget );
+	virtual ~EntryCache() {}
+
+	/**
+	get the cached contents of an entry, or nullptr if the entry is not in the cache
+	*/
+	Data Find( const IFile *archive, UINT64 entry );
+
+	/**
+	add the contents of an entry to the cache, evicting the least recently used entries to make room for it.
+	Entries larger than the whole budget are not cached
+	*/
+	void Insert( const IFile *archive, UINT64 entry, const Data &data, size_t size );
+
+	/**
+	remove every entry of an archive from the cache. This must be called once an archive is no longer mapped, as
+	its entries can never be found again and the address of its root may be reused by another archive
+	*/
+	void Remove( const IFile *archive );
+
+	size_t GetBudget() const {
+		return _budget;
+	}
+	size_t GetSize() const;
+	size_t GetHits() const;
+	size_t GetMisses() const;
+	size_t GetEvictions() const;
+private:
+	struct Key {
+		const IFile *archive;
+		UINT64 entry;
+
+		bool operator==( const Key &other ) const {
+			return archive == other.archive && entry == other.entry;
+		}
+	};
+
+	struct KeyHash {
+		size_t operator()( const Key &key ) const {
+			return std::hash<const IFile *>()( key.archive ) ^ ( std::hash<UINT64>()( key.entry ) * 1099511628211ULL );
+		}
+	};
+
+	struct CacheEntry {
+		Key key;
+		Data data;
+		size_t size;
+	};
+
+	mutable std::mutex _mutex;
+	std::list<CacheEntry> _entries; // most recently used first
+	std::unordered_map<Key, std::list<CacheEntry>::iterator, KeyHash> _index;
+	size_t _budget;
+	size_t _size;
+	size_t _hits;
+	size_t _misses;
+	size_t _evictions;
+};
+
+/**
+implemented by archive handlers which are able to cache the decompressed contents of thier entries
+*/
+class ICachingArchiveHandler
+{
+public:
+	/**
+	set the cache used by any archives mapped afterwards, or nullptr to disable caching
+	*/
+	virtual void SetEntryCache( EntryCache *cache ) = 0;
+};
+
+}
+}
+}
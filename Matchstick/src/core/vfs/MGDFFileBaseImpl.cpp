@@ -1,7 +1,6 @@
 #include "StdAfx.h"
 
 #include <vector>
-#include <filesystem>
 #include <sstream>
 #include <algorithm>
 
@@ -9,8 +8,14 @@
 #include "../common/MGDFResources.hpp"
 
 #include "MGDFFileBaseImpl.hpp"
+#include "MGDFAccessTrace.hpp"
 
 
+// the offset between the filesystem epoch (1601) and the time_t epoch (1970) in 100ns intervals
+#define FILE_TIME_EPOCH 116444736000000000LL
+#define FILE_TIME_TICKS_PER_SECOND 10000000LL
+#define UNKNOWN_METADATA -1
+
 #if defined(_DEBUG)
 #define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
 #pragma warning(disable:4291)
@@ -23,65 +28,163 @@ namespace core
 namespace vfs
 {
 
-FileBaseImpl::FileBaseImpl( IFile *parent )
-	: _parent( parent )
-	, _children( nullptr )
+FileBaseImpl::FileBaseImpl( IFile *parent, Arena *arena )
+	: _children( nullptr )
+	, _logicalPath( nullptr )
+	, _size( UNKNOWN_METADATA )
+	, _lastWriteTime( UNKNOWN_METADATA )
+	, _parent( parent )
+	, _arena( arena )
 {
+	_ASSERTE( arena );
 }
 
 FileBaseImpl::~FileBaseImpl()
 {
-	delete _children;
+	// the children and any cached strings are owned by the arena
 }
 
 time_t FileBaseImpl::GetLastWriteTime() const
 {
-	std::experimental::filesystem::path path( GetPhysicalPath() );
-	try {
-		return std::experimental::filesystem::file_time_type::clock::to_time_t(std::experimental::filesystem::last_write_time(path));
+	time_t lastWriteTime = _lastWriteTime.load( std::memory_order_relaxed );
+	if ( lastWriteTime == UNKNOWN_METADATA ) {
+		LoadMetadata();
+		lastWriteTime = _lastWriteTime.load( std::memory_order_relaxed );
 	}
-	catch (const std::experimental::filesystem::filesystem_error &err) {
-		LOG( "Unable to get last write time for " << Resources::ToString(GetPhysicalPath()) << " - " << err.what(), LOG_ERROR );
-		return 0;
+	return lastWriteTime;
+}
+
+INT64 FileBaseImpl::GetSize() const
+{
+	INT64 size = _size.load( std::memory_order_relaxed );
+	if ( size == UNKNOWN_METADATA ) {
+		LoadMetadata();
+		size = _size.load( std::memory_order_relaxed );
+	}
+	return size;
+}
+
+void FileBaseImpl::SetMetadata( INT64 size, INT64 fileTime )
+{
+	_size.store( size, std::memory_order_relaxed );
+	_lastWriteTime.store( FileTimeToTime( fileTime ), std::memory_order_relaxed );
+}
+
+void FileBaseImpl::InvalidateMetadata()
+{
+	_size.store( UNKNOWN_METADATA, std::memory_order_relaxed );
+	_lastWriteTime.store( UNKNOWN_METADATA, std::memory_order_relaxed );
+}
+
+void FileBaseImpl::LoadMetadata() const
+{
+	// if more than one thread gets here at once they all read the same values, so there is no need to lock
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if ( GetFileAttributesExW( GetPhysicalPath(), GetFileExInfoStandard, &data ) ) {
+		const bool isFolder = ( data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) != 0;
+		_size.store( isFolder ? 0 : ( static_cast<INT64>( data.nFileSizeHigh ) << 32 ) | data.nFileSizeLow, std::memory_order_relaxed );
+		_lastWriteTime.store( FileTimeToTime( ( static_cast<INT64>( data.ftLastWriteTime.dwHighDateTime ) << 32 ) | data.ftLastWriteTime.dwLowDateTime ), std::memory_order_relaxed );
+	} else {
+		LOG( "Unable to get the size and last write time of " << Resources::ToString( GetPhysicalPath() ) << " - " << GetLastError(), LOG_ERROR );
+		_size.store( 0, std::memory_order_relaxed );
+		_lastWriteTime.store( 0, std::memory_order_relaxed );
 	}
 }
 
+time_t FileBaseImpl::FileTimeToTime( INT64 fileTime )
+{
+	return fileTime > FILE_TIME_EPOCH ? static_cast<time_t>( ( fileTime - FILE_TIME_EPOCH ) / FILE_TIME_TICKS_PER_SECOND ) : 0;
+}
+
 IFile *FileBaseImpl::GetChild( const wchar_t * name ) const
 {
 	if ( !name ) return nullptr;
 
-	{
-		std::lock_guard<std::mutex> lock( _mutex );
-		if ( !_children ) return nullptr;
+	const ChildList *children = GetMappedChildren();
+	return children ? children->Find( name ) : nullptr;
+}
+
+MGDFError FileBaseImpl::Open( IFileReader **reader )
+{
+	MGDFError result = OpenReader( reader );
+	if ( result == MGDF_OK ) {
+		AccessTrace::TraceOpen( this, reader );
+	}
+	return result;
+}
+
+MGDFError FileBaseImpl::OpenUnbuffered( IFileReader **reader )
+{
+	MGDFError result = OpenUnbufferedReader( reader );
+	if ( result == MGDF_OK ) {
+		AccessTrace::TraceOpen( this, reader );
+	}
+	return result;
+}
+
+MGDFError FileBaseImpl::ReadAll( void *buffer, UINT64 *length )
+{
+	if ( !length ) {
+		return MGDF_ERR_INVALID_PARAMETER;
 	}
+	MGDFError result = ReadData( buffer, length );
+	if ( result == MGDF_OK && buffer ) {
+		AccessTrace::TraceReadAll( this, *length );
+	}
+	return result;
+}
 
-	auto it = _children->find( name );
-	if ( it != _children->end() ) {
-		return it->second;
+MGDFError FileBaseImpl::ReadData( void *buffer, UINT64 *length )
+{
+	IFileReader *reader = nullptr;
+	MGDFError result = OpenUnbufferedReader( &reader );
+	if ( result != MGDF_OK ) {
+		return result;
+	}
+
+	const UINT64 size = static_cast<UINT64>( reader->GetSize() );
+	if ( buffer ) {
+		if ( *length < size ) {
+			result = MGDF_ERR_BUFFER_TOO_SMALL;
+		} else if ( reader->Read( buffer, size ) != size ) {
+			result = MGDF_ERR_INVALID_FILE;
+		}
 	}
-	return nullptr;
+	*length = size;
+	reader->Close();
+	return result;
 }
 
 bool FileBaseImpl::GetAllChildren( const IFileFilter *filter, IFile **childBuffer, size_t *bufferLength ) const
+{
+	return CopyChildren( GetMappedChildren(), filter, childBuffer, bufferLength );
+}
+
+bool FileBaseImpl::CopyChildren( const ChildList *children, const IFileFilter *filter, IFile **childBuffer, size_t *bufferLength )
 {
 	if ( !bufferLength ) {
-		*bufferLength = 0;
 		return false;
 	}
 
-	{
-		std::lock_guard<std::mutex> lock( _mutex );
-		if ( !_children ) {
-			*bufferLength = 0;
-			return false;
-		}
+	if ( !children ) {
+		*bufferLength = 0;
+		return false;
 	}
 
 	size_t size = 0;
-	for ( auto it = _children->begin(); it != _children->end(); ++it ) {
-		if ( !filter || filter->Accept( it->first ) ) {
-			if ( size < *bufferLength ) childBuffer[size] = it->second;
-			++size;
+	if ( !filter ) {
+		size = children->Size();
+		const size_t count = std::min( size, *bufferLength );
+		auto it = children->begin();
+		for ( size_t i = 0; i < count; ++i, ++it ) {
+			childBuffer[i] = it->file;
+		}
+	} else {
+		for ( auto &child : *children ) {
+			if ( filter->Accept( child.name ) ) {
+				if ( size < *bufferLength ) childBuffer[size] = child.file;
+				++size;
+			}
 		}
 	}
 
@@ -93,17 +196,33 @@ bool FileBaseImpl::GetAllChildren( const IFileFilter *filter, IFile **childBuffe
 void FileBaseImpl::AddChild( IFile *file )
 {
 	_ASSERTE( file );
-	if ( !_children ) {
-		_children = new std::map<const wchar_t *, IFile *, WCharCmp>();
+	// the file isn't visible to any other thread yet, so the list can be built in place
+	ChildList *children = _children.load( std::memory_order_relaxed );
+	if ( !children ) {
+		children = _arena->New<ChildList>( _arena );
+		_children.store( children, std::memory_order_relaxed );
+	}
+	children->Add( file );
+}
+
+void FileBaseImpl::FreezeChildren()
+{
+	ChildList *children = _children.load( std::memory_order_relaxed );
+	if ( children ) {
+		children->Freeze();
+		PublishChildren( children );
 	}
-	_children->insert( std::pair<const wchar_t *, IFile *> ( file->GetName(), file ) );
 }
 
 const wchar_t *FileBaseImpl::GetLogicalPath() const
 {
 	std::lock_guard<std::mutex> lock( _mutex );
 
-	if ( _logicalPath.empty() && this->GetParent() ) {
+	if ( !_logicalPath ) {
+		if ( !this->GetParent() ) {
+			return L"";
+		}
+
 		std::vector<const IFile *> path;
 		const IFile *node = this;
 		while ( node ) {
@@ -116,10 +235,10 @@ const wchar_t *FileBaseImpl::GetLogicalPath() const
 			ss << ( *it )->GetName();
 			if ( ( *it ) != this ) ss << '/';
 		}
-		_logicalPath = ss.str();
+		_logicalPath = _arena->Copy( ss.str() );
 	}
 
-	return _logicalPath.c_str();
+	return _logicalPath;
 }
 
 }
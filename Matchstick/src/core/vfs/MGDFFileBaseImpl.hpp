@@ -1,10 +1,13 @@
 #pragma once
 
+#include <atomic>
 #include <mutex>
 #include <string>
-#include <map>
 #include <MGDF/MGDFVirtualFileSystem.hpp>
 
+#include "MGDFArena.hpp"
+#include "MGDFChildList.hpp"
+
 namespace MGDF
 {
 namespace core
@@ -12,12 +15,6 @@ namespace core
 namespace vfs
 {
 
-struct WCharCmp {
-	bool operator()( const wchar_t *a, const wchar_t *b ) const {
-		return std::wcscmp( a, b ) < 0;
-	}
-};
-
 /**
  abstract class which contains the common functionality to default file instances aswell as the zip and other archive file implementations
  of the standard ifile interface
@@ -25,7 +22,7 @@ struct WCharCmp {
 class FileBaseImpl : public IFile
 {
 public:
-	FileBaseImpl( IFile *parent );
+	FileBaseImpl( IFile *parent, Arena *arena );
 	virtual ~FileBaseImpl();
 
 	IFile *GetParent() const override final {
@@ -33,14 +30,16 @@ public:
 	}
 	IFile *GetChild( const wchar_t *name ) const override;
 
+	/**
+	open a reader on the file, recording the open in the access trace if one is recording
+	*/
+	MGDFError Open( IFileReader **reader ) override final;
+	MGDFError OpenUnbuffered( IFileReader **reader ) override final;
+	MGDFError ReadAll( void *buffer, UINT64 *length ) override final;
+
 	size_t GetChildCount() const override {
-		if ( !_children ) {
-			std::lock_guard<std::mutex> lock( _mutex );
-			if ( !_children ) {
-				return 0;
-			}
-		}
-		return _children->size();
+		const ChildList *children = GetMappedChildren();
+		return children ? children->Size() : 0;
 	}
 
 	bool GetAllChildren( const IFileFilter *filter, IFile **childBuffer, size_t *bufferLength ) const override;
@@ -51,18 +50,75 @@ public:
 
 	const wchar_t* GetLogicalPath() const override final; 
 	time_t GetLastWriteTime() const override;
+	INT64 GetSize() const override;
+
+	/**
+	record the size and last write time found when the file was enumerated, so they can be returned without touching the disk.
+	Files which are never given thier metadata read it from disk the first time it is needed
+	\param fileTime the last write time in 100ns intervals since 1601, as reported by the filesystem
+	*/
+	void SetMetadata( INT64 size, INT64 fileTime );
+
+	/**
+	discard the recorded size and last write time once the file has changed on disk
+	*/
+	void InvalidateMetadata();
+
+	/**
+	convert a filesystem timestamp in 100ns intervals since 1601 to a time_t
+	*/
+	static time_t FileTimeToTime( INT64 fileTime );
 
 	// These internal methods are not threadsafe, so ensure 
-	// that the mutex for this file is acquired or that only
-	// one thread can access the file before calling
+	// that only one thread can access the file before calling.
+	// The children added are published by FreezeChildren
 	void AddChild( IFile *newNode );
-	void SetParent( IFile *file );
+	void FreezeChildren();
+
+	/**
+	get the children of the file without mapping them
+	\return the children, or nullptr if the file has no children or they haven't been mapped yet
+	*/
+	const ChildList *GetMappedChildren() const {
+		return _children.load( std::memory_order_acquire );
+	}
 protected:
-	mutable std::mutex _mutex;
-	mutable std::map<const wchar_t *, IFile *, WCharCmp> *_children;
-	mutable std::wstring _logicalPath;
+	virtual MGDFError OpenReader( IFileReader **reader ) = 0;
+
+	/**
+	open a reader which reads straight into the callers buffer, files which don't keep a decompressed copy of thier data open a normal reader
+	*/
+	virtual MGDFError OpenUnbufferedReader( IFileReader **reader ) {
+		return OpenReader( reader );
+	}
+
+	/**
+	get the size of the file, and read the whole file into the buffer if there is one which is large enough. By default the
+	file is read through an unbuffered reader
+	*/
+	virtual MGDFError ReadData( void *buffer, UINT64 *length );
+
+	/**
+	make a frozen list of children visible to other threads. Once published a list never changes, so readers
+	only need to load the pointer to use it without taking any locks
+	*/
+	void PublishChildren( ChildList *children ) const {
+		_ASSERTE( !children || children->IsFrozen() );
+		_children.store( children, std::memory_order_release );
+	}
+
+	static bool CopyChildren( const ChildList *children, const IFileFilter *filter, IFile **childBuffer, size_t *bufferLength );
+
+	void LoadMetadata() const;
+
+	mutable std::mutex _mutex; // serializes mapping the children, and guards the logical path
+	mutable std::atomic<ChildList *> _children;
+	mutable const wchar_t *_logicalPath;
+	mutable std::atomic<INT64> _size; // -1 until known
+	mutable std::atomic<time_t> _lastWriteTime; // -1 until known
 
 	IFile *_parent;
+	Arena *_arena;
 };
 
 
@@ -0,0 +1,142 @@
+#include "StdAfx.h"
+
+#include <algorithm>
+#include "MGDFFileQueryImpl.hpp"
+#include "MGDFFileBaseImpl.hpp"
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+FileQueryImpl::FileQueryImpl( const IVirtualFileSystem *vfs, const GlobPattern &pattern )
+	: _pattern( pattern )
+	, _ambiguous( pattern.IsAmbiguous() )
+{
+	_ASSERTE( vfs );
+
+	//the literal prefix of the pattern is resolved with a single lookup, rather than matched a segment at a time
+	const size_t prefixLength = _pattern.GetLiteralPrefixLength();
+	std::wstring prefix;
+	for ( size_t i = 0; i < prefixLength; ++i ) {
+		if ( i ) prefix += L'/';
+		prefix += _pattern.GetSegments()[i].text;
+	}
+
+	IFile *start = prefixLength ? vfs->GetFile( prefix.c_str() ) : vfs->GetRoot();
+	if ( start ) {
+		Push( start, prefixLength );
+	}
+}
+
+void FileQueryImpl::Dispose()
+{
+	delete this;
+}
+
+IFile *FileQueryImpl::Next()
+{
+	const std::vector<GlobPattern::Segment> &segments = _pattern.GetSegments();
+
+	while ( !_stack.empty() ) {
+		State state = _stack.back();
+		_stack.pop_back();
+
+		if ( state.segment == segments.size() ) {
+			if ( !_ambiguous || _matched.insert( state.file ).second ) {
+				return state.file;
+			}
+			continue;
+		}
+
+		const GlobPattern::Segment &segment = segments[state.segment];
+		switch ( segment.type ) {
+		case GlobPattern::LITERAL: {
+			IFile *child = state.file->GetChild( segment.text.c_str() );
+			if ( child ) Push( child, state.segment + 1 );
+		}
+		break;
+
+		case GlobPattern::WILDCARD:
+			PushChildren( state.file, state.segment, false );
+			break;
+
+		case GlobPattern::RECURSIVE:
+			//descend into every child still matching the **, and also try the rest of the pattern against this
+			//file (which is pushed last so that it is matched before its descendants). A ** at the end of the
+			//pattern only matches what is inside the folder, so the folder itself isn't a match
+			PushChildren( state.file, state.segment, true );
+			if ( state.segment + 1 < segments.size() ) {
+				Push( state.file, state.segment + 1 );
+			}
+			break;
+		}
+	}
+	return nullptr;
+}
+
+void FileQueryImpl::Push( IFile *file, size_t segment )
+{
+	if ( !_ambiguous || _visited.insert( std::make_pair( file, segment ) ).second ) {
+		State state;
+		state.file = file;
+		state.segment = segment;
+		_stack.push_back( state );
+	}
+}
+
+void FileQueryImpl::PushChildren( IFile *file, size_t segment, bool matchAll )
+{
+	// a ** segment stays on the same segment as it descends, anything else moves on to the next segment
+	const size_t next = matchAll ? segment : segment + 1;
+	const wchar_t *text = _pattern.GetSegments()[segment].text.c_str();
+	const size_t start = _stack.size();
+
+	// everything beneath a ** at the end of the pattern is a match, as well as being searched for more matches.
+	// The match is pushed first so that once the children are reversed it is returned before its descendants
+	const bool matchChildren = matchAll && segment + 1 == _pattern.GetSegments().size();
+	auto push = [this, next, matchChildren]( IFile *child ) {
+		if ( matchChildren ) Push( child, next + 1 );
+		Push( child, next );
+	};
+
+	// getting the child count maps the children if they haven't been mapped yet
+	size_t length = file->GetChildCount();
+	if ( !length ) return;
+
+	//the children of vfs nodes can be matched directly against their sorted child array, other nodes
+	//(e.g. from third party archive handlers) have to be enumerated through the public interface
+	const FileBaseImpl *base = dynamic_cast<const FileBaseImpl *>( file );
+	const ChildList *children = base ? base->GetMappedChildren() : nullptr;
+	if ( children ) {
+		for ( auto &child : *children ) {
+			if ( matchAll || GlobPattern::Match( text, child.name ) ) {
+				push( child.file );
+			}
+		}
+	} else {
+		std::vector<IFile *> buffer( length );
+		if ( file->GetAllChildren( nullptr, buffer.data(), &length ) ) {
+			for ( size_t i = 0; i < length; ++i ) {
+				if ( matchAll || GlobPattern::Match( text, buffer[i]->GetName() ) ) {
+					push( buffer[i] );
+				}
+			}
+		}
+	}
+
+	//the stack is popped from the back, so the children are reversed to return matches in name order
+	std::reverse( _stack.begin() + start, _stack.end() );
+}
+
+}
+}
+}
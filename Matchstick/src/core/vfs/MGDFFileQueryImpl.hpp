@@ -0,0 +1,58 @@
+#pragma once
+
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <MGDF/MGDF.hpp>
+#include <MGDF/MGDFVirtualFileSystem.hpp>
+
+#include "MGDFGlobPattern.hpp"
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+/**
+a query over the vfs which walks the tree depth first, matching one pattern segment per level. Only the literal
+prefix of the pattern is looked up (using the path index if it is enabled), literal segments after that are looked
+up by name, and only folders which could contain a match are visited, so whole subtrees are pruned without being mapped
+*/
+class FileQueryImpl : public IFileQuery
+{
+public:
+	FileQueryImpl( const IVirtualFileSystem *vfs, const GlobPattern &pattern );
+	virtual ~FileQueryImpl() {}
+
+	IFile *Next() override final;
+	void Dispose() override final;
+private:
+	struct State {
+		IFile *file;
+		size_t segment; // the next segment of the pattern to match against the children of file
+	};
+
+	struct StateHash {
+		size_t operator()( const std::pair<IFile *, size_t> &state ) const {
+			return std::hash<IFile *>()( state.first ) ^ ( state.second * 0x9e3779b9 );
+		}
+	};
+
+	void PushChildren( IFile *file, size_t segment, bool matchAll );
+	void Push( IFile *file, size_t segment );
+
+	GlobPattern _pattern;
+	std::vector<State> _stack;
+
+	// patterns with more than one ** can reach the same file in more than one way, so the states visited and files
+	// matched are tracked to avoid walking the same subtree twice or returning the same file twice
+	bool _ambiguous;
+	std::unordered_set<std::pair<IFile *, size_t>, StateHash> _visited;
+	std::unordered_set<IFile *> _matched;
+};
+
+}
+}
+}
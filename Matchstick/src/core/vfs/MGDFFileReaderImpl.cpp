@@ -0,0 +1,143 @@
+#include "StdAfx.h"
+
+#include <algorithm>
+#include "MGDFFileReaderImpl.hpp"
+
+// std min&max are used instead of the macros
+#ifdef min
+#undef min
+#undef max
+#endif
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+void SortRanges( ReadRange *ranges, UINT32 count, std::vector<ReadRange *> &sorted )
+{
+	sorted.resize( count );
+	for ( UINT32 i = 0; i < count; ++i ) {
+		sorted[i] = &ranges[i];
+	}
+	std::stable_sort( sorted.begin(), sorted.end(), []( const ReadRange * a, const ReadRange * b ) {
+		return a->offset < b->offset;
+	} );
+}
+
+MemoryFileReader::MemoryFileReader( IFileReaderOwner *owner, const char *data, INT64 size )
+	: _owner( owner )
+	, _data( data )
+	, _size( size )
+	, _position( 0 )
+{
+	_ASSERTE( owner );
+	_ASSERTE( data || !size );
+}
+
+void MemoryFileReader::Close()
+{
+	_owner->ReleaseReader();
+	delete this;
+}
+
+UINT64 MemoryFileReader::Read( void* buffer, UINT64 length )
+{
+	if ( !buffer || _position >= _size ) {
+		return 0;
+	}
+	UINT64 read = std::min<UINT64>( length, static_cast<UINT64>( _size - _position ) );
+	memcpy( buffer, _data + _position, static_cast<size_t>( read ) );
+	_position += static_cast<INT64>( read );
+	return read;
+}
+
+UINT64 MemoryFileReader::ReadMany( ReadRange *ranges, UINT32 count )
+{
+	// every range is copied straight out of the buffer, so the order they are read in doesn't matter
+	UINT64 total = 0;
+	for ( UINT32 i = 0; i < count; ++i ) {
+		ReadRange &range = ranges[i];
+		const INT64 offset = std::max<INT64>( 0, range.offset );
+		range.read = 0;
+		if ( range.buffer && offset < _size ) {
+			range.read = std::min<UINT64>( range.length, static_cast<UINT64>( _size - offset ) );
+			memcpy( range.buffer, _data + offset, static_cast<size_t>( range.read ) );
+			total += range.read;
+		}
+	}
+	return total;
+}
+
+void MemoryFileReader::SetPosition( INT64 pos )
+{
+	_position = pos < 0 ? 0 : pos;
+}
+
+StreamFileReader::StreamFileReader( IFileReaderOwner *owner, std::ifstream *stream, INT64 size )
+	: _owner( owner )
+	, _stream( stream )
+	, _size( size )
+	, _position( 0 )
+{
+	_ASSERTE( owner );
+	_ASSERTE( stream );
+}
+
+StreamFileReader::~StreamFileReader()
+{
+	_stream->close();
+	delete _stream;
+}
+
+void StreamFileReader::Close()
+{
+	_owner->ReleaseReader();
+	delete this;
+}
+
+UINT64 StreamFileReader::Read( void* buffer, UINT64 length )
+{
+	if ( !buffer || !length ) {
+		return 0;
+	}
+	_stream->read( ( char* ) buffer, static_cast<std::streamsize>( length ) );
+	UINT64 read = static_cast<UINT64>( _stream->gcount() );
+	_position += static_cast<INT64>( read );
+	return read;
+}
+
+UINT64 StreamFileReader::ReadMany( ReadRange *ranges, UINT32 count )
+{
+	std::vector<ReadRange *> sorted;
+	SortRanges( ranges, count, sorted );
+
+	// ranges which follow on from the previous range are read without seeking
+	UINT64 total = 0;
+	for ( auto range : sorted ) {
+		if ( range->offset != _position ) {
+			SetPosition( range->offset );
+		}
+		range->read = Read( range->buffer, range->length );
+		total += range->read;
+	}
+	return total;
+}
+
+void StreamFileReader::SetPosition( INT64 pos )
+{
+	_stream->clear();
+	_stream->seekg( pos );
+	_position = _stream->tellg();
+}
+
+}
+}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <fstream>
+#include <vector>
+#include <MGDF/MGDFVirtualFileSystem.hpp>
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+/**
+implemented by files which hand out a separate reader for each call to Open. Readers call ReleaseReader
+when they are closed, so the file can free any state shared between its readers once the last one is closed
+*/
+class IFileReaderOwner
+{
+public:
+	virtual void ReleaseReader() = 0;
+};
+
+/**
+sort the ranges of a ReadMany call into offset order, without reordering the callers array
+*/
+void SortRanges( ReadRange *ranges, UINT32 count, std::vector<ReadRange *> &sorted );
+
+/**
+reads from a buffer which is owned by the file (a memory mapping or a decompressed archive entry). Any number
+of these readers can share the same buffer, each with its own position
+*/
+class MemoryFileReader : public IFileReader, public IFileView
+{
+public:
+	MemoryFileReader( IFileReaderOwner *owner, const char *data, INT64 size );
+	virtual ~MemoryFileReader() {}
+
+	void Close() override final;
+	UINT64 Read( void* buffer, UINT64 length ) override final;
+	UINT64 ReadMany( ReadRange *ranges, UINT32 count ) override final;
+	void SetPosition( INT64 pos ) override final;
+	INT64 GetPosition() const override final {
+		return _position;
+	}
+	bool EndOfFile() const override final {
+		return _position >= _size;
+	}
+	INT64 GetSize() const override final {
+		return _size;
+	}
+	const IFileView *GetView() override final {
+		return this;
+	}
+
+	const void *GetData() const override final {
+		return _data;
+	}
+	INT64 GetDataSize() const override final {
+		return _size;
+	}
+private:
+	IFileReaderOwner *_owner;
+	const char *_data;
+	INT64 _size;
+	INT64 _position;
+};
+
+/**
+reads a file through its own file stream, used for files which can't be memory mapped
+*/
+class StreamFileReader : public IFileReader
+{
+public:
+	/**
+	the reader takes ownership of the stream
+	*/
+	StreamFileReader( IFileReaderOwner *owner, std::ifstream *stream, INT64 size );
+	virtual ~StreamFileReader();
+
+	void Close() override final;
+	UINT64 Read( void* buffer, UINT64 length ) override final;
+	UINT64 ReadMany( ReadRange *ranges, UINT32 count ) override final;
+	void SetPosition( INT64 pos ) override final;
+	INT64 GetPosition() const override final {
+		return _position;
+	}
+	bool EndOfFile() const override final {
+		return _stream->eof();
+	}
+	INT64 GetSize() const override final {
+		return _size;
+	}
+private:
+	IFileReaderOwner *_owner;
+	std::ifstream *_stream;
+	INT64 _size;
+	INT64 _position;
+};
+
+}
+}
+}
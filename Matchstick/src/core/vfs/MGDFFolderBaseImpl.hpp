@@ -12,39 +12,33 @@ namespace vfs
 class FolderBaseImpl : public FileBaseImpl
 {
 public:
-	FolderBaseImpl( const wchar_t *name, const wchar_t *physicalPath, IFile *parent )
-		: FileBaseImpl( parent )
+	/**
+	the name and physical path are not copied, so they must live at least as long as the folder
+	(i.e. they should be allocated from the same arena as the folder)
+	*/
+	FolderBaseImpl( const wchar_t *name, const wchar_t *physicalPath, IFile *parent, Arena *arena )
+		: FileBaseImpl( parent, arena )
 		, _name( name )
 		, _path( physicalPath ) {
 		_ASSERTE( name );
 		_ASSERTE( physicalPath );
 	}
 
-	FolderBaseImpl( const std::wstring &name, const wchar_t *physicalPath, IFile *parent )
-		: FileBaseImpl( parent )
-		, _name( name )
-		, _path( physicalPath ) {
-		_ASSERTE( physicalPath );
-	}
-
-	FolderBaseImpl( const std::wstring &name, const std::wstring &physicalPath, IFile *parent )
-		: FileBaseImpl( parent )
-		, _name( name )
-		, _path( physicalPath ) {
-	}
-
 	virtual ~FolderBaseImpl() {}
 
 	bool FolderBaseImpl::IsOpen() const override final {
 		return false;
 	}
-	MGDFError FolderBaseImpl::Open( IFileReader **reader ) override final {
+	MGDFError FolderBaseImpl::OpenReader( IFileReader **reader ) override final {
 		return MGDF_ERR_IS_FOLDER;
 	}
 	
 	bool FolderBaseImpl::IsFolder() const override final {
 		return true;
 	}
+	INT64 GetSize() const override final {
+		return 0;
+	}
 	bool FolderBaseImpl::IsArchive() const override {
 		return false;
 	}
@@ -52,13 +46,13 @@ public:
 		return nullptr;
 	}
 	const wchar_t *FolderBaseImpl::GetPhysicalPath() const override final {
-		return _path.c_str();
+		return _path;
 	}
 	const wchar_t *GetName() const override final {
-		return _name.c_str();
+		return _name;
 	}
 private:
-	std::wstring _name, _path;
+	const wchar_t *_name, *_path;
 };
 
 }
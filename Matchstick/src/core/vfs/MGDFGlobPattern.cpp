@@ -0,0 +1,147 @@
+#include "StdAfx.h"
+
+#include "MGDFGlobPattern.hpp"
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+//finds the end of the character class starting at class, a ] straight after the [ (or [!) is part of the class
+static const wchar_t *FindClassEnd( const wchar_t *characterClass )
+{
+	const wchar_t *end = characterClass + 1;
+	if ( *end == L'!' ) ++end;
+	if ( *end == L']' ) ++end;
+	while ( *end && *end != L']' ) ++end;
+	return *end ? end : nullptr;
+}
+
+static bool MatchClass( const wchar_t *characterClass, const wchar_t *end, wchar_t c )
+{
+	const wchar_t *it = characterClass + 1;
+	const bool negate = *it == L'!';
+	if ( negate ) ++it;
+
+	bool found = false;
+	while ( it < end ) {
+		wchar_t low = *it;
+		wchar_t high = *it;
+		if ( it + 2 < end && it[1] == L'-' ) {
+			high = it[2];
+			it += 3;
+		} else {
+			++it;
+		}
+		if ( c >= low && c <= high ) found = true;
+	}
+	return found != negate;
+}
+
+bool GlobPattern::Compile( const wchar_t *pattern )
+{
+	_ASSERTE( pattern );
+	_segments.clear();
+
+	const wchar_t *start = pattern;
+	while ( *start ) {
+		const wchar_t *end = start;
+		while ( *end && *end != L'/' ) ++end;
+
+		//empty segments (from leading, trailing or repeated separators) are ignored
+		if ( end != start ) {
+			Segment segment;
+			segment.text.assign( start, end );
+			segment.type = LITERAL;
+			if ( segment.text == L"**" ) {
+				segment.type = RECURSIVE;
+			} else {
+				for ( const wchar_t *it = start; it < end; ++it ) {
+					if ( *it == L'[' ) {
+						const wchar_t *classEnd = FindClassEnd( it );
+						if ( !classEnd || classEnd >= end ) return false;
+						it = classEnd;
+						segment.type = WILDCARD;
+					} else if ( *it == L'*' || *it == L'?' ) {
+						segment.type = WILDCARD;
+					}
+				}
+			}
+
+			//consecutive ** segments are equivalent to a single one
+			if ( segment.type != RECURSIVE || _segments.empty() || _segments.back().type != RECURSIVE ) {
+				_segments.push_back( segment );
+			}
+		}
+		start = *end ? end + 1 : end;
+	}
+	return !_segments.empty();
+}
+
+size_t GlobPattern::GetLiteralPrefixLength() const
+{
+	size_t length = 0;
+	while ( length < _segments.size() && _segments[length].type == LITERAL ) ++length;
+	return length;
+}
+
+bool GlobPattern::IsAmbiguous() const
+{
+	size_t recursive = 0;
+	for ( auto &segment : _segments ) {
+		if ( segment.type == RECURSIVE ) ++recursive;
+	}
+	return recursive > 1;
+}
+
+bool GlobPattern::Match( const wchar_t *segment, const wchar_t *name )
+{
+	_ASSERTE( segment );
+	_ASSERTE( name );
+
+	//when a match fails after a *, the * is made to match one more character and matching resumes from there
+	const wchar_t *star = nullptr;
+	const wchar_t *starName = nullptr;
+	while ( *name ) {
+		if ( *segment == L'*' ) {
+			star = ++segment;
+			starName = name;
+			continue;
+		}
+
+		const wchar_t *next = nullptr;
+		if ( *segment == L'?' ) {
+			next = segment + 1;
+		} else if ( *segment == L'[' ) {
+			const wchar_t *end = FindClassEnd( segment );
+			if ( end && MatchClass( segment, end, *name ) ) next = end + 1;
+		} else if ( *segment == *name ) {
+			next = segment + 1;
+		}
+
+		if ( next ) {
+			segment = next;
+			++name;
+		} else if ( star ) {
+			segment = star;
+			name = ++starName;
+		} else {
+			return false;
+		}
+	}
+
+	while ( *segment == L'*' ) ++segment;
+	return !*segment;
+}
+
+}
+}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <MGDF/MGDF.hpp>
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+/**
+a glob pattern compiled into its / delimited segments. Segments without any wildcards are kept as literals so they
+can be looked up directly rather than matched against every child of a folder
+*/
+class GlobPattern
+{
+public:
+	enum SegmentType {
+		LITERAL,
+		WILDCARD,
+		RECURSIVE // ** which matches any number of nested folders
+	};
+
+	struct Segment {
+		SegmentType type;
+		std::wstring text;
+	};
+
+	GlobPattern() {}
+	virtual ~GlobPattern() {}
+
+	/**
+	\return false if the pattern is empty or contains an unterminated character class
+	*/
+	bool Compile( const wchar_t *pattern );
+
+	const std::vector<Segment> &GetSegments() const {
+		return _segments;
+	}
+
+	/**
+	the number of literal segments at the start of the pattern
+	*/
+	size_t GetLiteralPrefixLength() const;
+
+	/**
+	whether the pattern could match the same path in more than one way, i.e. it has more than one ** segment
+	*/
+	bool IsAmbiguous() const;
+
+	/**
+	match a name against a single segment, * matches any characters, ? matches any one character and [abc] or [a-z]
+	matches any one of the characters in the class (or any character not in the class if it starts with !)
+	*/
+	static bool Match( const wchar_t *segment, const wchar_t *name );
+
+private:
+	std::vector<Segment> _segments;
+};
+
+}
+}
+}
@@ -0,0 +1,345 @@
+#include "StdAfx.h"
+
+#include <fstream>
+#include <filesystem>
+#include "../common/MGDFLoggerImpl.hpp"
+#include "../common/MGDFResources.hpp"
+#include "MGDFManifest.hpp"
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+/*
+the manifest file consists of a header followed by a list of records, all values are little endian
+and strings are null terminated UTF-16. Every field is a multiple of 2 bytes in size so strings in
+the mapped file are always suitably aligned to be used in place.
+
+header
+	UINT32 magic
+	UINT32 version
+	UINT32 record count
+	UINT32 reserved
+
+record
+	UINT32 record length (in bytes, including this field)
+	UINT32 entry count
+	INT64 last write time
+	INT64 size
+	UINT32 path length (in characters, excluding the null terminator)
+	wchar_t path[path length + 1]
+	entry[entry count]
+
+entry
+	UINT32 flags
+	UINT32 name length (in characters, excluding the null terminator)
+	INT64 size
+	UINT64 position
+	UINT64 index
+	INT64 last write time
+	wchar_t name[name length + 1]
+*/
+
+#define MANIFEST_MAGIC 0x4d56474d // MGVM
+#define MANIFEST_VERSION 3
+#define MANIFEST_HEADER_SIZE 16
+#define MANIFEST_RECORD_HEADER_SIZE 28
+#define MANIFEST_ENTRY_HEADER_SIZE 40
+
+template <typename T>
+static T ReadValue( const char *data )
+{
+	T value;
+	memcpy( &value, data, sizeof( T ) );
+	return value;
+}
+
+template <typename T>
+static void WriteValue( std::string &out, T value )
+{
+	out.append( reinterpret_cast<const char *>( &value ), sizeof( T ) );
+}
+
+static void WriteString( std::string &out, const wchar_t *str, size_t length )
+{
+	out.append( reinterpret_cast<const char *>( str ), length * sizeof( wchar_t ) );
+	WriteValue<wchar_t>( out, L'\0' );
+}
+
+Manifest::Manifest()
+	: _file( INVALID_HANDLE_VALUE )
+	, _mapping( nullptr )
+	, _data( nullptr )
+	, _size( 0 )
+	, _dirty( false )
+	, _hits( 0 )
+	, _misses( 0 )
+{
+}
+
+Manifest::~Manifest()
+{
+	Unmap();
+}
+
+void Manifest::Unmap()
+{
+	_loaded.clear();
+	if ( _data ) {
+		UnmapViewOfFile( _data );
+		_data = nullptr;
+	}
+	if ( _mapping ) {
+		CloseHandle( _mapping );
+		_mapping = nullptr;
+	}
+	if ( _file != INVALID_HANDLE_VALUE ) {
+		CloseHandle( _file );
+		_file = INVALID_HANDLE_VALUE;
+	}
+	_size = 0;
+}
+
+bool Manifest::Load( const std::wstring &file )
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	Unmap();
+
+	_file = CreateFileW( file.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+	if ( _file == INVALID_HANDLE_VALUE ) {
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if ( !GetFileSizeEx( _file, &size ) || size.QuadPart < MANIFEST_HEADER_SIZE ) {
+		Unmap();
+		return false;
+	}
+
+	_mapping = CreateFileMappingW( _file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	if ( _mapping ) {
+		_data = static_cast<const char *>( MapViewOfFile( _mapping, FILE_MAP_READ, 0, 0, 0 ) );
+	}
+	if ( !_data ) {
+		LOG( "Unable to map VFS manifest " << Resources::ToString( file ), LOG_ERROR );
+		Unmap();
+		return false;
+	}
+	_size = static_cast<size_t>( size.QuadPart );
+
+	if ( ReadValue<UINT32>( _data ) != MANIFEST_MAGIC || ReadValue<UINT32>( _data + 4 ) != MANIFEST_VERSION ) {
+		LOG( "VFS manifest " << Resources::ToString( file ) << " is not a valid manifest, ignoring", LOG_ERROR );
+		Unmap();
+		return false;
+	}
+
+	UINT32 recordCount = ReadValue<UINT32>( _data + 8 );
+	size_t offset = MANIFEST_HEADER_SIZE;
+	for ( UINT32 i = 0; i < recordCount; ++i ) {
+		if ( offset + MANIFEST_RECORD_HEADER_SIZE > _size ) break;
+		UINT32 length = ReadValue<UINT32>( _data + offset );
+		UINT32 pathLength = ReadValue<UINT32>( _data + offset + 24 );
+		if ( length < MANIFEST_RECORD_HEADER_SIZE + ( pathLength + 1 ) * sizeof( wchar_t ) || offset + length > _size ) break;
+		if ( ReadValue<wchar_t>( _data + offset + MANIFEST_RECORD_HEADER_SIZE + pathLength * sizeof( wchar_t ) ) != L'\0' ) break;
+
+		LoadedRecord record;
+		record.data = _data + offset;
+		record.length = length;
+		record.replaced = false;
+		_loaded.insert( std::make_pair( reinterpret_cast<const wchar_t *>( _data + offset + MANIFEST_RECORD_HEADER_SIZE ), record ) );
+		offset += length;
+	}
+
+	if ( _loaded.size() != recordCount ) {
+		LOG( "VFS manifest " << Resources::ToString( file ) << " is truncated, ignoring", LOG_ERROR );
+		Unmap();
+		return false;
+	}
+
+	LOG( "Loaded VFS manifest with " << recordCount << " records", LOG_LOW );
+	return true;
+}
+
+bool Manifest::GetRecord( const wchar_t *physicalPath, INT64 lastWriteTime, INT64 size, std::vector<ManifestEntry> &entries )
+{
+	_ASSERTE( physicalPath );
+	std::lock_guard<std::mutex> lock( _mutex );
+
+	auto it = _loaded.find( physicalPath );
+	if ( it == _loaded.end() || it->second.replaced ) {
+		++_misses;
+		return false;
+	}
+
+	const char *data = it->second.data;
+	if ( ReadValue<INT64>( data + 8 ) != lastWriteTime || ReadValue<INT64>( data + 16 ) != size ) {
+		// the folder or archive has changed since the record was made
+		it->second.replaced = true;
+		_dirty = true;
+		++_misses;
+		return false;
+	}
+
+	const char *end = data + it->second.length;
+	UINT32 entryCount = ReadValue<UINT32>( data + 4 );
+	data += MANIFEST_RECORD_HEADER_SIZE + ( ReadValue<UINT32>( data + 24 ) + 1 ) * sizeof( wchar_t );
+
+	entries.clear();
+	entries.reserve( entryCount );
+	for ( UINT32 i = 0; i < entryCount; ++i ) {
+		if ( data + MANIFEST_ENTRY_HEADER_SIZE > end ) break;
+		ManifestEntry entry;
+		entry.flags = ReadValue<UINT32>( data );
+		UINT32 nameLength = ReadValue<UINT32>( data + 4 );
+		entry.size = ReadValue<INT64>( data + 8 );
+		entry.position = ReadValue<UINT64>( data + 16 );
+		entry.index = ReadValue<UINT64>( data + 24 );
+		entry.lastWriteTime = ReadValue<INT64>( data + 32 );
+		entry.name = reinterpret_cast<const wchar_t *>( data + MANIFEST_ENTRY_HEADER_SIZE );
+		data += MANIFEST_ENTRY_HEADER_SIZE + ( nameLength + 1 ) * sizeof( wchar_t );
+		if ( data > end || ReadValue<wchar_t>( data - sizeof( wchar_t ) ) != L'\0' ) break;
+		entries.push_back( entry );
+	}
+
+	if ( entries.size() != entryCount ) {
+		LOG( "VFS manifest record for " << Resources::ToString( physicalPath ) << " is corrupt, ignoring", LOG_ERROR );
+		it->second.replaced = true;
+		_dirty = true;
+		++_misses;
+		return false;
+	}
+
+	++_hits;
+	return true;
+}
+
+void Manifest::AddRecord( const wchar_t *physicalPath, INT64 lastWriteTime, INT64 size, const std::vector<ManifestEntry> &entries )
+{
+	_ASSERTE( physicalPath );
+
+	std::string record;
+	const size_t pathLength = wcslen( physicalPath );
+	WriteValue<UINT32>( record, 0 ); // length is filled in once the record is complete
+	WriteValue<UINT32>( record, static_cast<UINT32>( entries.size() ) );
+	WriteValue<INT64>( record, lastWriteTime );
+	WriteValue<INT64>( record, size );
+	WriteValue<UINT32>( record, static_cast<UINT32>( pathLength ) );
+	WriteString( record, physicalPath, pathLength );
+
+	for ( auto &entry : entries ) {
+		const size_t nameLength = wcslen( entry.name );
+		WriteValue<UINT32>( record, entry.flags );
+		WriteValue<UINT32>( record, static_cast<UINT32>( nameLength ) );
+		WriteValue<INT64>( record, entry.size );
+		WriteValue<UINT64>( record, entry.position );
+		WriteValue<UINT64>( record, entry.index );
+		WriteValue<INT64>( record, entry.lastWriteTime );
+		WriteString( record, entry.name, nameLength );
+	}
+
+	UINT32 length = static_cast<UINT32>( record.size() );
+	memcpy( &record[0], &length, sizeof( UINT32 ) );
+
+	std::lock_guard<std::mutex> lock( _mutex );
+	auto it = _loaded.find( physicalPath );
+	if ( it != _loaded.end() ) {
+		it->second.replaced = true;
+	}
+	_added[physicalPath] = std::move( record );
+	_dirty = true;
+}
+
+bool Manifest::Save( const std::wstring &file )
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+
+	std::filesystem::path path( file );
+	std::filesystem::path temp( file + L".tmp" );
+	std::error_code error;
+	std::filesystem::create_directories( path.parent_path(), error );
+
+	{
+		std::ofstream out( temp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+		if ( !out.is_open() ) {
+			LOG( "Unable to write VFS manifest " << Resources::ToString( temp.wstring() ), LOG_ERROR );
+			return false;
+		}
+
+		UINT32 recordCount = static_cast<UINT32>( _added.size() );
+		for ( auto &loaded : _loaded ) {
+			if ( !loaded.second.replaced ) ++recordCount;
+		}
+
+		std::string header;
+		WriteValue<UINT32>( header, MANIFEST_MAGIC );
+		WriteValue<UINT32>( header, MANIFEST_VERSION );
+		WriteValue<UINT32>( header, recordCount );
+		WriteValue<UINT32>( header, 0 );
+		out.write( header.data(), header.size() );
+
+		// records from the loaded manifest are still valid, so they can be copied straight from the mapping
+		for ( auto &loaded : _loaded ) {
+			if ( !loaded.second.replaced ) {
+				out.write( loaded.second.data, loaded.second.length );
+			}
+		}
+		for ( auto &added : _added ) {
+			out.write( added.second.data(), added.second.size() );
+		}
+
+		if ( out.bad() ) {
+			LOG( "Unable to write VFS manifest " << Resources::ToString( temp.wstring() ), LOG_ERROR );
+			return false;
+		}
+	}
+
+	// the existing manifest has to be unmapped before it can be replaced
+	Unmap();
+	_added.clear();
+	std::filesystem::rename( temp, path, error );
+	if ( error ) {
+		LOG( "Unable to replace VFS manifest " << Resources::ToString( file ) << " - " << error.message(), LOG_ERROR );
+		return false;
+	}
+
+	_dirty = false;
+	return true;
+}
+
+INT64 Manifest::GetLastWriteTime( const std::filesystem::path &path )
+{
+	std::error_code error;
+	auto time = std::filesystem::last_write_time( path, error );
+	return error ? 0 : static_cast<INT64>( time.time_since_epoch().count() );
+}
+
+bool Manifest::IsDirty() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return _dirty;
+}
+
+size_t Manifest::GetHits() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return _hits;
+}
+
+size_t Manifest::GetMisses() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return _misses;
+}
+
+}
+}
+}
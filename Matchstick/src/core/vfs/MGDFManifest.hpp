@@ -0,0 +1,120 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <filesystem>
+#include <MGDF/MGDF.hpp>
+#include <MGDF/MGDFVirtualFileSystem.hpp>
+
+#include "MGDFPathIndex.hpp"
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+/**
+an entry in a manifest record, for folders this is a child of the folder and for archives this is
+a member of the archive (in which case the name is the members full path inside the archive)
+*/
+struct ManifestEntry {
+	static const UINT32 FOLDER = 1;
+	static const UINT32 STORED = 2; // an archive member which is stored without compression
+
+	const wchar_t *name;
+	UINT32 flags;
+	INT64 size;
+	UINT64 position;
+	UINT64 index;
+	INT64 lastWriteTime; // only recorded for archive members
+};
+
+/**
+a persistent cache of the contents of the folders and archives mapped by the vfs. Each record holds the
+entries of one folder or archive along with the last write time and size it had when it was scanned, so on
+the next launch any folder or archive which hasn't changed can be mapped without scanning it again.
+The manifest file is memory mapped when loaded and the names of the entries point directly into the mapping,
+so they are only valid until the manifest is saved or destroyed.
+*/
+class Manifest
+{
+public:
+	Manifest();
+	virtual ~Manifest();
+
+	/**
+	map an existing manifest file, returns false if the file does not exist or is not a valid manifest
+	*/
+	bool Load( const std::wstring &file );
+
+	/**
+	write out the manifest, this includes every record from the loaded manifest which
+	has not been invalidated, aswell as any records added since it was loaded
+	*/
+	bool Save( const std::wstring &file );
+
+	/**
+	get the entries recorded for a folder or archive. If the record exists but the last write time
+	or size differ from those recorded then the record is discarded and false is returned
+	*/
+	bool GetRecord( const wchar_t *physicalPath, INT64 lastWriteTime, INT64 size, std::vector<ManifestEntry> &entries );
+
+	/**
+	add or replace the record for a folder or archive
+	*/
+	void AddRecord( const wchar_t *physicalPath, INT64 lastWriteTime, INT64 size, const std::vector<ManifestEntry> &entries );
+
+	/**
+	whether any records have been added or invalidated since the manifest was loaded
+	*/
+	bool IsDirty() const;
+
+	size_t GetHits() const;
+	size_t GetMisses() const;
+
+	/**
+	get the last write time of a file or folder in the form stored in manifest records (or 0 if it can't be found)
+	*/
+	static INT64 GetLastWriteTime( const std::filesystem::path &path );
+private:
+	struct LoadedRecord {
+		const char *data;
+		UINT32 length;
+		bool replaced;
+	};
+
+	void Unmap();
+
+	mutable std::mutex _mutex;
+	HANDLE _file;
+	HANDLE _mapping;
+	const char *_data;
+	size_t _size;
+	std::unordered_map<const wchar_t *, LoadedRecord, WCharHash, WCharEqual> _loaded;
+	std::map<std::wstring, std::string> _added;
+	bool _dirty;
+	size_t _hits;
+	size_t _misses;
+};
+
+/**
+implemented by archive handlers which are able to map archives using the records in a manifest
+*/
+class IManifestArchiveHandler
+{
+public:
+	/**
+	map an archive, using the manifest record for the archive if it is still valid, otherwise the archive
+	is scanned as normal and a new record for it is added to the manifest
+	*/
+	virtual IFile *MapArchive( const wchar_t *name, const wchar_t *physicalPath, IFile *parent, Manifest *manifest ) = 0;
+};
+
+}
+}
+}
@@ -0,0 +1,120 @@
+#include "StdAfx.h"
+
+#include "MGDFOverlayFileImpl.hpp"
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+OverlayFileImpl::OverlayFileImpl( IFile *file, IFile *parent )
+	: _file( file )
+	, _parent( parent )
+{
+	_ASSERTE( file );
+	_ASSERTE( parent );
+}
+
+OverlayFileImpl::~OverlayFileImpl()
+{
+	// the layer file is owned by the mounts arena, or by the archive handler that mapped it
+}
+
+const wchar_t *OverlayFileImpl::GetName() const
+{
+	return _file->GetName();
+}
+
+IFile *OverlayFileImpl::GetParent() const
+{
+	return _parent;
+}
+
+IFile *OverlayFileImpl::GetChild( const wchar_t *name ) const
+{
+	return _file->GetChild( name );
+}
+
+bool OverlayFileImpl::GetAllChildren( const IFileFilter *filter, IFile **childBuffer, size_t *bufferLength ) const
+{
+	return _file->GetAllChildren( filter, childBuffer, bufferLength );
+}
+
+size_t OverlayFileImpl::GetChildCount() const
+{
+	return _file->GetChildCount();
+}
+
+bool OverlayFileImpl::IsFolder() const
+{
+	return _file->IsFolder();
+}
+
+bool OverlayFileImpl::IsOpen() const
+{
+	return _file->IsOpen();
+}
+
+MGDFError OverlayFileImpl::Open( IFileReader **reader )
+{
+	// the layer file records the open in the access trace, and its logical path is the same as the overlays
+	return _file->Open( reader );
+}
+
+MGDFError OverlayFileImpl::OpenUnbuffered( IFileReader **reader )
+{
+	return _file->OpenUnbuffered( reader );
+}
+
+MGDFError OverlayFileImpl::ReadAll( void *buffer, UINT64 *length )
+{
+	return _file->ReadAll( buffer, length );
+}
+
+bool OverlayFileImpl::IsArchive() const
+{
+	return _file->IsArchive();
+}
+
+const wchar_t *OverlayFileImpl::GetArchiveName() const
+{
+	return _file->GetArchiveName();
+}
+
+const wchar_t *OverlayFileImpl::GetPhysicalPath() const
+{
+	return _file->GetPhysicalPath();
+}
+
+const wchar_t *OverlayFileImpl::GetLogicalPath() const
+{
+	return _file->GetLogicalPath();
+}
+
+time_t OverlayFileImpl::GetLastWriteTime() const
+{
+	return _file->GetLastWriteTime();
+}
+
+INT64 OverlayFileImpl::GetSize() const
+{
+	return _file->GetSize();
+}
+
+IFile *OverlayFileImpl::FindFile( const wchar_t *path ) const
+{
+	const IIndexedArchive *archive = dynamic_cast<const IIndexedArchive *>( _file );
+	return archive ? archive->FindFile( path ) : nullptr;
+}
+
+}
+}
+}
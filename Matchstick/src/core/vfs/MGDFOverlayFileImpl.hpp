@@ -0,0 +1,54 @@
+#pragma once
+
+#include <MGDF/MGDFVirtualFileSystem.hpp>
+
+#include "MGDFPathIndex.hpp"
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+/**
+a file which is visible through an overlay folder. The file in the layer it comes from may also be visible through
+other overlay folders, so rather than changing its parent, the overlay wraps it in one of these which forwards everything
+to the layer file apart from the parent, which is the overlay folder. Archives are wrapped the same way, so the entries
+in an archive are the archives own nodes, whose parents lead back to the archive in the layer
+*/
+class OverlayFileImpl : public IFile, public IIndexedArchive
+{
+public:
+	OverlayFileImpl( IFile *file, IFile *parent );
+	virtual ~OverlayFileImpl( void );
+
+	const wchar_t *GetName() const override final;
+	IFile *GetParent() const override final;
+	IFile *GetChild( const wchar_t *name ) const override final;
+	bool GetAllChildren( const IFileFilter *filter, IFile **childBuffer, size_t *bufferLength ) const override final;
+	size_t GetChildCount() const override final;
+	bool IsFolder() const override final;
+	bool IsOpen() const override final;
+	MGDFError Open( IFileReader **reader ) override final;
+	MGDFError OpenUnbuffered( IFileReader **reader ) override final;
+	MGDFError ReadAll( void *buffer, UINT64 *length ) override final;
+	bool IsArchive() const override final;
+	const wchar_t *GetArchiveName() const override final;
+	const wchar_t *GetPhysicalPath() const override final;
+	const wchar_t *GetLogicalPath() const override final;
+	time_t GetLastWriteTime() const override final;
+	INT64 GetSize() const override final;
+	IFile *FindFile( const wchar_t *path ) const override final;
+
+	IFile *GetFile() const {
+		return _file;
+	}
+private:
+	IFile *_file;
+	IFile *_parent;
+};
+
+}
+}
+}
@@ -0,0 +1,78 @@
+#include "StdAfx.h"
+
+#include <algorithm>
+#include "MGDFOverlayFolderImpl.hpp"
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+OverlayFolderImpl::OverlayFolderImpl( IFile * const *layers, size_t layerCount, IFile *parent, Arena *arena, VirtualFileSystemComponent *vfs )
+	: FolderBaseImpl( layers[0]->GetName(), layers[0]->GetPhysicalPath(), parent, arena )
+	, _vfs( vfs )
+	, _layerCount( layerCount )
+{
+	_ASSERTE( vfs );
+	_ASSERTE( layerCount > 0 );
+	_layers = static_cast<IFile **>( arena->Allocate( layerCount * sizeof( IFile * ), alignof( IFile * ) ) );
+	std::copy( layers, layers + layerCount, _layers );
+}
+
+OverlayFolderImpl::~OverlayFolderImpl()
+{
+	// the layers are owned by the mounts arena, or by the archive handlers that mapped them
+}
+
+const ChildList *OverlayFolderImpl::MapChildren() const
+{
+	const ChildList *children = GetMappedChildren();
+	if ( children ) return children;
+
+	std::lock_guard<std::mutex> lock( _mutex );
+	children = _children.load( std::memory_order_relaxed );
+	if ( !children ) {
+		auto merged = _arena->New<ChildList>( _arena );
+		_vfs->MapOverlayChildren( const_cast<OverlayFolderImpl *>( this ), *merged );
+		merged->Freeze();
+		PublishChildren( merged );
+		children = merged;
+	}
+	return children;
+}
+
+void OverlayFolderImpl::Invalidate()
+{
+	// the previous children are owned by the arena, so they remain valid for any thread which is still using them
+	std::lock_guard<std::mutex> lock( _mutex );
+	PublishChildren( nullptr );
+}
+
+IFile *OverlayFolderImpl::GetChild( const wchar_t *name ) const
+{
+	if ( !name ) return nullptr;
+
+	return MapChildren()->Find( name );
+}
+
+size_t OverlayFolderImpl::GetChildCount() const
+{
+	return MapChildren()->Size();
+}
+
+bool OverlayFolderImpl::GetAllChildren( const IFileFilter *filter, IFile **childBuffer, size_t *bufferLength ) const
+{
+	return CopyChildren( MapChildren(), filter, childBuffer, bufferLength );
+}
+
+}
+}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "MGDFVirtualFileSystemComponentImpl.hpp"
+#include "MGDFFolderBaseImpl.hpp"
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+/**
+a folder which merges folders with the same logical path from one or more mounted layers. Like default folders,
+the children are mapped lazily. Where more than one layer has a child with the same name, the child from the
+topmost layer shadows the others, unless they are all folders in which case they are merged into another overlay folder.
+Subfolders are always overlay folders and files are wrapped in overlay files, so the whole merged tree belongs to the overlay
+and the nodes in the layers are never reparented. Overlay folders are never archives, though the files in them keep the archive
+name of the layer they come from
+*/
+class OverlayFolderImpl : public FolderBaseImpl
+{
+public:
+	/**
+	\param layers the folders to merge, ordered from the topmost layer down. The name and physical path of the overlay are those of the topmost folder
+	*/
+	OverlayFolderImpl( IFile * const *layers, size_t layerCount, IFile *parent, Arena *arena, VirtualFileSystemComponent *vfs );
+	virtual ~OverlayFolderImpl( void );
+
+	IFile *GetChild( const wchar_t *name ) const override final;
+	size_t GetChildCount() const override final;
+	bool GetAllChildren( const IFileFilter *filter, IFile **childBuffer, size_t *bufferLength ) const override final;
+
+	IFile * const *GetLayers() const {
+		return _layers;
+	}
+	size_t GetLayerCount() const {
+		return _layerCount;
+	}
+
+	/**
+	discard the merged children so they are merged again the next time they are needed, this should be
+	called when the children of any of the layers change
+	*/
+	void Invalidate();
+private:
+	VirtualFileSystemComponent *_vfs;
+	IFile **_layers;
+	size_t _layerCount;
+
+	/**
+	map the children if they haven't been mapped yet
+	\return the published children of the folder
+	*/
+	const ChildList *MapChildren() const;
+};
+
+}
+}
+}
@@ -0,0 +1,147 @@
+#include "StdAfx.h"
+
+#include <cmath>
+#include "MGDFPathFilter.hpp"
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+#define MIN_FILTER_BITS 512
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+// threads are given stripes in the order they first use a filter, so up to PATH_FILTER_COUNTER_STRIPES threads never share one
+static std::atomic<UINT32> _nextStripe( 0 );
+static thread_local const UINT32 _stripe = _nextStripe.fetch_add( 1, std::memory_order_relaxed ) % PATH_FILTER_COUNTER_STRIPES;
+
+PathFilter::PathFilter( size_t pathCount )
+	: _pathCount( 0 )
+{
+	for ( auto &counters : _counters ) {
+		counters.rejected.store( 0, std::memory_order_relaxed );
+		counters.falsePositives.store( 0, std::memory_order_relaxed );
+	}
+
+	// a power of 2 size means each bit index is found by masking rather than by a division
+	UINT64 bits = MIN_FILTER_BITS;
+	while ( bits < static_cast<UINT64>( pathCount ) * PATH_FILTER_BITS_PER_PATH ) {
+		bits <<= 1;
+	}
+	_mask = bits - 1;
+	const size_t words = static_cast<size_t>( bits / 64 );
+	_bits.reset( new std::atomic<UINT64>[words] );
+	for ( size_t i = 0; i < words; ++i ) {
+		_bits[i].store( 0, std::memory_order_relaxed );
+	}
+}
+
+UINT64 PathFilter::Hash( const wchar_t *logicalPath )
+{
+	UINT64 hash = EMPTY_HASH;
+	bool first = true;
+	for ( const wchar_t *c = logicalPath; *c; ) {
+		if ( *c == L'/' ) {
+			++c;
+			continue;
+		}
+		// FNV-1a, with a separator before every component except the first
+		if ( !first ) {
+			hash ^= static_cast<UINT16>( L'/' );
+			hash *= 1099511628211ULL;
+		}
+		first = false;
+		for ( ; *c && *c != L'/'; ++c ) {
+			hash ^= static_cast<UINT16>( *c );
+			hash *= 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+UINT64 PathFilter::Append( UINT64 hash, const wchar_t *component )
+{
+	if ( hash != EMPTY_HASH ) {
+		hash ^= static_cast<UINT16>( L'/' );
+		hash *= 1099511628211ULL;
+	}
+	for ( const wchar_t *c = component; *c; ++c ) {
+		hash ^= static_cast<UINT16>( *c );
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+// each bit is chosen by double hashing, using a second hash mixed from the first so only one pass over the path is needed
+static UINT64 SecondHash( UINT64 hash )
+{
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	return hash | 1;
+}
+
+void PathFilter::Add( UINT64 hash )
+{
+	const UINT64 step = SecondHash( hash );
+	for ( UINT32 i = 0; i < PATH_FILTER_HASHES; ++i, hash += step ) {
+		const UINT64 bit = hash & _mask;
+		_bits[static_cast<size_t>( bit >> 6 )].fetch_or( 1ULL << ( bit & 63 ), std::memory_order_relaxed );
+	}
+	_pathCount.fetch_add( 1, std::memory_order_relaxed );
+}
+
+bool PathFilter::MayContain( UINT64 hash ) const
+{
+	const UINT64 step = SecondHash( hash );
+	for ( UINT32 i = 0; i < PATH_FILTER_HASHES; ++i, hash += step ) {
+		const UINT64 bit = hash & _mask;
+		if ( !( _bits[static_cast<size_t>( bit >> 6 )].load( std::memory_order_relaxed ) & ( 1ULL << ( bit & 63 ) ) ) ) {
+			_counters[_stripe].rejected.fetch_add( 1, std::memory_order_relaxed );
+			return false;
+		}
+	}
+	return true;
+}
+
+void PathFilter::RecordFalsePositive() const
+{
+	_counters[_stripe].falsePositives.fetch_add( 1, std::memory_order_relaxed );
+}
+
+size_t PathFilter::GetRejected() const
+{
+	size_t rejected = 0;
+	for ( auto &counters : _counters ) {
+		rejected += counters.rejected.load( std::memory_order_relaxed );
+	}
+	return rejected;
+}
+
+size_t PathFilter::GetFalsePositives() const
+{
+	size_t falsePositives = 0;
+	for ( auto &counters : _counters ) {
+		falsePositives += counters.falsePositives.load( std::memory_order_relaxed );
+	}
+	return falsePositives;
+}
+
+double PathFilter::GetFalsePositiveRate() const
+{
+	// (1 - e^(-kn/m))^k
+	const double bits = static_cast<double>( _mask + 1 );
+	const double paths = static_cast<double>( GetPathCount() );
+	return std::pow( 1.0 - std::exp( -PATH_FILTER_HASHES * paths / bits ), PATH_FILTER_HASHES );
+}
+
+}
+}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <MGDF/MGDF.hpp>
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+// with 10 bits and 7 hashes per path, around 0.8% of paths which don't exist are false positives
+#define PATH_FILTER_BITS_PER_PATH 10
+#define PATH_FILTER_HASHES 7
+// the lookup counters are split across cache lines, so threads looking up paths at once don't contend on them
+#define PATH_FILTER_COUNTER_STRIPES 16
+
+/**
+a bloom filter over the logical paths of a fully mapped vfs tree. If the filter doesn't contain a path then
+there is definitely no file with that path, so looking it up can fail straight away without walking (or mapping)
+the tree. Paths which the filter may contain can still be false positives, so they have to be looked up as normal.
+Empty path components are ignored when hashing a path, just as they are when walking the tree. Paths can be added
+while other threads are checking the filter, but never removed
+*/
+class PathFilter
+{
+public:
+	static const UINT64 EMPTY_HASH = 14695981039346656037ULL; // the hash of the root path
+
+	/**
+	\param pathCount the number of paths to size the filter for. More paths can be added, but the false positive rate rises as they are
+	*/
+	PathFilter( size_t pathCount );
+	virtual ~PathFilter() {}
+
+	/**
+	hash a logical path, ignoring any empty components
+	*/
+	static UINT64 Hash( const wchar_t *logicalPath );
+
+	/**
+	extend the hash of a path with another component, so the paths of a whole tree can be hashed without building each path
+	\param hash the hash of the parent path
+	*/
+	static UINT64 Append( UINT64 hash, const wchar_t *component );
+
+	void Add( UINT64 hash );
+	bool MayContain( UINT64 hash ) const;
+
+	/**
+	record that a path the filter may have contained was looked up and not found
+	*/
+	void RecordFalsePositive() const;
+
+	size_t GetPathCount() const {
+		return _pathCount.load( std::memory_order_relaxed );
+	}
+	size_t GetSizeInBytes() const {
+		return static_cast<size_t>( ( _mask + 1 ) / 8 );
+	}
+
+	/**
+	the expected rate of false positives for the number of paths added so far
+	*/
+	double GetFalsePositiveRate() const;
+
+	/**
+	the number of lookups which the filter failed straight away
+	*/
+	size_t GetRejected() const;
+	size_t GetFalsePositives() const;
+private:
+	/**
+	each thread counts its lookups in one of the stripes, and the counts are summed when they are read
+	*/
+	struct alignas( 64 ) Counters {
+		std::atomic<size_t> rejected;
+		std::atomic<size_t> falsePositives;
+	};
+
+	std::unique_ptr<std::atomic<UINT64>[]> _bits;
+	UINT64 _mask; // the size of the filter in bits, less one
+	std::atomic<size_t> _pathCount;
+	mutable Counters _counters[PATH_FILTER_COUNTER_STRIPES];
+};
+
+}
+}
+}
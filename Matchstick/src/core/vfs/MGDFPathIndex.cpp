@@ -0,0 +1,113 @@
+#include "StdAfx.h"
+
+#include <vector>
+#include "MGDFPathIndex.hpp"
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+IFile *PathIndex::Find( const wchar_t *logicalPath ) const
+{
+	_ASSERTE( logicalPath );
+
+	std::shared_lock<std::shared_mutex> lock( _mutex );
+	auto it = _index.find( logicalPath );
+	return it != _index.end() ? it->second : nullptr;
+}
+
+size_t PathIndex::GetSize() const
+{
+	std::shared_lock<std::shared_mutex> lock( _mutex );
+	return _index.size();
+}
+
+void PathIndex::Add( const std::wstring &logicalPath, IFile *file )
+{
+	std::unique_lock<std::shared_mutex> lock( _mutex );
+	AddUnsafe( logicalPath, file );
+}
+
+void PathIndex::AddTree( const std::wstring &logicalPath, IFile *file )
+{
+	std::unique_lock<std::shared_mutex> lock( _mutex );
+	AddTreeUnsafe( logicalPath, file );
+}
+
+void PathIndex::Remove( const std::wstring &logicalPath )
+{
+	std::unique_lock<std::shared_mutex> lock( _mutex );
+	RemoveUnsafe( logicalPath, true );
+}
+
+void PathIndex::RemoveChildren( const std::wstring &logicalPath )
+{
+	std::unique_lock<std::shared_mutex> lock( _mutex );
+	RemoveUnsafe( logicalPath, false );
+}
+
+void PathIndex::RemoveUnsafe( const std::wstring &logicalPath, bool removeRoot )
+{
+	// the index is flat, so every key has to be checked for the prefix. This is only needed when
+	// content changes while the vfs is mounted, so isn't worth keeping a tree of the keys for.
+	// The paths of removed keys are not released until the index is destroyed
+	std::wstring prefix( logicalPath );
+	if ( !prefix.empty() ) prefix += '/';
+
+	for ( auto it = _index.begin(); it != _index.end(); ) {
+		const wchar_t *key = it->first;
+		bool isRoot = logicalPath == key;
+		if ( ( isRoot && removeRoot ) || ( !isRoot && std::wcsncmp( key, prefix.c_str(), prefix.size() ) == 0 ) ) {
+			it = _index.erase( it );
+		} else {
+			++it;
+		}
+	}
+}
+
+void PathIndex::AddUnsafe( const std::wstring &logicalPath, IFile *file )
+{
+	_ASSERTE( file );
+	// paths are often added again when content is remapped, which only needs the existing key to be updated
+	auto found = _index.find( logicalPath.c_str() );
+	if ( found != _index.end() ) {
+		found->second = file;
+		return;
+	}
+	_paths.push_back( logicalPath );
+	_index.emplace( _paths.back().c_str(), file );
+}
+
+void PathIndex::AddTreeUnsafe( const std::wstring &logicalPath, IFile *file )
+{
+	AddUnsafe( logicalPath, file );
+
+	size_t length = file->GetChildCount();
+	if ( !length ) return;
+
+	std::vector<IFile *> children( length );
+	file->GetAllChildren( nullptr, children.data(), &length );
+
+	std::wstring childPath( logicalPath );
+	if ( !childPath.empty() ) childPath += '/';
+	const size_t prefixLength = childPath.size();
+
+	for ( size_t i = 0; i < length; ++i ) {
+		childPath.resize( prefixLength );
+		childPath += children[i]->GetName();
+		AddTreeUnsafe( childPath, children[i] );
+	}
+}
+
+}
+}
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <shared_mutex>
+#include <unordered_map>
+#include <MGDF/MGDFVirtualFileSystem.hpp>
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+struct WCharHash {
+	size_t operator()( const wchar_t *str ) const {
+		// FNV-1a
+		size_t hash = 14695981039346656037ULL;
+		while ( *str ) {
+			hash ^= static_cast<size_t>( *str++ );
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+};
+
+struct WCharEqual {
+	bool operator()( const wchar_t *a, const wchar_t *b ) const {
+		return std::wcscmp( a, b ) == 0;
+	}
+};
+
+/**
+a flat index of vfs nodes keyed by thier full logical path. The index is populated as parts of the vfs tree
+are mapped, so looking up a path which has already been mapped costs a single hash probe with no allocations.
+Paths which are not in the index may still exist in a part of the tree that hasn't been mapped yet, so a failed
+lookup should fall back to walking the tree.
+*/
+class PathIndex
+{
+public:
+	PathIndex() {}
+	virtual ~PathIndex() {}
+
+	IFile *Find( const wchar_t *logicalPath ) const;
+
+	/**
+	add a single node to the index
+	*/
+	void Add( const std::wstring &logicalPath, IFile *file );
+
+	/**
+	add a node and all of its descendants to the index. This should only be used for fully mapped
+	subtrees (i.e. archives) as it will force any lazily mapped folders to map thier children
+	*/
+	void AddTree( const std::wstring &logicalPath, IFile *file );
+
+	/**
+	remove a node and all of its descendants from the index
+	*/
+	void Remove( const std::wstring &logicalPath );
+
+	/**
+	remove all of the descendants of a node from the index, but not the node itself
+	*/
+	void RemoveChildren( const std::wstring &logicalPath );
+
+	size_t GetSize() const;
+private:
+	void AddTreeUnsafe( const std::wstring &logicalPath, IFile *file );
+	void AddUnsafe( const std::wstring &logicalPath, IFile *file );
+	void RemoveUnsafe( const std::wstring &logicalPath, bool removeRoot );
+
+	mutable std::shared_mutex _mutex;
+	// the index keys point into these strings, a deque never relocates its
+	// existing elements so the keys remain valid as new paths are added
+	std::deque<std::wstring> _paths;
+	std::unordered_map<const wchar_t *, IFile *, WCharHash, WCharEqual> _index;
+};
+
+/**
+implemented by the roots of archives which keep thier own index of the paths of thier entries, so files
+in the archive can be found with a single lookup rather than by walking the archives tree
+*/
+class IIndexedArchive
+{
+public:
+	/**
+	\param path the path of the file relative to the archive root
+	\return the file, or nullptr if no file has that path (folders are not indexed)
+	*/
+	virtual IFile *FindFile( const wchar_t *path ) const = 0;
+};
+
+}
+}
+}
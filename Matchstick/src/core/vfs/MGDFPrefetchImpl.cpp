@@ -0,0 +1,97 @@
+#include "StdAfx.h"
+
+#include "MGDFPrefetchImpl.hpp"
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+PrefetchImpl::PrefetchImpl( PrefetchPriority priority, bool hasHandle )
+	: _priority( priority )
+	, _cancelled( false )
+	, _prefetched( 0 )
+	, _complete( false )
+	, _pending( 0 )
+	, _references( hasHandle ? 2 : 1 )
+{
+}
+
+bool PrefetchImpl::IsComplete() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return _complete;
+}
+
+void PrefetchImpl::Wait()
+{
+	std::unique_lock<std::mutex> lock( _mutex );
+	_completed.wait( lock, [this]() {
+		return _complete;
+	} );
+}
+
+void PrefetchImpl::Cancel()
+{
+	_cancelled = true;
+}
+
+UINT32 PrefetchImpl::GetPrefetchedCount() const
+{
+	return _prefetched;
+}
+
+void PrefetchImpl::Dispose()
+{
+	Release();
+}
+
+void PrefetchImpl::Release()
+{
+	bool destroy;
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+		destroy = --_references == 0;
+	}
+	if ( destroy ) {
+		delete this;
+	}
+}
+
+void PrefetchImpl::AddPending()
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	_ASSERTE( !_complete );
+	++_pending;
+}
+
+void PrefetchImpl::CompletePending( bool prefetched )
+{
+	if ( prefetched ) {
+		++_prefetched;
+	}
+
+	bool complete;
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+		_ASSERTE( _pending );
+		complete = --_pending == 0;
+		_complete = complete;
+	}
+	if ( complete ) {
+		_completed.notify_all();
+		Release();
+	}
+}
+
+}
+}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <MGDF/MGDF.hpp>
+#include <MGDF/MGDFVirtualFileSystem.hpp>
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+/**
+a prefetch which is queued on the vfs prefetch pool. Every file or folder queued as part of the prefetch is tracked as pending,
+the prefetch is complete once nothing is pending. The prefetch is referenced by the pool until it is complete and by the
+caller until the handle is disposed (if the caller asked for a handle)
+*/
+class PrefetchImpl : public IPrefetch
+{
+public:
+	PrefetchImpl( PrefetchPriority priority, bool hasHandle );
+	virtual ~PrefetchImpl() {}
+
+	bool IsComplete() const override final;
+	void Wait() override final;
+	void Cancel() override final;
+	UINT32 GetPrefetchedCount() const override final;
+	void Dispose() override final;
+
+	PrefetchPriority GetPriority() const {
+		return _priority;
+	}
+	bool IsCancelled() const {
+		return _cancelled;
+	}
+
+	/**
+	track another file or folder as pending, this must be called before the item is queued
+	*/
+	void AddPending();
+
+	/**
+	mark a pending item as done. Once nothing is pending the prefetch is complete and the pools reference is released
+	\param prefetched whether the item was a file which was prefetched
+	*/
+	void CompletePending( bool prefetched );
+private:
+	void Release();
+
+	PrefetchPriority _priority;
+	std::atomic<bool> _cancelled;
+	std::atomic<UINT32> _prefetched;
+
+	mutable std::mutex _mutex;
+	std::condition_variable _completed;
+	bool _complete;
+	UINT32 _pending;
+	UINT32 _references;
+};
+
+}
+}
+}
@@ -1,10 +1,15 @@
 #include "stdafx.h"
 
+#include <algorithm>
+
 #include "../common/MGDFLoggerImpl.hpp"
 #include "../common/MGDFResources.hpp"
 #include "MGDFVirtualFileSystemComponentImpl.hpp"
 #include "MGDFDefaultFileImpl.hpp"
 #include "MGDFDefaultFolderImpl.hpp"
+#include "MGDFOverlayFolderImpl.hpp"
+#include "MGDFOverlayFileImpl.hpp"
+#include "MGDFAsyncReadImpl.hpp"
 
 
 #if defined(_DEBUG)
@@ -21,6 +26,11 @@ namespace vfs
 
 using namespace std::filesystem;
 
+#define VFS_IO_THREADS 2
+#define VFS_PREFETCH_THREADS 2
+#define VFS_PREFETCH_PAGE_SIZE 4096
+#define VFS_PREFETCH_BUFFER_SIZE 65536
+
 IVirtualFileSystemComponent *CreateVirtualFileSystemComponentImpl()
 {
 	return new VirtualFileSystemComponent();
@@ -28,20 +38,83 @@ IVirtualFileSystemComponent *CreateVirtualFileSystemComponentImpl()
 
 VirtualFileSystemComponent::VirtualFileSystemComponent()
 	: _root( nullptr )
-	, _rootIsArchive( false )
+	, _pathIndex( nullptr )
+	, _arena( nullptr )
+	, _eagerMapping( false )
+	, _workers( nullptr )
+	, _ioWorkers( nullptr )
+	, _manifest( nullptr )
+	, _entryCache( nullptr )
+	, _watch( false )
+	, _watcher( nullptr )
+	, _trace( nullptr )
+	, _pathFilterEnabled( false )
+	, _pathFilter( nullptr )
+	, _pendingMaps( 0 )
+	, _mappingFailed( false )
+	, _prefetchSequence( 0 )
+	, _prefetchWorkers( nullptr )
 {
 }
 
 VirtualFileSystemComponent::~VirtualFileSystemComponent()
 {
-	if ( !_rootIsArchive ) {
-		delete static_cast<FileBaseImpl *>( _root );
+	//let any queued reads complete, as callers may be waiting on them
+	if ( _ioWorkers ) {
+		_ioWorkers->Wait();
+		delete _ioWorkers;
+	}
+
+	//stop any background mapping before the tree is torn down
+	delete _workers;
+
+	//any prefetching which hasn't started yet is abandoned, but must still be marked as done so the prefetches complete
+	delete _prefetchWorkers;
+	while ( !_prefetchQueue.empty() ) {
+		PrefetchImpl *prefetch = _prefetchQueue.top().prefetch;
+		_prefetchQueue.pop();
+		prefetch->CompletePending( false );
 	}
+	delete _watcher;
+
+	//the prefetch threads look up paths through the filter, so it can only go once they have stopped
+	PathFilter *pathFilter = _pathFilter.load();
+	if ( pathFilter ) {
+		LOG( "VFS path filter paths: " << pathFilter->GetPathCount() << " size: " << pathFilter->GetSizeInBytes() << " bytes expected false positive rate: " << pathFilter->GetFalsePositiveRate()
+		     << " rejected: " << pathFilter->GetRejected() << " false positives: " << pathFilter->GetFalsePositives(), LOG_LOW );
+		delete pathFilter;
+	}
+
+	if ( _trace ) {
+		_trace->Stop();
+		LOG( "Saving VFS access trace...", LOG_LOW );
+		if ( !_trace->Save( _traceFile ) ) {
+			LOG( "Unable to save VFS access trace to " << Resources::ToString( _traceFile ), LOG_ERROR );
+		}
+		delete _trace;
+	}
+
+	if ( _manifest ) {
+		if ( _manifest->IsDirty() ) {
+			LOG( "Saving VFS manifest...", LOG_LOW );
+			_manifest->Save( _manifestFile );
+		}
+		delete _manifest;
+	}
+	delete _pathIndex;
+
+	//all the nodes mapped from the filesystem are destroyed along with the arena
+	delete _arena;
 
 	for ( auto &archive : _mappedArchives ) {
 		archive.first->DisposeArchive( archive.second );
 	}
 
+	if ( _entryCache ) {
+		LOG( "VFS entry cache hits: " << _entryCache->GetHits() << " misses: " << _entryCache->GetMisses() << " evictions: " << _entryCache->GetEvictions(), LOG_LOW );
+		delete _entryCache;
+	}
+
 	for ( auto handler : _archiveHandlers ) {
 		handler->Dispose();
 	}
@@ -51,44 +124,760 @@ bool VirtualFileSystemComponent::Mount( const wchar_t *physicalDirectory )
 {
 	_ASSERTE( physicalDirectory );
 	_ASSERTE( !_root );
-	_root = Map( physicalDirectory, nullptr );
+	_arena = new Arena();
+
+	for ( auto handler : _archiveHandlers ) {
+		ICachingArchiveHandler *cachingHandler = dynamic_cast<ICachingArchiveHandler *>( handler );
+		if ( cachingHandler ) {
+			cachingHandler->SetEntryCache( _entryCache );
+		}
+	}
+
+	if ( _watch ) {
+		_watcher = new ChangeWatcher();
+	}
+
+	_root = Map( physicalDirectory, nullptr, is_directory( physicalDirectory ) );
+	Watch( physicalDirectory, _root );
+
+	if ( _root && !_overlays.empty() ) {
+		//the topmost layer comes first, as it shadows all the layers below it
+		std::vector<IFile *> layers;
+		for ( auto it = _overlays.rbegin(); it != _overlays.rend(); ++it ) {
+			if ( !exists( *it ) ) {
+				LOG( "Unable to mount overlay " << Resources::ToString( *it ), LOG_ERROR );
+				continue;
+			}
+			layers.push_back( Map( *it, nullptr, is_directory( *it ) ) );
+			Watch( *it, layers.back() );
+		}
+		if ( !layers.empty() ) {
+			layers.push_back( _root );
+			_root = _arena->New<OverlayFolderImpl>( layers.data(), layers.size(), nullptr, _arena, this );
+		}
+	}
+
+	if ( _root && _pathIndex ) {
+		if ( _root->IsArchive() ) {
+			//archives are mapped in their entirety up front, so the whole tree can be indexed now
+			_pathIndex->AddTree( L"", _root );
+		} else {
+			_pathIndex->Add( L"", _root );
+		}
+	}
+
+	if ( _root && ( _eagerMapping || _pathFilterEnabled ) && _root->IsFolder() && !_root->IsArchive() ) {
+		UINT32 threads = std::thread::hardware_concurrency();
+		_workers = new WorkerPool( threads > 1 ? threads - 1 : 1 );
+		LOG( "Mapping VFS content using " << _workers->GetThreadCount() << " background threads", LOG_LOW );
+		QueueMapTree( _root );
+	} else if ( _root && _pathFilterEnabled ) {
+		//archives are mapped in their entirety up front, so the filter can be built straight away
+		BuildPathFilter();
+	}
+
+	if ( _watcher ) {
+		LOG( "Watching " << _watchedLayers.size() << " VFS content folders for changes", LOG_LOW );
+		_watcher->Start();
+	}
 	return _root != nullptr;
 }
 
+void VirtualFileSystemComponent::AddOverlay( const wchar_t *physicalPath )
+{
+	_ASSERTE( physicalPath );
+	_ASSERTE( !_root );
+	_overlays.push_back( physicalPath );
+}
+
+void VirtualFileSystemComponent::EnableWatcher( bool enabled )
+{
+	_ASSERTE( !_root );
+	_watch = enabled;
+}
+
+void VirtualFileSystemComponent::Watch( const std::wstring &physicalPath, IFile *layer )
+{
+	//only folders are watched, archives are watched as part of the folder which contains them
+	if ( _watcher && layer && is_directory( physicalPath ) && _watcher->Watch( physicalPath ) >= 0 ) {
+		WatchedLayer watched;
+		watched.root = layer;
+		watched.physicalPath = physicalPath;
+		_watchedLayers.push_back( watched );
+	}
+}
+
+//finds a node without mapping any of the folders on the way to it
+static IFile *FindMapped( IFile *root, const std::wstring &logicalPath )
+{
+	IFile *node = root;
+	size_t start = 0;
+	while ( node && start < logicalPath.size() ) {
+		size_t end = logicalPath.find( L'/', start );
+		if ( end == std::wstring::npos ) end = logicalPath.size();
+
+		const FileBaseImpl *file = dynamic_cast<const FileBaseImpl *>( node );
+		const ChildList *children = file ? file->GetMappedChildren() : nullptr;
+		node = children ? children->Find( logicalPath.substr( start, end - start ).c_str() ) : nullptr;
+		start = end + 1;
+	}
+	return node;
+}
+
+//hashes the logical path of a node and everything beneath it, without building any of the paths
+static void HashTree( IFile *node, UINT64 hash, std::vector<UINT64> &hashes )
+{
+	std::vector<std::pair<IFile *, UINT64>> pending;
+	pending.push_back( std::make_pair( node, hash ) );
+	std::vector<IFile *> children;
+	while ( !pending.empty() ) {
+		auto next = pending.back();
+		pending.pop_back();
+		hashes.push_back( next.second );
+
+		size_t length = next.first->GetChildCount();
+		if ( !length ) continue;
+		children.resize( length );
+		next.first->GetAllChildren( nullptr, children.data(), &length );
+		for ( size_t i = 0; i < length; ++i ) {
+			pending.push_back( std::make_pair( children[i], PathFilter::Append( next.second, children[i]->GetName() ) ) );
+		}
+	}
+}
+
+void VirtualFileSystemComponent::ProcessChanges( std::vector<std::wstring> &changedPaths )
+{
+	changedPaths.clear();
+	if ( !_watcher ) return;
+
+	std::vector<ChangeWatcher::Change> changes;
+	_watcher->GetChanges( changes );
+	for ( auto &change : changes ) {
+		const WatchedLayer &layer = _watchedLayers[change.directory];
+		if ( change.type == ChangeWatcher::RESCAN ) {
+			RemapLayer( layer.root );
+			changedPaths.push_back( L"" );
+			continue;
+		}
+
+		path physicalPath( path( layer.physicalPath ) / change.path );
+		physicalPath.make_preferred();
+
+		if ( change.type == ChangeWatcher::MODIFIED ) {
+			//folders are reported as modified when thier contents change, but the changes to the contents are also reported
+			if ( is_directory( physicalPath ) ) continue;
+			//files are read from disk each time they are opened, so only archives need to be remapped when they are modified
+			if ( !GetArchiveHandler( physicalPath.wstring() ) ) {
+				FileBaseImpl *file = dynamic_cast<FileBaseImpl *>( FindMapped( layer.root, change.path ) );
+				if ( file ) {
+					file->InvalidateMetadata();
+				}
+				changedPaths.push_back( change.path );
+				continue;
+			}
+		}
+		ApplyChange( layer.root, change.path, physicalPath );
+		changedPaths.push_back( change.path );
+	}
+
+	//files are often reported as modified more than once while they are being written
+	std::sort( changedPaths.begin(), changedPaths.end() );
+	changedPaths.erase( std::unique( changedPaths.begin(), changedPaths.end() ), changedPaths.end() );
+}
+
+//replaces (or removes) a single child of a folder in one of the mounted layers
+void VirtualFileSystemComponent::ApplyChange( IFile *layer, const std::wstring &logicalPath, const path &physicalPath )
+{
+	size_t split = logicalPath.find_last_of( L'/' );
+	std::wstring folderPath = split == std::wstring::npos ? L"" : logicalPath.substr( 0, split );
+	std::wstring name = split == std::wstring::npos ? logicalPath : logicalPath.substr( split + 1 );
+
+	//folders which haven't been mapped yet will pick up the change when they are mapped
+	DefaultFolderImpl *folder = dynamic_cast<DefaultFolderImpl *>( FindMapped( layer, folderPath ) );
+	const ChildList *previous = folder ? folder->GetMappedChildren() : nullptr;
+	if ( !previous ) return;
+
+	const bool indexChildren = _pathIndex && _overlays.empty();
+	if ( indexChildren ) {
+		_pathIndex->Remove( logicalPath );
+	}
+
+	//all the other children are kept as they are, so nothing else in the folder needs to be remapped
+	ChildList *children = _arena->New<ChildList>( _arena );
+	IFile *removed = nullptr;
+	for ( auto &child : *previous ) {
+		if ( name != child.name ) {
+			children->Add( child.file );
+		} else {
+			removed = child.file;
+		}
+	}
+	IFile *mappedChild = nullptr;
+	if ( exists( physicalPath ) ) {
+		mappedChild = Map( physicalPath, folder, is_directory( physicalPath ) );
+		children->Add( mappedChild );
+		if ( indexChildren ) {
+			IndexChild( folderPath, mappedChild );
+		}
+	}
+	children->Freeze();
+	{
+		//removed paths are left in the path filter, they just become false positives
+		std::lock_guard<std::mutex> lock( _pathFilterMutex );
+		folder->ReplaceChildren( children );
+		PathFilter *pathFilter = _pathFilter.load( std::memory_order_acquire );
+		if ( pathFilter && mappedChild ) {
+			std::vector<UINT64> hashes;
+			HashTree( mappedChild, PathFilter::Hash( logicalPath.c_str() ), hashes );
+			for ( auto hash : hashes ) {
+				pathFilter->Add( hash );
+			}
+		}
+	}
+	if ( removed ) {
+		ReleaseCachedEntries( removed );
+	}
+
+	//if the folder is merged with folders in other layers, the merged children need to be merged again.
+	//Any already mapped subfolders which aren't remerged won't be reindexed, so lookups in them fall back to walking the tree
+	if ( !_overlays.empty() ) {
+		OverlayFolderImpl *overlay = dynamic_cast<OverlayFolderImpl *>( FindMapped( _root, folderPath ) );
+		if ( overlay ) {
+			if ( _pathIndex ) {
+				_pathIndex->RemoveChildren( folderPath );
+			}
+			overlay->Invalidate();
+		}
+	}
+}
+
+//replaces everything in one of the mounted layers, when the changes made to it aren't known
+void VirtualFileSystemComponent::RemapLayer( IFile *layer )
+{
+	DefaultFolderImpl *folder = dynamic_cast<DefaultFolderImpl *>( layer );
+	if ( !folder ) return;
+
+	//all the archives in the layer are mapped again, so none of thier cached entries will be used again
+	ReleaseCachedEntries( folder );
+
+	const bool indexChildren = _pathIndex && _overlays.empty();
+	if ( indexChildren ) {
+		_pathIndex->RemoveChildren( L"" );
+	}
+
+	//only the children of the layer are mapped straight away, the new subfolders are mapped as they are needed
+	ChildList *children = _arena->New<ChildList>( _arena );
+	try {
+		if ( is_directory( folder->GetPhysicalPath() ) ) {
+			MapChildren( folder, *children );
+		}
+	} catch ( const filesystem_error &err ) {
+		LOG( "Unable to remap " << Resources::ToString( folder->GetPhysicalPath() ) << " - " << err.what(), LOG_ERROR );
+	}
+	children->Freeze();
+	{
+		//removed paths are left in the path filter, they just become false positives
+		std::lock_guard<std::mutex> lock( _pathFilterMutex );
+		folder->ReplaceChildren( children );
+		PathFilter *pathFilter = _pathFilter.load( std::memory_order_acquire );
+		if ( pathFilter ) {
+			std::vector<UINT64> hashes;
+			HashTree( folder, PathFilter::EMPTY_HASH, hashes );
+			for ( auto hash : hashes ) {
+				pathFilter->Add( hash );
+			}
+		}
+	}
+
+	//the whole merged tree is merged again, as any folder in it may contain content from this layer
+	OverlayFolderImpl *overlay = dynamic_cast<OverlayFolderImpl *>( _root );
+	if ( overlay ) {
+		if ( _pathIndex ) {
+			_pathIndex->RemoveChildren( L"" );
+		}
+		overlay->Invalidate();
+	}
+}
+
+void VirtualFileSystemComponent::ReleaseCachedEntries( IFile *removed )
+{
+	if ( !_entryCache ) return;
+
+	//the removed nodes are left in the arena as callers may still hold them, but any archives under them can
+	//no longer be found so thier cached entries would only take up space in the cache
+	std::lock_guard<std::mutex> lock( _mappedArchivesMutex );
+	for ( auto &archive : _mappedArchives ) {
+		for ( IFile *node = archive.second; node; node = node->GetParent() ) {
+			if ( node == removed ) {
+				_entryCache->Remove( archive.second );
+				break;
+			}
+		}
+	}
+}
+
+void VirtualFileSystemComponent::EnableManifest( const wchar_t *manifestFile )
+{
+	_ASSERTE( !_root );
+	delete _manifest;
+	_manifest = nullptr;
+
+	if ( manifestFile ) {
+		_manifestFile = manifestFile;
+		_manifest = new Manifest();
+		if ( !_manifest->Load( _manifestFile ) ) {
+			LOG( "No valid VFS manifest found, content will be fully scanned", LOG_LOW );
+		}
+	}
+}
+
+void VirtualFileSystemComponent::EnableTrace( const wchar_t *traceFile )
+{
+	delete _trace;
+	_trace = nullptr;
+
+	if ( traceFile ) {
+		_traceFile = traceFile;
+		_trace = new AccessTrace();
+		if ( !_trace->Start() ) {
+			LOG( "Unable to record a VFS access trace, another trace is already recording", LOG_ERROR );
+			delete _trace;
+			_trace = nullptr;
+		}
+	}
+}
+
+void VirtualFileSystemComponent::EnableEntryCache( size_t budget )
+{
+	_ASSERTE( !_root );
+	delete _entryCache;
+	_entryCache = budget ? new EntryCache( budget ) : nullptr;
+}
+
+void VirtualFileSystemComponent::EnableEagerMapping( bool enabled )
+{
+	_ASSERTE( !_root );
+	_eagerMapping = enabled;
+}
+
+void VirtualFileSystemComponent::EnablePathFilter( bool enabled )
+{
+	_ASSERTE( !_root );
+	_pathFilterEnabled = enabled;
+}
+
+void VirtualFileSystemComponent::WaitForMapping()
+{
+	if ( _workers ) {
+		_workers->Wait();
+	}
+}
+
+MGDFError VirtualFileSystemComponent::ReadAsync( IFile *file, INT64 offset, UINT64 length, void *buffer, IReadCompletionHandler *handler, IAsyncRead **read )
+{
+	if ( !file || !buffer ) {
+		return MGDF_ERR_INVALID_PARAMETER;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( _ioWorkersMutex );
+		if ( !_ioWorkers ) {
+			_ioWorkers = new WorkerPool( VFS_IO_THREADS );
+		}
+	}
+
+	AsyncReadImpl *asyncRead = new AsyncReadImpl( file, offset, length, buffer, handler, read != nullptr );
+	if ( read ) {
+		*read = asyncRead;
+	}
+	bool queued = _ioWorkers->Submit( [asyncRead]() {
+		asyncRead->Execute();
+	} );
+	if ( !queued ) {
+		//the vfs is being destroyed, so complete the read on this thread rather than leave it pending
+		asyncRead->Execute();
+	}
+	return MGDF_OK;
+}
+
+MGDFError VirtualFileSystemComponent::Prefetch( const wchar_t * const *logicalPaths, UINT32 count, PrefetchPriority priority, IPrefetch **prefetch )
+{
+	if ( !logicalPaths || !count ) {
+		return MGDF_ERR_INVALID_PARAMETER;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( _prefetchMutex );
+		if ( !_prefetchWorkers ) {
+			_prefetchWorkers = new WorkerPool( VFS_PREFETCH_THREADS );
+		}
+	}
+
+	PrefetchImpl *prefetchImpl = new PrefetchImpl( priority, prefetch != nullptr );
+	if ( prefetch ) {
+		*prefetch = prefetchImpl;
+	}
+	//the paths are looked up on the prefetch threads, as looking them up may require mapping folders. The prefetch is
+	//kept pending until every path is queued, otherwise it could complete (and be released) before the last path is queued
+	prefetchImpl->AddPending();
+	for ( UINT32 i = 0; i < count; ++i ) {
+		QueuePrefetch( prefetchImpl, nullptr, logicalPaths[i] ? logicalPaths[i] : L"" );
+	}
+	prefetchImpl->CompletePending( false );
+	return MGDF_OK;
+}
+
+MGDFError VirtualFileSystemComponent::Query( const wchar_t *pattern, IFileQuery **query )
+{
+	if ( !pattern || !query ) {
+		return MGDF_ERR_INVALID_PARAMETER;
+	}
+
+	GlobPattern glob;
+	if ( !glob.Compile( pattern ) ) {
+		return MGDF_ERR_INVALID_PARAMETER;
+	}
+	*query = new FileQueryImpl( this, glob );
+	return MGDF_OK;
+}
+
+void VirtualFileSystemComponent::QueuePrefetch( PrefetchImpl *prefetch, IFile *file, const wchar_t *path )
+{
+	prefetch->AddPending();
+	{
+		std::lock_guard<std::mutex> lock( _prefetchMutex );
+		PrefetchItem item;
+		item.prefetch = prefetch;
+		item.file = file;
+		if ( path ) item.path = path;
+		item.sequence = _prefetchSequence++;
+		_prefetchQueue.push( item );
+	}
+	//each task prefetches whichever item has the highest priority when it runs, rather than the item queued along with it.
+	//If the pool is stopping the item is left in the queue, which is drained when the vfs is destroyed
+	_prefetchWorkers->Submit( [this]() {
+		PrefetchNext();
+	} );
+}
+
+void VirtualFileSystemComponent::PrefetchNext()
+{
+	PrefetchItem item;
+	{
+		std::lock_guard<std::mutex> lock( _prefetchMutex );
+		if ( _prefetchQueue.empty() ) return;
+		item = _prefetchQueue.top();
+		_prefetchQueue.pop();
+	}
+
+	bool prefetched = false;
+	if ( !item.prefetch->IsCancelled() ) {
+		IFile *file = item.file ? item.file : GetFile( item.path.c_str() );
+		if ( file ) {
+			//getting the children of a folder maps it, and everything in folders and archives is prefetched along with them
+			size_t length = file->GetChildCount();
+			if ( length ) {
+				std::vector<IFile *> children( length );
+				file->GetAllChildren( nullptr, children.data(), &length );
+				for ( size_t i = 0; i < length; ++i ) {
+					QueuePrefetch( item.prefetch, children[i], nullptr );
+				}
+			} else if ( !file->IsFolder() ) {
+				prefetched = PrefetchFile( item.prefetch, file );
+			}
+		}
+	}
+	item.prefetch->CompletePending( prefetched );
+}
+
+bool VirtualFileSystemComponent::PrefetchFile( PrefetchImpl *prefetch, IFile *file )
+{
+	//opening archive entries decompresses them into the entry cache (if enabled)
+	IFileReader *reader = nullptr;
+	if ( file->Open( &reader ) != MGDF_OK ) {
+		return false;
+	}
+
+	const IFileView *view = reader->GetView();
+	if ( view ) {
+		//touch every page of the view so they are resident when the file is next opened
+		const volatile char *data = static_cast<const volatile char *>( view->GetData() );
+		volatile char touched = 0;
+		for ( INT64 offset = 0; offset < view->GetDataSize(); offset += VFS_PREFETCH_PAGE_SIZE ) {
+			touched = data[offset];
+		}
+	} else {
+		//readers without a view decompress or read from disk as they go, so the only way to warm them up is to read them through
+		std::vector<char> buffer( VFS_PREFETCH_BUFFER_SIZE );
+		while ( !prefetch->IsCancelled() && reader->Read( buffer.data(), buffer.size() ) ) {
+		}
+	}
+	reader->Close();
+	return true;
+}
+
+//maps the children of a folder, then queues up the mapping of each of its subfolders.
+//archives are mapped in their entirety as soon as they are found so they need no further work
+void VirtualFileSystemComponent::MapTree( IFile *folder )
+{
+	size_t length = 0;
+	try {
+		length = folder->GetChildCount();
+	} catch ( const filesystem_error &err ) {
+		LOG( "Unable to map " << Resources::ToString( folder->GetPhysicalPath() ) << " - " << err.what(), LOG_ERROR );
+		_mappingFailed = true;
+		return;
+	}
+	if ( !length ) return;
+
+	std::vector<IFile *> children( length );
+	folder->GetAllChildren( nullptr, children.data(), &length );
+	for ( size_t i = 0; i < length; ++i ) {
+		IFile *child = children[i];
+		if ( child->IsFolder() && !child->IsArchive() ) {
+			QueueMapTree( child );
+		}
+	}
+}
+
+//the subfolders are queued before each folders task completes, so the count only drops to zero once the whole tree has been mapped
+void VirtualFileSystemComponent::QueueMapTree( IFile *folder )
+{
+	_pendingMaps.fetch_add( 1 );
+	bool queued = _workers->Submit( [this, folder]() {
+		MapTree( folder );
+		if ( _pendingMaps.fetch_sub( 1 ) == 1 && _pathFilterEnabled ) {
+			BuildPathFilter();
+		}
+	} );
+	if ( !queued ) {
+		//the vfs is being destroyed, so the rest of the tree is never mapped
+		_pendingMaps.fetch_sub( 1 );
+	}
+}
+
+void VirtualFileSystemComponent::BuildPathFilter()
+{
+	//any paths in folders which couldn't be mapped would be missing, so lookups in them would wrongly fail
+	if ( _mappingFailed ) {
+		LOG( "Unable to build VFS path filter as some content could not be mapped", LOG_ERROR );
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock( _pathFilterMutex );
+	std::vector<UINT64> hashes;
+	try {
+		HashTree( _root, PathFilter::EMPTY_HASH, hashes );
+	} catch ( const filesystem_error &err ) {
+		LOG( "Unable to build VFS path filter - " << err.what(), LOG_ERROR );
+		return;
+	}
+
+	PathFilter *pathFilter = new PathFilter( hashes.size() );
+	for ( auto hash : hashes ) {
+		pathFilter->Add( hash );
+	}
+	LOG( "Built VFS path filter for " << hashes.size() << " paths using " << pathFilter->GetSizeInBytes() << " bytes", LOG_LOW );
+	_pathFilter.store( pathFilter, std::memory_order_release );
+}
+
+void VirtualFileSystemComponent::EnablePathIndex( bool enabled )
+{
+	_ASSERTE( !_root );
+	if ( enabled && !_pathIndex ) {
+		_pathIndex = new PathIndex();
+	} else if ( !enabled ) {
+		delete _pathIndex;
+		_pathIndex = nullptr;
+	}
+}
+
+//builds the logical path of a file without using IFile::GetLogicalPath as
+//that would require acquiring the file mutex which may already be held
+static void GetLogicalPathUnsafe( const IFile *file, std::wstring &path )
+{
+	const IFile *parent = file->GetParent();
+	if ( !parent ) return;
+	GetLogicalPathUnsafe( parent, path );
+	if ( !path.empty() ) path += '/';
+	path += file->GetName();
+}
+
 //used by folders to lazily enumerate thier children as needed.
-void VirtualFileSystemComponent::MapChildren( DefaultFolderImpl *parent, std::map<const wchar_t *, IFile *, WCharCmp> &children )
+void VirtualFileSystemComponent::MapChildren( DefaultFolderImpl *parent, ChildList &children )
 {
 	_ASSERTE( parent );
 	path path( parent->GetPhysicalPath() );
 	_ASSERTE( is_directory( path ) );
 
+	std::wstring parentPath;
+	bool indexChildren = false;
+	if ( _pathIndex ) {
+		GetLogicalPathUnsafe( parent, parentPath );
+		//when overlays are mounted the folders in each layer are only visible through the overlay folders
+		//which merge them, so thier children are indexed as the overlay folders are merged instead
+		indexChildren = _overlays.empty();
+	}
+
+	INT64 lastWriteTime = 0;
+	std::vector<ManifestEntry> entries;
+	if ( _manifest ) {
+		//if the folder hasn't changed since it was recorded in the manifest, then
+		//its children can be mapped without enumerating the folder again. Files can be modified without changing the
+		//last write time of thier folder, so the size and last write time of each child are read from disk when first needed
+		lastWriteTime = Manifest::GetLastWriteTime( path );
+		if ( _manifest->GetRecord( parent->GetPhysicalPath(), lastWriteTime, 0, entries ) ) {
+			for ( auto &entry : entries ) {
+				IFile *mappedChild = Map( path / entry.name, parent, ( entry.flags & ManifestEntry::FOLDER ) != 0 );
+				_ASSERTE( mappedChild );
+				children.Add( mappedChild );
+				if ( indexChildren ) {
+					IndexChild( parentPath, mappedChild );
+				}
+			}
+			return;
+		}
+	}
+
 	directory_iterator end_itr; // default construction yields past-the-end
 	for ( directory_iterator itr( path ); itr != end_itr; ++itr ) {
-		IFile *mappedChild = Map( ( *itr ).path(), parent );
+		//the directory entry caches the file attributes found while enumerating the folder
+		const bool isDirectory = itr->is_directory();
+		IFile *mappedChild = Map( ( *itr ).path(), parent, isDirectory, &*itr );
 		_ASSERTE( mappedChild );
-		children.insert( std::pair<const wchar_t *, IFile *> ( mappedChild->GetName(), mappedChild ) );
+		children.Add( mappedChild );
+		if ( indexChildren ) {
+			IndexChild( parentPath, mappedChild );
+		}
+		if ( _manifest ) {
+			ManifestEntry entry;
+			entry.name = mappedChild->GetName();
+			entry.flags = isDirectory ? ManifestEntry::FOLDER : 0;
+			entry.size = 0;
+			entry.position = 0;
+			entry.index = 0;
+			entry.lastWriteTime = 0;
+			entries.push_back( entry );
+		}
+	}
+
+	if ( _manifest ) {
+		_manifest->AddRecord( parent->GetPhysicalPath(), lastWriteTime, 0, entries );
 	}
 }
 
+//merges the children of the same folder in each layer
+void VirtualFileSystemComponent::MapOverlayChildren( OverlayFolderImpl *parent, ChildList &children )
+{
+	_ASSERTE( parent );
 
-IFile *VirtualFileSystemComponent::Map( const path &path, IFile *parent )
+	std::wstring parentPath;
+	bool indexChildren = false;
+	if ( _pathIndex ) {
+		GetLogicalPathUnsafe( parent, parentPath );
+		indexChildren = _pathIndex->Find( parentPath.c_str() ) == parent;
+	}
+
+	//the layers are ordered from the top down so the first child found with each name is the one which is
+	//visible, unless it is a folder in which case any folders with the same name in the layers below are merged with it
+	struct MergedChild {
+		IFile *child;
+		std::vector<IFile *> folders;
+	};
+	std::vector<MergedChild> merged;
+	std::unordered_map<const wchar_t *, size_t, WCharHash, WCharEqual> names;
+	std::vector<IFile *> layerChildren;
+
+	for ( size_t i = 0; i < parent->GetLayerCount(); ++i ) {
+		IFile *layer = parent->GetLayers()[i];
+		size_t length = layer->GetChildCount();
+		if ( !length ) continue;
+
+		layerChildren.resize( length );
+		layer->GetAllChildren( nullptr, layerChildren.data(), &length );
+		for ( size_t j = 0; j < length; ++j ) {
+			IFile *child = layerChildren[j];
+			auto found = names.find( child->GetName() );
+			if ( found == names.end() ) {
+				names.insert( std::make_pair( child->GetName(), merged.size() ) );
+				merged.push_back( MergedChild() );
+				merged.back().child = child;
+				if ( child->IsFolder() ) merged.back().folders.push_back( child );
+			} else if ( child->IsFolder() && merged[found->second].child->IsFolder() ) {
+				merged[found->second].folders.push_back( child );
+			}
+		}
+	}
+
+	//the layer nodes are already visible to other threads (and may be visible through other overlay folders), so rather than
+	//reparenting them every child is wrapped in a node whose parent is this folder
+	for ( auto &entry : merged ) {
+		IFile *child = nullptr;
+		if ( !entry.folders.empty() ) {
+			child = _arena->New<OverlayFolderImpl>( entry.folders.data(), entry.folders.size(), parent, _arena, this );
+		} else {
+			child = _arena->New<OverlayFileImpl>( entry.child, parent );
+		}
+		children.Add( child );
+		if ( indexChildren ) {
+			IndexChild( parentPath, child );
+		}
+	}
+}
+
+void VirtualFileSystemComponent::IndexChild( const std::wstring &parentPath, IFile *child )
+{
+	std::wstring childPath( parentPath );
+	if ( !childPath.empty() ) childPath += '/';
+	childPath += child->GetName();
+
+	// folders are indexed as they are lazily mapped, but
+	// archives are fully mapped so can be indexed right away
+	if ( child->IsArchive() ) {
+		_pathIndex->AddTree( childPath, child );
+	} else {
+		_pathIndex->Add( childPath, child );
+	}
+}
+
+
+//the size and last write time are cached in the directory entry, so they can be recorded without touching the disk again
+static void SetMetadata( FileBaseImpl *node, bool isDirectory, const directory_entry &entry )
+{
+	std::error_code sizeError, timeError;
+	const INT64 size = isDirectory ? 0 : static_cast<INT64>( entry.file_size( sizeError ) );
+	const INT64 lastWriteTime = static_cast<INT64>( entry.last_write_time( timeError ).time_since_epoch().count() );
+	if ( !sizeError && !timeError ) {
+		node->SetMetadata( size, lastWriteTime );
+	}
+}
+
+IFile *VirtualFileSystemComponent::Map( const path &path, IFile *parent, bool isDirectory, const directory_entry *entry )
 {
-	//wpath path( physicalPath );
-	if ( is_directory( path ) ) {
-		return new DefaultFolderImpl( path.filename(), path.wstring(), parent, this );
+	if ( isDirectory ) {
+		DefaultFolderImpl *folder = _arena->New<DefaultFolderImpl>( _arena->Intern( path.filename().wstring() ), _arena->Copy( path.wstring() ), parent, _arena, this );
+		if ( entry ) {
+			SetMetadata( folder, true, *entry );
+		}
+		return folder;
 	} else {
 		//if its an archive
 		IArchiveHandler *archiveHandler = GetArchiveHandler( path.wstring() );
 		if ( archiveHandler ) {
 			auto filename = path.filename();
 			auto fullpath = path.wstring();
-			IFile *mappedFile = archiveHandler->MapArchive(
-									filename.c_str(),
-			                        fullpath.c_str(),
-			                        parent ); //replace it with the mapped archive tree
+			//replace it with the mapped archive tree
+			IManifestArchiveHandler *manifestHandler = _manifest ? dynamic_cast<IManifestArchiveHandler *>( archiveHandler ) : nullptr;
+			IFile *mappedFile = manifestHandler
+			                    ? manifestHandler->MapArchive( filename.c_str(), fullpath.c_str(), parent, _manifest )
+			                    : archiveHandler->MapArchive( filename.c_str(), fullpath.c_str(), parent );
 			if ( mappedFile ) {
-				if ( parent == nullptr ) _rootIsArchive = true;
+				FileBaseImpl *node = entry ? dynamic_cast<FileBaseImpl *>( mappedFile ) : nullptr;
+				if ( node ) {
+					SetMetadata( node, false, *entry );
+				}
 				//store the archive, so we can pass it back to its handler to clean it up later.
+				std::lock_guard<std::mutex> lock( _mappedArchivesMutex );
 				_mappedArchives.insert( std::pair<IArchiveHandler *, IFile *> ( archiveHandler, mappedFile ) );
 				return mappedFile;
 			} else {
@@ -97,7 +886,11 @@ IFile *VirtualFileSystemComponent::Map( const path &path, IFile *parent )
 		}
 
 		//otherwise its just a plain old file
-		return new DefaultFileImpl( path.filename(), path.wstring(), parent, _errorHandler );
+		DefaultFileImpl *file = _arena->New<DefaultFileImpl>( _arena->Intern( path.filename().wstring() ), _arena->Copy( path.wstring() ), parent, _arena, _errorHandler );
+		if ( entry ) {
+			SetMetadata( file, false, *entry );
+		}
+		return file;
 	}
 }
 
@@ -115,7 +908,21 @@ IFile *VirtualFileSystemComponent::GetFile( const wchar_t *logicalPath ) const
 {
 	if ( !logicalPath ) return _root;
 
+	if ( _pathIndex ) {
+		IFile *indexed = _pathIndex->Find( logicalPath );
+		if ( indexed ) return indexed;
+		//not found, the path may be in a part of the tree which
+		//hasn't been mapped yet so fall back to walking the tree
+	}
+
+	//until the whole tree has been mapped there is no filter, and every lookup walks the tree
+	const PathFilter *pathFilter = _pathFilter.load( std::memory_order_acquire );
+	if ( pathFilter && !pathFilter->MayContain( PathFilter::Hash( logicalPath ) ) ) {
+		return nullptr;
+	}
+
 	IFile *node = _root;
+	bool archiveChecked = false;
 
 	wchar_t *context = 0;
 	size_t destinationLength = wcslen( logicalPath ) + 1;
@@ -124,12 +931,25 @@ IFile *VirtualFileSystemComponent::GetFile( const wchar_t *logicalPath ) const
 	wchar_t *components = wcstok_s( copy, L"/", &context );
 
 	while ( components ) {
+		if ( !archiveChecked && node->IsArchive() ) {
+			//archives which index thier own entries can find the rest of the path in a single lookup
+			archiveChecked = true;
+			const IIndexedArchive *archive = dynamic_cast<const IIndexedArchive *>( node );
+			IFile *found = archive ? archive->FindFile( logicalPath + ( components - copy ) ) : nullptr;
+			if ( found ) {
+				node = found;
+				break;
+			}
+		}
 		node = node->GetChild( components );
 		if ( !node ) break;
 		components = wcstok_s( 0, L"/", &context );
 	}
 
 	delete[] copy;
+	if ( pathFilter && !node ) {
+		pathFilter->RecordFalsePositive();
+	}
 	return node;//return the node found (if any)
 }
 
@@ -3,11 +3,24 @@
 #include <filesystem>
 #include <vector>
 #include <map>
+#include <mutex>
+#include <queue>
 
 #include <MGDF/MGDF.hpp>
 #include <MGDF/MGDFVirtualFileSystem.hpp>
 
 #include "../common/MGDFSystemComponent.hpp"
+#include "MGDFPathIndex.hpp"
+#include "MGDFArena.hpp"
+#include "MGDFFileBaseImpl.hpp"
+#include "MGDFWorkerPool.hpp"
+#include "MGDFManifest.hpp"
+#include "MGDFEntryCache.hpp"
+#include "MGDFChangeWatcher.hpp"
+#include "MGDFPrefetchImpl.hpp"
+#include "MGDFFileQueryImpl.hpp"
+#include "MGDFAccessTrace.hpp"
+#include "MGDFPathFilter.hpp"
 
 namespace MGDF
 {
@@ -21,11 +34,89 @@ class IVirtualFileSystemComponent: public ISystemComponent, public IVirtualFileS
 public:
 	virtual ~IVirtualFileSystemComponent() {}
 	virtual bool Mount( const wchar_t * physicalDirectory ) = 0;
+
+	/**
+	add a layer which is mounted over the top of the content when the vfs is mounted. Layers are applied in the order
+	they are added, and any file in a layer shadows a file with the same logical path in the content or in any layer added
+	before it. Folders with the same logical path in more than one layer are merged. This must be called before the vfs is mounted
+	\param physicalPath a directory or archive (e.g. a patch pack) to mount as a layer
+	*/
+	virtual void AddOverlay( const wchar_t *physicalPath ) = 0;
 	virtual void RegisterArchiveHandler( IArchiveHandler * ) = 0;
+	virtual void EnablePathIndex( bool enabled ) = 0;
+
+	/**
+	when enabled, the whole content tree is mapped by a pool of background threads as soon as it is mounted,
+	rather than each folder being mapped on demand the first time its children are requested. This must be
+	set before the vfs is mounted
+	*/
+	virtual void EnableEagerMapping( bool enabled ) = 0;
+
+	/**
+	when a manifest file is supplied, the contents of every folder and archive mapped are recorded in the manifest
+	which is saved when the vfs is destroyed. On subsequent runs any folder or archive which hasn't changed since
+	it was recorded is mapped from the manifest rather than being scanned again. This must be set before the
+	vfs is mounted
+	\param manifestFile the file to load the manifest from and save it to, or nullptr to disable the manifest
+	*/
+	virtual void EnableManifest( const wchar_t *manifestFile ) = 0;
+
+	/**
+	when enabled, the decompressed contents of archive entries are kept in a cache after they are closed so
+	reopening them doesn't require decompressing them again. This must be set before the vfs is mounted
+	\param budget the maximum total size in bytes of the cached entries, or 0 to disable the cache
+	*/
+	virtual void EnableEntryCache( size_t budget ) = 0;
+
+	/**
+	get the entry cache (if enabled) so its hit, miss and eviction counts can be inspected
+	*/
+	virtual const EntryCache *GetEntryCache() const = 0;
+
+	/**
+	block until any background mapping started by Mount has completed
+	*/
+	virtual void WaitForMapping() = 0;
+
+	/**
+	when enabled, the content folder and any overlay folders are watched for changes while the vfs is mounted. The
+	changes are applied to the vfs when ProcessChanges is called. This must be set before the vfs is mounted
+	*/
+	virtual void EnableWatcher( bool enabled ) = 0;
+
+	/**
+	apply any changes made to the watched content since the last call. Only the folders which contain the changes are
+	remapped, and only if they had already been mapped. If changes to a watched folder were missed, everything in it is remapped
+	and the root path (an empty string) is reported as changed. Any nodes which are replaced or removed remain valid until the
+	vfs is destroyed, but are no longer part of the vfs tree
+	\param changedPaths filled with the logical paths of all the files and folders which were added, removed or modified
+	*/
+	virtual void ProcessChanges( std::vector<std::wstring> &changedPaths ) = 0;
+
+	/**
+	when a trace file is supplied, every file opened and every read made through the vfs is recorded along with
+	when it happened, and the trace is saved when the vfs is destroyed. Traces can be passed to the pakbuilder tool
+	to lay out packs in the order thier contents are loaded. Only one vfs can record a trace at once
+	\param traceFile the file to save the trace to, or nullptr to disable tracing
+	*/
+	virtual void EnableTrace( const wchar_t *traceFile ) = 0;
+
+	/**
+	when enabled, the whole content tree is mapped in the background as soon as it is mounted (as with eager mapping) and
+	a bloom filter of every logical path in it is built once it has been mapped. From then on looking up a path which
+	doesn't exist usually fails straight away, rather than walking and mapping each folder along the path. This must be
+	set before the vfs is mounted
+	*/
+	virtual void EnablePathFilter( bool enabled ) = 0;
+
+	/**
+	get the path filter so its false positive rate can be inspected, or nullptr if the filter is disabled or hasn't been built yet
+	*/
+	virtual const PathFilter *GetPathFilter() const = 0;
 };
 
 class DefaultFolderImpl;
-struct WCharCmp;
+class OverlayFolderImpl;
 
 class VirtualFileSystemComponent: public IVirtualFileSystemComponent
 {
@@ -36,18 +127,103 @@ public:
 	IFile *GetFile( const wchar_t *logicalPath ) const override final;
 	IFile *GetRoot() const override final;
 	bool Mount( const wchar_t * physicalDirectory ) override final;
+	void AddOverlay( const wchar_t *physicalPath ) override final;
 	void RegisterArchiveHandler( IArchiveHandler * ) override final;
+	void EnablePathIndex( bool enabled ) override final;
+	void EnableEagerMapping( bool enabled ) override final;
+	void EnableManifest( const wchar_t *manifestFile ) override final;
+	void EnableEntryCache( size_t budget ) override final;
+	const EntryCache *GetEntryCache() const override final {
+		return _entryCache;
+	}
+	void WaitForMapping() override final;
+	void EnableWatcher( bool enabled ) override final;
+	void ProcessChanges( std::vector<std::wstring> &changedPaths ) override final;
+	void EnableTrace( const wchar_t *traceFile ) override final;
+	void EnablePathFilter( bool enabled ) override final;
+	const PathFilter *GetPathFilter() const override final {
+		return _pathFilter.load( std::memory_order_acquire );
+	}
+	MGDFError ReadAsync( IFile *file, INT64 offset, UINT64 length, void *buffer, IReadCompletionHandler *handler, IAsyncRead **read ) override final;
+	MGDFError Prefetch( const wchar_t * const *logicalPaths, UINT32 count, PrefetchPriority priority, IPrefetch **prefetch ) override final;
+	MGDFError Query( const wchar_t *pattern, IFileQuery **query ) override final;
 
-	void MapChildren( DefaultFolderImpl *parent, std::map<const wchar_t *, IFile *, WCharCmp> &children );
+	void MapChildren( DefaultFolderImpl *parent, ChildList &children );
+	void MapOverlayChildren( OverlayFolderImpl *parent, ChildList &children );
+
+	/**
+	the arena which holds all the nodes mapped from the filesystem (archives have thier own arenas)
+	*/
+	const Arena *GetArena() const {
+		return _arena;
+	}
 private:
 	std::vector<IArchiveHandler *> _archiveHandlers;
 	std::multimap<IArchiveHandler *, IFile *> _mappedArchives;
+	std::mutex _mappedArchivesMutex;
 
 	IFile *_root;
-	bool _rootIsArchive;
+	std::vector<std::wstring> _overlays;
+	PathIndex *_pathIndex;
+	Arena *_arena;
+	bool _eagerMapping;
+	WorkerPool *_workers;
+	WorkerPool *_ioWorkers;
+	std::mutex _ioWorkersMutex;
+	Manifest *_manifest;
+	std::wstring _manifestFile;
+	EntryCache *_entryCache;
+	bool _watch;
+	ChangeWatcher *_watcher;
+
+	struct WatchedLayer {
+		IFile *root;
+		std::wstring physicalPath;
+	};
+	std::vector<WatchedLayer> _watchedLayers; // indexed by the directory index of each change
+	AccessTrace *_trace;
+	std::wstring _traceFile;
+	bool _pathFilterEnabled;
+	std::atomic<PathFilter *> _pathFilter; // published once the whole tree has been mapped
+	std::mutex _pathFilterMutex; // stops changes being applied while the filter is being built
+	std::atomic<size_t> _pendingMaps;
+	std::atomic<bool> _mappingFailed;
+
+	struct PrefetchItem {
+		PrefetchImpl *prefetch;
+		IFile *file; // if null, the path is looked up when the item is prefetched
+		std::wstring path;
+		UINT64 sequence;
+	};
+	struct PrefetchOrder {
+		// items from higher priority prefetches come first, then items are taken in the order they were queued
+		bool operator()( const PrefetchItem &a, const PrefetchItem &b ) const {
+			return a.prefetch->GetPriority() != b.prefetch->GetPriority()
+			       ? a.prefetch->GetPriority() < b.prefetch->GetPriority()
+			       : a.sequence > b.sequence;
+		}
+	};
+	std::priority_queue<PrefetchItem, std::vector<PrefetchItem>, PrefetchOrder> _prefetchQueue;
+	std::mutex _prefetchMutex;
+	UINT64 _prefetchSequence;
+	WorkerPool *_prefetchWorkers;
 
-	IFile *Map( const std::filesystem::path &path, IFile *parent );
+	/**
+	\param entry (optional) the directory entry the path was enumerated from, used to record the size and last write time of the node
+	*/
+	IFile *Map( const std::filesystem::path &path, IFile *parent, bool isDirectory, const std::filesystem::directory_entry *entry = nullptr );
 	IArchiveHandler *GetArchiveHandler( const std::wstring &path );
+	void IndexChild( const std::wstring &parentPath, IFile *child );
+	void MapTree( IFile *folder );
+	void QueueMapTree( IFile *folder );
+	void BuildPathFilter();
+	void Watch( const std::wstring &physicalPath, IFile *layer );
+	void QueuePrefetch( PrefetchImpl *prefetch, IFile *file, const wchar_t *path );
+	void PrefetchNext();
+	bool PrefetchFile( PrefetchImpl *prefetch, IFile *file );
+	void ApplyChange( IFile *layer, const std::wstring &logicalPath, const std::filesystem::path &physicalPath );
+	void RemapLayer( IFile *layer );
+	void ReleaseCachedEntries( IFile *removed );
 };
 
 IVirtualFileSystemComponent *CreateVirtualFileSystemComponentImpl();
@@ -0,0 +1,154 @@
+#include "StdAfx.h"
+
+#include <algorithm>
+#include "MGDFWorkerPool.hpp"
+
+// std min&max are used instead of the macros
+#ifdef min
+#undef min
+#undef max
+#endif
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+// the pool and queue index of the worker running on the current thread (if any)
+static thread_local const WorkerPool *_currentPool = nullptr;
+static thread_local UINT32 _currentQueue = 0;
+
+WorkerPool::WorkerPool( UINT32 threadCount )
+	: _queued( 0 )
+	, _pending( 0 )
+	, _stopping( false )
+	, _nextQueue( 0 )
+{
+	threadCount = std::max<UINT32>( 1, threadCount );
+	for ( UINT32 i = 0; i < threadCount; ++i ) {
+		_queues.push_back( std::unique_ptr<Queue>( new Queue() ) );
+	}
+	for ( UINT32 i = 0; i < threadCount; ++i ) {
+		_threads.push_back( std::thread( [this, i]() {
+			Run( i );
+		} ) );
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+		_stopping = true;
+	}
+	_wake.notify_all();
+	_idle.notify_all();
+
+	for ( auto &thread : _threads ) {
+		thread.join();
+	}
+}
+
+bool WorkerPool::Submit( Task &&task )
+{
+	UINT32 index = _currentPool == this
+	               ? _currentQueue
+	               : _nextQueue++ % static_cast<UINT32>( _queues.size() );
+
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+		if ( _stopping ) return false;
+		// the task is pushed before it is counted so a woken worker always finds it. A worker which pops it
+		// first can't decrement the counts until this lock is released
+		{
+			std::lock_guard<std::mutex> queueLock( _queues[index]->mutex );
+			_queues[index]->tasks.push_back( std::move( task ) );
+		}
+		++_queued;
+		++_pending;
+	}
+	_wake.notify_one();
+	return true;
+}
+
+void WorkerPool::Wait()
+{
+	std::unique_lock<std::mutex> lock( _mutex );
+	_idle.wait( lock, [this]() {
+		return _pending == 0 || _stopping;
+	} );
+}
+
+bool WorkerPool::IsIdle() const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return _pending == 0;
+}
+
+bool WorkerPool::TryPop( UINT32 index, Task &task )
+{
+	// take the most recently added task from our own queue
+	{
+		Queue &own = *_queues[index];
+		std::lock_guard<std::mutex> lock( own.mutex );
+		if ( !own.tasks.empty() ) {
+			task = std::move( own.tasks.back() );
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+
+	// otherwise steal the oldest task from another worker
+	for ( size_t i = 1; i < _queues.size(); ++i ) {
+		Queue &other = *_queues[( index + i ) % _queues.size()];
+		std::lock_guard<std::mutex> lock( other.mutex );
+		if ( !other.tasks.empty() ) {
+			task = std::move( other.tasks.front() );
+			other.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void WorkerPool::Run( UINT32 index )
+{
+	_currentPool = this;
+	_currentQueue = index;
+
+	for ( ;; ) {
+		Task task;
+		if ( TryPop( index, task ) ) {
+			{
+				std::lock_guard<std::mutex> lock( _mutex );
+				--_queued;
+			}
+			task();
+			std::lock_guard<std::mutex> lock( _mutex );
+			if ( --_pending == 0 ) {
+				_idle.notify_all();
+			}
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock( _mutex );
+		_wake.wait( lock, [this]() {
+			return _stopping || _queued > 0;
+		} );
+		if ( _stopping ) break;
+	}
+
+	_currentPool = nullptr;
+}
+
+}
+}
+}
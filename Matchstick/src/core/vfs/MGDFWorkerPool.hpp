@@ -0,0 +1,78 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+#include <MGDF/MGDF.hpp>
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+
+/**
+a fixed size pool of worker threads. Each worker has its own queue of tasks, tasks submitted from inside a
+worker are pushed onto that workers queue and idle workers steal from the other queues. This keeps recursive
+work (such as walking a directory tree) local to a thread while still spreading it across all the workers.
+*/
+class WorkerPool
+{
+public:
+	typedef std::function<void()> Task;
+
+	WorkerPool( UINT32 threadCount );
+
+	/**
+	any tasks which have not yet started are discarded, tasks which are running are allowed to complete
+	*/
+	virtual ~WorkerPool();
+
+	/**
+	queue a task to be run by one of the workers
+	\return false if the pool is being destroyed, in which case the task is not queued
+	*/
+	bool Submit( Task &&task );
+
+	/**
+	block until all submitted tasks (including any tasks submitted by those tasks) have completed
+	*/
+	void Wait();
+
+	/**
+	whether all submitted tasks have completed
+	*/
+	bool IsIdle() const;
+
+	UINT32 GetThreadCount() const {
+		return static_cast<UINT32>( _threads.size() );
+	}
+private:
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	void Run( UINT32 index );
+	bool TryPop( UINT32 index, Task &task );
+
+	std::vector<std::unique_ptr<Queue>> _queues;
+	std::vector<std::thread> _threads;
+	mutable std::mutex _mutex;
+	std::condition_variable _wake;
+	std::condition_variable _idle;
+	size_t _queued;
+	size_t _pending;
+	bool _stopping;
+	std::atomic<UINT32> _nextQueue;
+};
+
+}
+}
+}
@@ -0,0 +1,262 @@
+#include "stdafx.h"
+
+#include <algorithm>
+#include <zlib.h>
+
+#include "../../../common/MGDFResources.hpp"
+#include "../../../common/MGDFLoggerImpl.hpp"
+#include "PakArchive.hpp"
+#include "PakFileImpl.hpp"
+#include "PakFolderImpl.hpp"
+
+// std min&max are used instead of the macros
+#ifdef min
+#undef min
+#undef max
+#endif
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace pak
+{
+
+PakArchive::PakArchive( IErrorHandler *errorHandler )
+	: _mapping( nullptr )
+	, _view( nullptr )
+	, _viewSize( 0 )
+	, _header( nullptr )
+	, _buckets( nullptr )
+	, _entries( nullptr )
+	, _names( nullptr )
+	, _blocks( nullptr )
+	, _root( nullptr )
+	, _errorHandler( errorHandler )
+{
+	_ASSERTE( errorHandler );
+}
+
+PakArchive::~PakArchive()
+{
+	if ( _view ) {
+		UnmapViewOfFile( _view );
+	}
+	if ( _mapping ) {
+		CloseHandle( _mapping );
+	}
+}
+
+bool PakArchive::CreateView( const wchar_t *physicalPath )
+{
+	HANDLE file = CreateFileW( physicalPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if ( file == INVALID_HANDLE_VALUE ) {
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	// the pack must fit into the address space to be viewed in one piece
+	if ( GetFileSizeEx( file, &size ) && static_cast<UINT64>( size.QuadPart ) >= sizeof( PakHeader ) && static_cast<UINT64>( size.QuadPart ) <= SIZE_MAX ) {
+		_mapping = CreateFileMappingW( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+		if ( _mapping ) {
+			_view = static_cast<const char *>( MapViewOfFile( _mapping, FILE_MAP_READ, 0, 0, 0 ) );
+			_viewSize = static_cast<UINT64>( size.QuadPart );
+		}
+	}
+	CloseHandle( file );
+	return _view != nullptr;
+}
+
+PakFileRoot *PakArchive::MapArchive( const wchar_t *name, const wchar_t * physicalPath, IFile *parent )
+{
+	_ASSERTE( name );
+	_ASSERTE( physicalPath );
+
+	if ( !CreateView( physicalPath ) ) {
+		LOG( "Could not open archive " << Resources::ToString( physicalPath ), LOG_ERROR );
+		return nullptr;
+	}
+
+	_header = reinterpret_cast<const PakHeader *>( _view );
+	if ( !Validate() ) {
+		LOG( "Invalid archive " << Resources::ToString( physicalPath ), LOG_ERROR );
+		return nullptr;
+	}
+
+	_root = _arena.New<PakFileRoot>( _arena.Intern( name, wcslen( name ) ), _arena.Copy( physicalPath, wcslen( physicalPath ) ), parent, this, _errorHandler );
+	MapEntries();
+	return _root;
+}
+
+bool PakArchive::Validate() const
+{
+	const PakHeader &header = *_header;
+	if ( header.signature != PAK_SIGNATURE || header.version != PAK_VERSION || !header.blockSize ) {
+		return false;
+	}
+	// lookups stop at the first empty bucket, so there must always be at least one
+	if ( !header.bucketCount || ( header.bucketCount & ( header.bucketCount - 1 ) ) || header.entryCount > PAK_MAX_ENTRIES || header.entryCount >= header.bucketCount ) {
+		return false;
+	}
+	UINT64 namesOffset = PakNamesOffset( header );
+	if ( namesOffset > _viewSize || header.namesLength > ( _viewSize - namesOffset ) / sizeof( wchar_t ) ) {
+		return false;
+	}
+	if ( header.blockOffset % sizeof( UINT64 ) || header.blockOffset > _viewSize || header.blockCount > ( _viewSize - header.blockOffset ) / sizeof( PakBlock ) ) {
+		return false;
+	}
+
+	// every entry must be in exactly one bucket, which also leaves at least one bucket empty
+	const UINT32 *buckets = reinterpret_cast<const UINT32 *>( _view + PakBucketsOffset() );
+	std::vector<bool> bucketed( static_cast<size_t>( header.entryCount ) );
+	UINT64 emptyBuckets = 0;
+	for ( UINT32 i = 0; i < header.bucketCount; ++i ) {
+		if ( buckets[i] == PAK_EMPTY_BUCKET ) {
+			++emptyBuckets;
+			continue;
+		}
+		if ( buckets[i] >= header.entryCount || bucketed[buckets[i]] ) return false;
+		bucketed[buckets[i]] = true;
+	}
+	if ( !emptyBuckets || header.bucketCount - emptyBuckets != header.entryCount ) {
+		return false;
+	}
+
+	const PakBlock *blocks = reinterpret_cast<const PakBlock *>( _view + header.blockOffset );
+	for ( UINT64 i = 0; i < header.blockCount; ++i ) {
+		if ( blocks[i].offset > _viewSize || blocks[i].size > _viewSize - blocks[i].offset ) return false;
+	}
+
+	const PakEntry *entries = reinterpret_cast<const PakEntry *>( _view + PakEntriesOffset( header ) );
+	const wchar_t *names = reinterpret_cast<const wchar_t *>( _view + namesOffset );
+	for ( UINT64 i = 0; i < header.entryCount; ++i ) {
+		const PakEntry &entry = entries[i];
+		if ( entry.path >= header.namesLength || entry.pathLength >= header.namesLength - entry.path || names[entry.path + entry.pathLength] ) {
+			return false;
+		}
+		// the tree is built assuming the entries are sorted
+		if ( i && wcscmp( names + entries[i - 1].path, names + entry.path ) >= 0 ) {
+			return false;
+		}
+		if ( entry.flags & PAK_ENTRY_COMPRESSED ) {
+			UINT64 blockCount = entry.size / header.blockSize + ( entry.size % header.blockSize ? 1 : 0 );
+			if ( entry.offset > header.blockCount || blockCount > header.blockCount - entry.offset ) return false;
+		} else if ( entry.offset > _viewSize || entry.size > _viewSize - entry.offset ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void PakArchive::MapEntries()
+{
+	_buckets = reinterpret_cast<const UINT32 *>( _view + PakBucketsOffset() );
+	_entries = reinterpret_cast<const PakEntry *>( _view + PakEntriesOffset( *_header ) );
+	_names = reinterpret_cast<const wchar_t *>( _view + PakNamesOffset( *_header ) );
+	_blocks = reinterpret_cast<const PakBlock *>( _view + _header->blockOffset );
+	_files.resize( static_cast<size_t>( _header->entryCount ), nullptr );
+
+	// the entries are sorted by path, so all the entries within a folder are next to each other. This means the tree
+	// can be built in one pass, keeping track of only the folders which contain the current entry
+	struct OpenFolder {
+		const wchar_t *path;
+		size_t length; // the length of the folders path, including the trailing '/'
+		FileBaseImpl *folder;
+	};
+	std::vector<OpenFolder> open;
+	std::vector<FileBaseImpl *> folders;
+
+	for ( size_t i = 0; i < _files.size(); ++i ) {
+		const PakEntry &entry = _entries[i];
+		const wchar_t *path = _names + entry.path;
+
+		while ( !open.empty() && ( open.back().length > entry.pathLength || wcsncmp( open.back().path, path, open.back().length ) != 0 ) ) {
+			open.pop_back();
+		}
+		FileBaseImpl *parent = open.empty() ? _root : open.back().folder;
+		size_t start = open.empty() ? 0 : open.back().length;
+
+		for ( size_t end = start; end < entry.pathLength; ++end ) {
+			if ( path[end] != L'/' ) continue;
+			if ( end != start ) {
+				FileBaseImpl *folder = _arena.New<PakFolderImpl>( _arena.Intern( path + start, end - start ), parent, this );
+				parent->AddChild( folder );
+				folders.push_back( folder );
+				parent = folder;
+			}
+			open.push_back( { path, end + 1, parent } );
+			start = end + 1;
+		}
+
+		if ( start < entry.pathLength ) {
+			// the name is the last part of the path, which is null terminated in the names table of the pack
+			PakFileImpl *file = _arena.New<PakFileImpl>( path + start, &entry, parent, this );
+			parent->AddChild( file );
+			_files[i] = file;
+		}
+	}
+
+	// the pack contents never change once mapped, so the children of
+	// every node can now be frozen into sorted arrays
+	_root->FreezeChildren();
+	for ( auto folder : folders ) {
+		folder->FreezeChildren();
+	}
+}
+
+IFile *PakArchive::FindFile( const wchar_t *path ) const
+{
+	_ASSERTE( path );
+	size_t length = wcslen( path );
+	UINT64 hash = PakHash( path, length );
+
+	// the probe is bounded by the bucket count as well as by the empty buckets which Validate guarantees
+	const UINT32 mask = _header->bucketCount - 1;
+	UINT32 bucket = static_cast<UINT32>( hash ) & mask;
+	for ( UINT32 probes = 0; probes < _header->bucketCount && _buckets[bucket] != PAK_EMPTY_BUCKET; ++probes, bucket = ( bucket + 1 ) & mask ) {
+		const PakEntry &entry = _entries[_buckets[bucket]];
+		if ( entry.hash == hash && entry.pathLength == length && wmemcmp( _names + entry.path, path, length ) == 0 ) {
+			return _files[_buckets[bucket]];
+		}
+	}
+	return nullptr;
+}
+
+UINT32 PakArchive::GetBlockLength( const PakEntry &entry, UINT64 block ) const
+{
+	return static_cast<UINT32>( std::min<UINT64>( _header->blockSize, entry.size - block * _header->blockSize ) );
+}
+
+bool PakArchive::ReadBlock( const PakEntry &entry, UINT64 block, char *destination ) const
+{
+	const PakBlock &stored = _blocks[entry.offset + block];
+	const UINT32 length = GetBlockLength( entry, block );
+
+	if ( !( stored.flags & PAK_BLOCK_COMPRESSED ) ) {
+		if ( stored.size != length ) {
+			LOG( "Invalid block in " << Resources::ToString( _root->GetPhysicalPath() ), LOG_ERROR );
+			return false;
+		}
+		memcpy( destination, _view + stored.offset, length );
+		return true;
+	}
+
+	uLongf uncompressedLength = length;
+	if ( uncompress( reinterpret_cast<Bytef *>( destination ), &uncompressedLength, reinterpret_cast<const Bytef *>( _view + stored.offset ), stored.size ) != Z_OK || uncompressedLength != length ) {
+		LOG( "Unable to decompress block in " << Resources::ToString( _root->GetPhysicalPath() ), LOG_ERROR );
+		return false;
+	}
+	return true;
+}
+
+}
+}
+}
+}
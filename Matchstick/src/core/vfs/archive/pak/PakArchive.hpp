@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+
+#include "PakFormat.hpp"
+#include "PakFileRoot.hpp"
+#include <MGDF/MGDFVirtualFileSystem.hpp>
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace pak
+{
+
+/**
+handles the mapping and access to .mgdfpak archives. The whole pack is mapped into memory for as long as
+the archive is mapped, and the index, names and stored entries are all used in place from that mapping
+*/
+class PakArchive
+{
+public:
+	PakArchive( IErrorHandler *errorHandler );
+	virtual ~PakArchive();
+
+	PakFileRoot *MapArchive( const wchar_t *name, const wchar_t * physicalPath, IFile *parent );
+
+	PakFileRoot *GetArchiveRoot() const {
+		return _root;
+	}
+	/**
+	all the nodes in the archive are allocated from this arena
+	*/
+	Arena *GetArena() {
+		return &_arena;
+	}
+
+	/**
+	find an entry using the hashed path index in the pack
+	\param path the path of the entry relative to the archive root
+	\return the file, or nullptr if there is no entry with that path
+	*/
+	IFile *FindFile( const wchar_t *path ) const;
+
+	/**
+	get the data of an entry which is stored without compression, this remains valid for as long as the archive is mapped
+	*/
+	const char *GetStoredData( const PakEntry &entry ) const {
+		return _view + entry.offset;
+	}
+	UINT32 GetBlockSize() const {
+		return _header->blockSize;
+	}
+	/**
+	the uncompressed length of one of the blocks of a compressed entry
+	*/
+	UINT32 GetBlockLength( const PakEntry &entry, UINT64 block ) const;
+	/**
+	decompress one of the blocks of a compressed entry
+	\param destination must have room for the uncompressed length of the block
+	*/
+	bool ReadBlock( const PakEntry &entry, UINT64 block, char *destination ) const;
+
+private:
+	bool CreateView( const wchar_t *physicalPath );
+	bool Validate() const;
+	void MapEntries();
+
+	HANDLE _mapping;
+	const char *_view;
+	UINT64 _viewSize;
+	const PakHeader *_header;
+	const UINT32 *_buckets;
+	const PakEntry *_entries;
+	const wchar_t *_names;
+	const PakBlock *_blocks;
+	std::vector<IFile *> _files; // the node for each entry
+	PakFileRoot *_root;
+	IErrorHandler *_errorHandler;
+	Arena _arena;
+};
+
+}
+}
+}
+}
@@ -0,0 +1,79 @@
+#include "StdAfx.h"
+
+#include "PakArchiveHandlerImpl.hpp"
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace pak
+{
+
+IArchiveHandler *CreatePakArchiveHandlerImpl( IErrorHandler *errorHandler )
+{
+	_ASSERTE( errorHandler );
+	return new PakArchiveHandlerImpl( errorHandler );
+}
+
+PakArchiveHandlerImpl::PakArchiveHandlerImpl( IErrorHandler *errorHandler )
+	: _errorHandler( errorHandler )
+{
+}
+
+IFile *PakArchiveHandlerImpl::MapArchive( const wchar_t * name, const wchar_t * physicalPath, IFile *parent )
+{
+	_ASSERTE( name );
+	_ASSERTE( physicalPath );
+
+	PakArchive *archive = new PakArchive( _errorHandler );
+	PakFileRoot *result = archive->MapArchive( name, physicalPath, parent );
+	if ( result ) {
+		std::lock_guard<std::mutex> lock( _mutex );
+		_archives.insert( std::pair<PakFileRoot *, PakArchive *> ( result, archive ) );
+	} else {
+		delete archive;
+	}
+	return result;
+}
+
+void PakArchiveHandlerImpl::Dispose()
+{
+	_ASSERTE( _archives.size() == 0 );
+	delete this;
+}
+
+void PakArchiveHandlerImpl::DisposeArchive( IFile *archive )
+{
+	if ( !archive ) return;
+
+	std::lock_guard<std::mutex> lock( _mutex );
+	auto it = _archives.find( static_cast<PakFileRoot *>( archive ) );
+	_ASSERTE( it != _archives.end() );
+	if ( it != _archives.end() ) {
+		// the archive root is allocated in the archives arena so is destroyed along with the archive
+		delete it->second;
+		_archives.erase( it );
+	}
+}
+
+bool PakArchiveHandlerImpl::IsArchive( const wchar_t *path ) const
+{
+	_ASSERTE( path );
+	if ( !path ) return false;
+
+	const wchar_t *extension = wcsrchr( path, L'.' );
+	return extension && wcscmp( extension, PAK_EXT ) == 0;
+}
+
+}
+}
+}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+
+#include <MGDF/MGDF.hpp>
+#include <MGDF/MGDFVirtualFileSystem.hpp>
+
+#include "PakArchive.hpp"
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace pak
+{
+
+/**
+Creates .mgdfpak archive handlers
+*/
+class PakArchiveHandlerImpl: public IArchiveHandler
+{
+public:
+	PakArchiveHandlerImpl( IErrorHandler *errorHandler );
+	virtual ~PakArchiveHandlerImpl() {}
+	void Dispose() override final;
+	void DisposeArchive( IFile *archive ) override final;
+	bool IsArchive( const wchar_t *physicalPath ) const override final;
+	IFile *MapArchive( const wchar_t * name, const wchar_t * physicalPath, IFile *parent ) override final;
+
+private:
+	std::map<PakFileRoot *, PakArchive *> _archives;
+	std::mutex _mutex; // archives can be mapped concurrently when the vfs maps its content in the background
+	IErrorHandler *_errorHandler;
+};
+
+IArchiveHandler *CreatePakArchiveHandlerImpl( IErrorHandler *errorHandler );
+
+}
+}
+}
+}
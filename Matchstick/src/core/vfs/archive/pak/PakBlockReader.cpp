@@ -0,0 +1,104 @@
+#include "StdAfx.h"
+
+#include <algorithm>
+#include "../../MGDFFileReaderImpl.hpp"
+#include "PakBlockReader.hpp"
+
+// std min&max are used instead of the macros
+#ifdef min
+#undef min
+#undef max
+#endif
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+#define NO_BLOCK 0xffffffffffffffffULL
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace pak
+{
+
+PakBlockReader::PakBlockReader( IFileReaderOwner *owner, PakArchive *archive, const PakEntry &entry )
+	: _owner( owner )
+	, _archive( archive )
+	, _entry( entry )
+	, _position( 0 )
+	, _block( NO_BLOCK )
+{
+	_ASSERTE( owner );
+	_ASSERTE( archive );
+}
+
+void PakBlockReader::Close()
+{
+	_owner->ReleaseReader();
+	delete this;
+}
+
+UINT64 PakBlockReader::Read( void* buffer, UINT64 length )
+{
+	if ( !buffer || _position < 0 ) {
+		return 0;
+	}
+
+	char *destination = static_cast<char *>( buffer );
+	const UINT64 blockSize = _archive->GetBlockSize();
+	UINT64 read = 0;
+	while ( read < length && static_cast<UINT64>( _position ) < _entry.size ) {
+		UINT64 block = static_cast<UINT64>( _position ) / blockSize;
+		UINT64 offset = static_cast<UINT64>( _position ) - block * blockSize;
+		UINT32 blockLength = _archive->GetBlockLength( _entry, block );
+		UINT64 copy = std::min<UINT64>( length - read, blockLength - offset );
+
+		if ( offset == 0 && copy == blockLength && block != _block ) {
+			// whole blocks can be decompressed straight into the callers buffer
+			if ( !_archive->ReadBlock( _entry, block, destination + read ) ) break;
+		} else {
+			if ( block != _block ) {
+				_buffer.resize( blockSize );
+				if ( !_archive->ReadBlock( _entry, block, _buffer.data() ) ) {
+					_block = NO_BLOCK;
+					break;
+				}
+				_block = block;
+			}
+			memcpy( destination + read, _buffer.data() + offset, static_cast<size_t>( copy ) );
+		}
+		read += copy;
+		_position += static_cast<INT64>( copy );
+	}
+	return read;
+}
+
+UINT64 PakBlockReader::ReadMany( ReadRange *ranges, UINT32 count )
+{
+	// reading the ranges in offset order means ranges which share a block only decompress it once
+	std::vector<ReadRange *> sorted;
+	SortRanges( ranges, count, sorted );
+
+	UINT64 total = 0;
+	for ( auto range : sorted ) {
+		SetPosition( range->offset );
+		range->read = Read( range->buffer, range->length );
+		total += range->read;
+	}
+	return total;
+}
+
+void PakBlockReader::SetPosition( INT64 pos )
+{
+	_position = pos < 0 ? 0 : pos;
+}
+
+}
+}
+}
+}
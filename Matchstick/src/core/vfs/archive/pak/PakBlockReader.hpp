@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+
+#include "PakArchive.hpp"
+#include "../../MGDFFileReaderImpl.hpp"
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace pak
+{
+
+/**
+reads a compressed pack entry by decompressing only the blocks which contain the data being read. Seeking
+is free in either direction, as the next read only has to decompress the block containing the new position
+*/
+class PakBlockReader : public IFileReader
+{
+public:
+	PakBlockReader( IFileReaderOwner *owner, PakArchive *archive, const PakEntry &entry );
+	virtual ~PakBlockReader() {}
+
+	void Close() override final;
+	UINT64 Read( void* buffer, UINT64 length ) override final;
+	UINT64 ReadMany( ReadRange *ranges, UINT32 count ) override final;
+	void SetPosition( INT64 pos ) override final;
+	INT64 GetPosition() const override final {
+		return _position;
+	}
+	bool EndOfFile() const override final {
+		return _position >= GetSize();
+	}
+	INT64 GetSize() const override final {
+		return static_cast<INT64>( _entry.size );
+	}
+private:
+	IFileReaderOwner *_owner;
+	PakArchive *_archive;
+	const PakEntry &_entry;
+	INT64 _position;
+	UINT64 _block; // the block currently held in the buffer
+	std::vector<char> _buffer;
+};
+
+}
+}
+}
+}
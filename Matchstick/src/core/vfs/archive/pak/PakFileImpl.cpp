@@ -0,0 +1,72 @@
+#include "StdAfx.h"
+
+#include "PakFileImpl.hpp"
+#include "PakBlockReader.hpp"
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace pak
+{
+
+PakFileImpl::~PakFileImpl()
+{
+	// any readers which are still open at this point are no longer valid
+}
+
+MGDFError PakFileImpl::OpenReader( IFileReader **reader )
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	++_readers;
+	if ( _entry->flags & PAK_ENTRY_COMPRESSED ) {
+		*reader = new PakBlockReader( this, _archive, *_entry );
+	} else {
+		*reader = new MemoryFileReader( this, _archive->GetStoredData( *_entry ), static_cast<INT64>( _entry->size ) );
+	}
+	return MGDF_OK;
+}
+
+MGDFError PakFileImpl::ReadData( void *buffer, UINT64 *length )
+{
+	if ( !buffer || *length < _entry->size ) {
+		*length = _entry->size;
+		return buffer ? MGDF_ERR_BUFFER_TOO_SMALL : MGDF_OK;
+	}
+	*length = _entry->size;
+
+	char *destination = static_cast<char *>( buffer );
+	if ( !( _entry->flags & PAK_ENTRY_COMPRESSED ) ) {
+		memcpy( destination, _archive->GetStoredData( *_entry ), static_cast<size_t>( _entry->size ) );
+		return MGDF_OK;
+	}
+
+	// every block is decompressed straight into its place in the callers buffer
+	const UINT64 blockSize = _archive->GetBlockSize();
+	for ( UINT64 block = 0; block * blockSize < _entry->size; ++block ) {
+		if ( !_archive->ReadBlock( *_entry, block, destination + block * blockSize ) ) {
+			return MGDF_ERR_INVALID_ARCHIVE_FILE;
+		}
+	}
+	return MGDF_OK;
+}
+
+void PakFileImpl::ReleaseReader()
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	_ASSERTE( _readers );
+	--_readers;
+}
+
+}
+}
+}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "PakArchive.hpp"
+#include "../../MGDFFileBaseImpl.hpp"
+#include "../../MGDFFileReaderImpl.hpp"
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace pak
+{
+
+/**
+implementation of a file in a pack. Entries stored without compression are read in place from the mapping
+of the pack, while compressed entries are decompressed a block at a time by each reader as it is read
+*/
+class PakFileImpl: public FileBaseImpl, public IFileReaderOwner
+{
+public:
+	/**
+	the name and entry are not copied, they must live as long as the archive is mapped
+	*/
+	PakFileImpl( const wchar_t *name, const PakEntry *entry, IFile *parent, PakArchive *archive )
+		: FileBaseImpl( parent, archive->GetArena() )
+		, _archive( archive )
+		, _entry( entry )
+		, _name( name )
+		, _readers( 0 ) {
+	}
+	virtual ~PakFileImpl();
+
+	bool IsFolder() const override final {
+		return false;
+	}
+	bool IsArchive() const override final {
+		return true;
+	}
+
+	bool IsOpen() const override final {
+		std::lock_guard<std::mutex> lock( _mutex );
+		return _readers > 0;
+	}
+
+	void ReleaseReader() override final;
+
+	time_t GetLastWriteTime() const override final {
+		// packs don't record a last write time for each entry
+		return _archive->GetArchiveRoot()->GetLastWriteTime();
+	}
+	INT64 GetSize() const override final {
+		return static_cast<INT64>( _entry->size );
+	}
+	const wchar_t *GetArchiveName() const override final {
+		return _archive->GetArchiveRoot()->GetName();
+	}
+	const wchar_t *GetPhysicalPath() const override final {
+		return _archive->GetArchiveRoot()->GetPhysicalPath();
+	}
+	const wchar_t *GetName() const override final {
+		return _name;
+	}
+protected:
+	MGDFError OpenReader( IFileReader **reader ) override final;
+	MGDFError ReadData( void *buffer, UINT64 *length ) override final;
+private:
+	PakArchive *_archive;
+	const PakEntry *_entry;
+	const wchar_t *_name;
+	UINT32 _readers;
+};
+
+}
+}
+}
+}
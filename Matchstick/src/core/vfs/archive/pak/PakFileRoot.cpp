@@ -0,0 +1,38 @@
+#include "stdafx.h"
+
+#include "PakFileRoot.hpp"
+#include "PakArchive.hpp"
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace pak
+{
+
+PakFileRoot::PakFileRoot( const wchar_t *name, const wchar_t *physicalPath, IFile *parent, PakArchive *archive, IErrorHandler *errorHandler )
+	: DefaultFileImpl( name, physicalPath, parent, archive->GetArena(), errorHandler )
+	, _archive( archive )
+{
+}
+
+PakFileRoot::~PakFileRoot()
+{
+	// children are owned by the archives arena
+}
+
+IFile *PakFileRoot::FindFile( const wchar_t *path ) const
+{
+	return _archive->FindFile( path );
+}
+
+}
+}
+}
+}
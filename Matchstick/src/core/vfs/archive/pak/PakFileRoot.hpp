@@ -0,0 +1,40 @@
+#pragma once
+
+#include "../../MGDFDefaultFileImpl.hpp"
+#include "../../MGDFPathIndex.hpp"
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace pak
+{
+
+class PakArchive;
+
+/**
+ the physical pack file, which can be read like any other file but also contains the contents of the pack
+ as if it were a folder. Files in the pack can be found directly using the packs own path index
+ */
+class PakFileRoot: public DefaultFileImpl, public IIndexedArchive
+{
+public:
+	PakFileRoot( const wchar_t *name, const wchar_t *physicalPath, IFile *parent, PakArchive *archive, IErrorHandler *errorHandler );
+	virtual ~PakFileRoot();
+	bool IsArchive() const override final {
+		return true;
+	}
+	const wchar_t *GetArchiveName() const override final {
+		return GetName();
+	}
+	IFile *FindFile( const wchar_t *path ) const override final;
+private:
+	PakArchive *_archive;
+};
+
+}
+}
+}
+}
@@ -0,0 +1,26 @@
+#include "stdafx.h"
+
+#include "PakFolderImpl.hpp"
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace pak
+{
+
+PakFolderImpl::~PakFolderImpl()
+{
+	// children are owned by the archives arena
+}
+
+}
+}
+}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "PakArchive.hpp"
+#include "../../MGDFFolderBaseImpl.hpp"
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace pak
+{
+
+/**
+implementation of a folder in a pack, folders aren't stored in the pack but are implied by the paths of its entries
+*/
+class PakFolderImpl: public FolderBaseImpl
+{
+public:
+	/**
+	the name is not copied, so it must be interned in the archives arena
+	*/
+	PakFolderImpl( const wchar_t *name, IFile *parent, PakArchive *archive )
+		: FolderBaseImpl( name, archive->GetArchiveRoot()->GetPhysicalPath(), parent, archive->GetArena() )
+		, _archive( archive ) {
+	}
+	virtual ~PakFolderImpl();
+
+	bool IsArchive() const override final {
+		return true;
+	}
+
+	const wchar_t *GetArchiveName() const override final {
+		return _archive->GetArchiveRoot()->GetName();
+	}
+
+	time_t GetLastWriteTime() const override final {
+		return _archive->GetArchiveRoot()->GetLastWriteTime();
+	}
+
+private:
+	PakArchive *_archive;
+};
+
+}
+}
+}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <MGDF/MGDF.hpp>
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace pak
+{
+
+/**
+the layout of a .mgdfpak file. Everything needed to find an entry is at the start of the file
+
+	PakHeader
+	UINT32 buckets[bucketCount]	an open addressed hash table of entry indices, keyed by the hash of the entries path
+	PakEntry entries[entryCount]	sorted by path
+	wchar_t names[namesLength]	the null terminated utf-16 path of each entry, relative to the root of the pack
+
+followed by the entry data, and finally the table of compressed blocks. All values are little endian
+*/
+
+#define PAK_EXT L".mgdfpak"
+#define PAK_SIGNATURE 0x4b41504d // "MPAK"
+#define PAK_VERSION 1
+#define PAK_PAGE_SIZE 4096
+#define PAK_BLOCK_SIZE 65536
+#define PAK_EMPTY_BUCKET 0xffffffff
+#define PAK_MAX_ENTRIES 0x40000000
+
+#define PAK_ENTRY_COMPRESSED 1
+#define PAK_BLOCK_COMPRESSED 1
+
+struct PakHeader {
+	UINT32 signature;
+	UINT32 version;
+	UINT32 blockSize; // the uncompressed size of every block except the last block of each entry
+	UINT32 bucketCount; // always a power of 2
+	UINT64 entryCount;
+	UINT64 namesLength; // in characters
+	UINT64 blockOffset;
+	UINT64 blockCount;
+};
+
+struct PakEntry {
+	UINT64 hash; // of the full path
+	UINT64 path; // offset of the path in the names table
+	UINT64 offset; // of the data for stored entries, or the index of the first block for compressed entries
+	UINT64 size; // uncompressed
+	UINT32 pathLength;
+	UINT32 flags;
+};
+
+/**
+compressed entries are split into fixed size blocks which are each compressed separately, so any
+part of the entry can be read by decompressing only the blocks which contain it
+*/
+struct PakBlock {
+	UINT64 offset;
+	UINT32 size; // of the block as stored in the pack
+	UINT32 flags; // blocks which don't get any smaller when compressed are stored as is
+};
+
+static_assert( sizeof( PakHeader ) == 48, "PakHeader must match the file layout" );
+static_assert( sizeof( PakEntry ) == 40, "PakEntry must match the file layout" );
+static_assert( sizeof( PakBlock ) == 16, "PakBlock must match the file layout" );
+
+inline UINT64 PakHash( const wchar_t *path, size_t length )
+{
+	// FNV-1a
+	UINT64 hash = 14695981039346656037ULL;
+	for ( size_t i = 0; i < length; ++i ) {
+		hash ^= static_cast<UINT16>( path[i] );
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+inline UINT64 PakBucketsOffset()
+{
+	return sizeof( PakHeader );
+}
+
+inline UINT64 PakEntriesOffset( const PakHeader &header )
+{
+	// the entries are kept 8 byte aligned
+	return ( PakBucketsOffset() + header.bucketCount * sizeof( UINT32 ) + 7 ) & ~7ULL;
+}
+
+inline UINT64 PakNamesOffset( const PakHeader &header )
+{
+	return PakEntriesOffset( header ) + header.entryCount * sizeof( PakEntry );
+}
+
+}
+}
+}
+}
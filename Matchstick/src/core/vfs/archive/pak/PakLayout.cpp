@@ -0,0 +1,98 @@
+#include "stdafx.h"
+
+#include <algorithm>
+
+#include "../../MGDFAccessTrace.hpp"
+#include "PakLayout.hpp"
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace pak
+{
+
+PakLayout::PakLayout( UINT64 phaseGap )
+	: _phaseGap( phaseGap )
+	, _phaseCount( 0 )
+{
+}
+
+bool PakLayout::AddTrace( const std::wstring &file )
+{
+	std::vector<std::wstring> paths;
+	std::vector<TraceEvent> events;
+	if ( !AccessTrace::Load( file, paths, events ) ) {
+		return false;
+	}
+
+	std::vector<bool> seen( paths.size(), false );
+	Access access;
+	access.phase = 0;
+	UINT64 phaseStart = events.empty() ? 0 : events.front().time;
+	UINT64 previous = phaseStart;
+	for ( auto &event : events ) {
+		if ( event.time > previous + _phaseGap ) {
+			++access.phase;
+			phaseStart = event.time;
+		}
+		previous = event.time;
+
+		if ( seen[event.path] ) continue;
+		seen[event.path] = true;
+		access.time = event.time - phaseStart;
+
+		// every trailing part of the path is recorded, as the pack could be mounted anywhere in the traced vfs
+		const std::wstring &path = paths[event.path];
+		size_t start = 0;
+		while ( start < path.size() ) {
+			auto result = _accesses.insert( std::make_pair( path.substr( start ), access ) );
+			if ( !result.second && access < result.first->second ) {
+				result.first->second = access;
+			}
+			size_t separator = path.find( L'/', start );
+			if ( separator == std::wstring::npos ) break;
+			start = separator + 1;
+		}
+	}
+
+	if ( !events.empty() ) {
+		_phaseCount = std::max<size_t>( _phaseCount, static_cast<size_t>( access.phase + 1 ) );
+	}
+	return true;
+}
+
+void PakLayout::GetOrder( const std::vector<std::wstring> &entries, std::vector<std::wstring> &order ) const
+{
+	std::vector<std::pair<Access, const std::wstring *>> accessed;
+	for ( auto &entry : entries ) {
+		auto found = _accesses.find( entry );
+		if ( found != _accesses.end() ) {
+			accessed.push_back( std::make_pair( found->second, &entry ) );
+		}
+	}
+
+	std::sort( accessed.begin(), accessed.end(), []( const std::pair<Access, const std::wstring *> &a, const std::pair<Access, const std::wstring *> &b ) {
+		if ( a.first < b.first ) return true;
+		if ( b.first < a.first ) return false;
+		return *a.second < *b.second;
+	} );
+
+	order.clear();
+	for ( auto &entry : accessed ) {
+		order.push_back( *entry.second );
+	}
+}
+
+}
+}
+}
+}
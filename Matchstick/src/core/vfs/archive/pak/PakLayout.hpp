@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "PakFormat.hpp"
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace pak
+{
+
+/**
+works out the order to lay out the entries of a pack from one or more vfs access traces, so that loading reads
+through the pack sequentially. Each trace is split into load phases wherever nothing was accessed for longer than
+the phase gap, and entries are ordered by the first phase they were accessed in, then by how long after the start of
+that phase they were first accessed. Traced paths are matched to entries by thier trailing path components, so traces
+recorded with the content mounted either as loose files or as a pack can be used
+*/
+class PakLayout
+{
+public:
+	/**
+	\param phaseGap the length of time in microseconds without any accesses which separates two load phases
+	*/
+	PakLayout( UINT64 phaseGap );
+	virtual ~PakLayout() {}
+
+	/**
+	\return false if the trace couldn't be loaded
+	*/
+	bool AddTrace( const std::wstring &file );
+
+	/**
+	\param entries the paths of the entries in the pack
+	\param order filled with the paths of the entries which were accessed in any of the traces, in the order they should be laid out
+	*/
+	void GetOrder( const std::vector<std::wstring> &entries, std::vector<std::wstring> &order ) const;
+
+	/**
+	the most load phases found in any of the traces
+	*/
+	size_t GetPhaseCount() const {
+		return _phaseCount;
+	}
+private:
+	struct Access {
+		UINT64 phase;
+		UINT64 time; // since the start of the phase
+		bool operator<( const Access &other ) const {
+			return phase != other.phase ? phase < other.phase : time < other.time;
+		}
+	};
+
+	UINT64 _phaseGap;
+	size_t _phaseCount;
+	std::unordered_map<std::wstring, Access> _accesses; // the earliest access to every trailing part of each traced path
+};
+
+}
+}
+}
+}
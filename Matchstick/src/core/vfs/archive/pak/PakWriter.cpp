@@ -0,0 +1,288 @@
+#include "stdafx.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <zlib.h>
+
+#include "PakWriter.hpp"
+
+// std min&max are used instead of the macros
+#ifdef min
+#undef min
+#undef max
+#endif
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace pak
+{
+
+static UINT64 ContentHash( const std::string &data )
+{
+	// FNV-1a
+	UINT64 hash = 14695981039346656037ULL;
+	for ( char c : data ) {
+		hash ^= static_cast<unsigned char>( c );
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static void Pad( std::ofstream &out, UINT64 length )
+{
+	static const char zeros[PAK_PAGE_SIZE] = {};
+	while ( length ) {
+		UINT64 write = std::min<UINT64>( length, PAK_PAGE_SIZE );
+		out.write( zeros, static_cast<std::streamsize>( write ) );
+		length -= write;
+	}
+}
+
+PakWriter::PakWriter()
+	: _compression( true )
+	, _blockSize( PAK_BLOCK_SIZE )
+	, _duplicates( 0 )
+	, _compressed( 0 )
+{
+}
+
+void PakWriter::AddFile( const std::wstring &path, const std::wstring &physicalPath )
+{
+	Source source;
+	source.path = path;
+	source.physicalPath = physicalPath;
+	_entries.push_back( std::move( source ) );
+}
+
+void PakWriter::AddData( const std::wstring &path, const std::string &data )
+{
+	Source source;
+	source.path = path;
+	source.data = data;
+	_entries.push_back( std::move( source ) );
+}
+
+bool PakWriter::Load( const Source &source, std::string &data )
+{
+	if ( source.physicalPath.empty() ) {
+		data = source.data;
+		return true;
+	}
+
+	std::ifstream in( source.physicalPath, std::ios::in | std::ios::binary | std::ios::ate );
+	if ( !in.is_open() ) {
+		_error = "Unable to open " + std::filesystem::path( source.physicalPath ).string();
+		return false;
+	}
+	data.resize( static_cast<size_t>( in.tellg() ) );
+	in.seekg( 0, std::ios::beg );
+	in.read( &data[0], static_cast<std::streamsize>( data.size() ) );
+	if ( static_cast<size_t>( in.gcount() ) != data.size() ) {
+		_error = "Unable to read " + std::filesystem::path( source.physicalPath ).string();
+		return false;
+	}
+	return true;
+}
+
+bool PakWriter::Save( const std::wstring &file )
+{
+	_error.clear();
+	_duplicates = 0;
+	_compressed = 0;
+
+	// the entries are sorted by path so the tree of nodes can be built in one pass when the pack is mapped
+	std::vector<const Source *> sources;
+	sources.reserve( _entries.size() );
+	for ( auto &entry : _entries ) {
+		sources.push_back( &entry );
+	}
+	std::stable_sort( sources.begin(), sources.end(), []( const Source * a, const Source * b ) {
+		return a->path < b->path;
+	} );
+	sources.erase( std::unique( sources.begin(), sources.end(), []( const Source * a, const Source * b ) {
+		return a->path == b->path;
+	} ), sources.end() );
+
+	// the hash table needs twice as many buckets as there are entries
+	if ( sources.size() > PAK_MAX_ENTRIES ) {
+		_error = "Too many entries";
+		return false;
+	}
+
+	PakHeader header;
+	header.signature = PAK_SIGNATURE;
+	header.version = PAK_VERSION;
+	header.blockSize = _blockSize;
+	header.bucketCount = 1;
+	// keeping the table at most half full means most lookups find thier entry in the first bucket
+	while ( header.bucketCount < sources.size() * 2 ) {
+		header.bucketCount <<= 1;
+	}
+	header.entryCount = sources.size();
+	header.namesLength = 0;
+	header.blockOffset = 0;
+	header.blockCount = 0;
+
+	std::vector<UINT32> buckets( header.bucketCount, PAK_EMPTY_BUCKET );
+	std::vector<PakEntry> entries( sources.size() );
+	std::vector<wchar_t> names;
+	for ( size_t i = 0; i < sources.size(); ++i ) {
+		const std::wstring &path = sources[i]->path;
+		PakEntry &entry = entries[i];
+		entry.hash = PakHash( path.c_str(), path.size() );
+		entry.path = names.size();
+		entry.pathLength = static_cast<UINT32>( path.size() );
+		entry.flags = 0;
+		entry.offset = 0;
+		entry.size = 0;
+		names.insert( names.end(), path.c_str(), path.c_str() + path.size() + 1 );
+
+		UINT32 bucket = static_cast<UINT32>( entry.hash ) & ( header.bucketCount - 1 );
+		while ( buckets[bucket] != PAK_EMPTY_BUCKET ) {
+			bucket = ( bucket + 1 ) & ( header.bucketCount - 1 );
+		}
+		buckets[bucket] = static_cast<UINT32>( i );
+	}
+	header.namesLength = names.size();
+
+	std::ofstream out( file, std::ios::out | std::ios::binary | std::ios::trunc );
+	if ( !out.is_open() ) {
+		_error = "Unable to create " + std::filesystem::path( file ).string();
+		return false;
+	}
+
+	// the data is written in layout order, which is independent of the order of the index
+	std::unordered_map<std::wstring, size_t> ranks;
+	for ( auto &path : _layout ) {
+		ranks.insert( std::make_pair( path, ranks.size() ) );
+	}
+	std::vector<std::pair<size_t, size_t>> layout;
+	for ( size_t i = 0; i < sources.size(); ++i ) {
+		auto rank = ranks.find( sources[i]->path );
+		layout.push_back( std::make_pair( rank != ranks.end() ? rank->second : ranks.size(), i ) );
+	}
+	std::sort( layout.begin(), layout.end() );
+
+	// the index is filled in once the data has been written and the location of every entry is known
+	UINT64 position = PakNamesOffset( header ) + header.namesLength * sizeof( wchar_t );
+	Pad( out, position );
+
+	std::vector<PakBlock> blocks;
+	std::unordered_multimap<UINT64, size_t> written;
+	std::string data, other, compressed;
+	std::vector<PakBlock> entryBlocks;
+	for ( auto &next : layout ) {
+		const size_t i = next.second;
+		if ( !Load( *sources[i], data ) ) {
+			return false;
+		}
+		PakEntry &entry = entries[i];
+		entry.size = data.size();
+
+		// entries with the same contents as an earlier entry share its data
+		UINT64 contentHash = ContentHash( data );
+		bool duplicate = false;
+		auto range = written.equal_range( contentHash );
+		for ( auto it = range.first; it != range.second && !duplicate; ++it ) {
+			const PakEntry &original = entries[it->second];
+			if ( original.size == entry.size && Load( *sources[it->second], other ) && other == data ) {
+				entry.offset = original.offset;
+				entry.flags = original.flags;
+				duplicate = true;
+			}
+		}
+		if ( duplicate ) {
+			++_duplicates;
+			continue;
+		}
+		if ( !data.empty() ) {
+			written.emplace( contentHash, i );
+		}
+
+		compressed.clear();
+		entryBlocks.clear();
+		if ( _compression ) {
+			for ( size_t offset = 0; offset < data.size(); offset += _blockSize ) {
+				uLong length = static_cast<uLong>( std::min<size_t>( _blockSize, data.size() - offset ) );
+				uLongf compressedLength = compressBound( length );
+				size_t start = compressed.size();
+				compressed.resize( start + compressedLength );
+
+				PakBlock block;
+				block.offset = start;
+				if ( compress2( reinterpret_cast<Bytef *>( &compressed[start] ), &compressedLength, reinterpret_cast<const Bytef *>( data.data() + offset ), length, Z_BEST_COMPRESSION ) == Z_OK && compressedLength < length ) {
+					compressed.resize( start + compressedLength );
+					block.size = static_cast<UINT32>( compressedLength );
+					block.flags = PAK_BLOCK_COMPRESSED;
+				} else {
+					compressed.resize( start );
+					compressed.append( data, offset, length );
+					block.size = length;
+					block.flags = 0;
+				}
+				entryBlocks.push_back( block );
+			}
+		}
+
+		// compressed entries cost a copy to read, so they are only kept if they save at least an eighth of the entry
+		bool compress = !entryBlocks.empty() && compressed.size() <= data.size() - data.size() / 8;
+		const std::string &content = compress ? compressed : data;
+
+		UINT64 pageOffset = position % PAK_PAGE_SIZE;
+		if ( pageOffset && ( content.size() >= PAK_PAGE_SIZE || pageOffset + content.size() > PAK_PAGE_SIZE ) ) {
+			Pad( out, PAK_PAGE_SIZE - pageOffset );
+			position += PAK_PAGE_SIZE - pageOffset;
+		}
+
+		if ( compress ) {
+			entry.flags = PAK_ENTRY_COMPRESSED;
+			entry.offset = blocks.size();
+			for ( auto block : entryBlocks ) {
+				block.offset += position;
+				blocks.push_back( block );
+			}
+			++_compressed;
+		} else {
+			entry.flags = 0;
+			entry.offset = position;
+		}
+		out.write( content.data(), static_cast<std::streamsize>( content.size() ) );
+		position += content.size();
+	}
+
+	Pad( out, ( 8 - position % 8 ) % 8 );
+	position += ( 8 - position % 8 ) % 8;
+	header.blockOffset = position;
+	header.blockCount = blocks.size();
+	out.write( reinterpret_cast<const char *>( blocks.data() ), static_cast<std::streamsize>( blocks.size() * sizeof( PakBlock ) ) );
+
+	out.seekp( 0, std::ios::beg );
+	out.write( reinterpret_cast<const char *>( &header ), sizeof( PakHeader ) );
+	out.write( reinterpret_cast<const char *>( buckets.data() ), static_cast<std::streamsize>( buckets.size() * sizeof( UINT32 ) ) );
+	out.seekp( static_cast<std::streamoff>( PakEntriesOffset( header ) ), std::ios::beg );
+	out.write( reinterpret_cast<const char *>( entries.data() ), static_cast<std::streamsize>( entries.size() * sizeof( PakEntry ) ) );
+	out.write( reinterpret_cast<const char *>( names.data() ), static_cast<std::streamsize>( names.size() * sizeof( wchar_t ) ) );
+	out.close();
+
+	if ( out.fail() ) {
+		_error = "Unable to write " + std::filesystem::path( file ).string();
+		return false;
+	}
+	return true;
+}
+
+}
+}
+}
+}
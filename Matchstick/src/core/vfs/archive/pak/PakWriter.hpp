@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "PakFormat.hpp"
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace pak
+{
+
+/**
+builds a .mgdfpak file. Entries with identical contents are only stored once, and entries are compressed
+block by block unless compression doesn't make them meaningfully smaller. Stored entries start on a page
+boundary (or if smaller than a page, never straddle one) so they can be read directly from a mapping of the pack
+*/
+class PakWriter
+{
+public:
+	PakWriter();
+	virtual ~PakWriter() {}
+
+	/**
+	add a file to the pack, the file is not read until the pack is saved
+	\param path the path of the entry within the pack, using '/' as the separator
+	*/
+	void AddFile( const std::wstring &path, const std::wstring &physicalPath );
+	void AddData( const std::wstring &path, const std::string &data );
+
+	void SetCompression( bool enabled ) {
+		_compression = enabled;
+	}
+	void SetBlockSize( UINT32 blockSize ) {
+		_blockSize = blockSize;
+	}
+
+	/**
+	set the order that the data of the entries is written in, so that entries which are loaded together
+	can be read sequentially. Entries which aren't in the layout are written after those which are, in path order
+	\param order the paths of the entries in the order they should be written
+	*/
+	void SetLayout( const std::vector<std::wstring> &order ) {
+		_layout = order;
+	}
+
+	/**
+	write the pack, if more than one entry has the same path then only the first one added is kept
+	\return false if any of the files couldn't be read or the pack couldn't be written
+	*/
+	bool Save( const std::wstring &file );
+
+	/**
+	the error which caused the last call to Save to fail
+	*/
+	const std::string &GetError() const {
+		return _error;
+	}
+	size_t GetEntryCount() const {
+		return _entries.size();
+	}
+	/**
+	the number of entries written by the last call to Save which shared thier data with an earlier entry
+	*/
+	size_t GetDuplicateCount() const {
+		return _duplicates;
+	}
+	size_t GetCompressedCount() const {
+		return _compressed;
+	}
+
+private:
+	struct Source {
+		std::wstring path;
+		std::wstring physicalPath;
+		std::string data;
+	};
+
+	bool Load( const Source &source, std::string &data );
+
+	std::vector<Source> _entries;
+	std::vector<std::wstring> _layout;
+	std::string _error;
+	bool _compression;
+	UINT32 _blockSize;
+	size_t _duplicates;
+	size_t _compressed;
+};
+
+}
+}
+}
+}
@@ -7,6 +7,15 @@
 #include "ZipFolderImpl.hpp"
 #include "ZipArchiveHandlerImpl.hpp"
 
+#include <algorithm>
+#include <filesystem>
+
+// std min&max are used instead of the macros
+#ifdef min
+#undef min
+#undef max
+#endif
+
 
 #if defined(_DEBUG)
 #define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
@@ -26,9 +35,73 @@ namespace zip
 
 #define FILENAME_BUFFER 512
 
-ZipArchive::ZipArchive( IErrorHandler *errorHandler )
-	: _errorHandler( errorHandler )
+#define LOCAL_HEADER_SIGNATURE 0x04034b50
+#define LOCAL_HEADER_SIZE 30
+#define CENTRAL_HEADER_SIGNATURE 0x02014b50
+#define CENTRAL_HEADER_SIZE 46
+#define END_OF_CENTRAL_DIRECTORY_SIGNATURE 0x06054b50
+#define END_OF_CENTRAL_DIRECTORY_SIZE 22
+#define ZIP64_END_OF_CENTRAL_DIRECTORY_SIGNATURE 0x06064b50
+#define ZIP64_END_OF_CENTRAL_DIRECTORY_SIZE 56
+#define ZIP64_LOCATOR_SIGNATURE 0x07064b50
+#define ZIP64_LOCATOR_SIZE 20
+#define ZIP64_EXTRA_FIELD 0x0001
+#define ZIP64_MARKER 0xffffffff
+#define MAX_COMMENT_SIZE 0xffff
+#define ENCRYPTED_FLAG 1
+
+template <typename T>
+static T ReadValue( const char *data )
+{
+	T value;
+	memcpy( &value, data, sizeof( T ) );
+	return value;
+}
+
+/**
+replace any values from a central directory header which were too large to fit in the header with their
+64 bit values, which zip64 archives store in an extended information field in the headers extra data
+\return false if the extended information is missing or truncated
+*/
+static bool ReadZip64Values( const char *extra, UINT16 extraLength, UINT64 *uncompressedSize, UINT64 *compressedSize, UINT64 *localOffset )
+{
+	const char *end = extra + extraLength;
+	while ( extra + 4 <= end ) {
+		UINT16 id = ReadValue<UINT16>( extra );
+		UINT16 size = ReadValue<UINT16>( extra + 2 );
+		extra += 4;
+		if ( extra + size > end ) break;
+
+		if ( id == ZIP64_EXTRA_FIELD ) {
+			// only the values which overflowed are present, in this order
+			UINT64 *values[] = { uncompressedSize, compressedSize, localOffset };
+			const char *value = extra;
+			for ( auto v : values ) {
+				if ( *v != ZIP64_MARKER ) continue;
+				if ( value + sizeof( UINT64 ) > extra + size ) return false;
+				*v = ReadValue<UINT64>( value );
+				value += sizeof( UINT64 );
+			}
+			return true;
+		}
+		extra += size;
+	}
+	return false;
+}
+
+ZipArchive::ZipArchive( IErrorHandler *errorHandler, INT64 streamingThreshold, EntryCache *entryCache )
+	: _zip( nullptr )
 	, _root( nullptr )
+	, _errorHandler( errorHandler )
+	, _streamingThreshold( streamingThreshold )
+	, _entryCache( entryCache )
+	, _viewCreated( false )
+	, _viewMapping( nullptr )
+	, _view( nullptr )
+	, _viewSize( 0 )
+	, _bytesBeforeArchive( 0 )
+	, _directoryOffset( 0 )
+	, _directorySize( 0 )
 {
 	_ASSERTE( errorHandler );
 }
@@ -37,9 +110,151 @@ ZipArchive::~ZipArchive()
 {
 	if ( _zip )
 		unzClose( _zip );
+	for ( auto handle : _handles ) {
+		unzClose( handle );
+	}
+	DestroyView();
+	if ( _entryCache && _root ) {
+		_entryCache->Remove( _root );
+	}
+}
+
+bool ZipArchive::CreateView()
+{
+	// other programs must still be able to replace the archive while it is viewed
+	HANDLE file = CreateFileW( _root->GetPhysicalPath(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if ( file == INVALID_HANDLE_VALUE ) {
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	// the archive must fit into the address space to be viewed in one piece
+	if ( GetFileSizeEx( file, &size ) && size.QuadPart >= END_OF_CENTRAL_DIRECTORY_SIZE && static_cast<UINT64>( size.QuadPart ) <= SIZE_MAX ) {
+		_viewMapping = CreateFileMappingW( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+		if ( _viewMapping ) {
+			_view = static_cast<const char *>( MapViewOfFile( _viewMapping, FILE_MAP_READ, 0, 0, 0 ) );
+			_viewSize = static_cast<UINT64>( size.QuadPart );
+		}
+	}
+	CloseHandle( file );
+
+	if ( !_view ) {
+		DestroyView();
+		return false;
+	}
+
+	// the offsets in the archive are relative to the start of the archive, which is found by comparing where the
+	// central directory actually is with where the end of central directory record says it is
+	UINT64 minimum = _viewSize > END_OF_CENTRAL_DIRECTORY_SIZE + MAX_COMMENT_SIZE ? _viewSize - END_OF_CENTRAL_DIRECTORY_SIZE - MAX_COMMENT_SIZE : 0;
+	for ( UINT64 end = _viewSize - END_OF_CENTRAL_DIRECTORY_SIZE + 1; end-- > minimum; ) {
+		if ( ReadValue<UINT32>( _view + end ) == END_OF_CENTRAL_DIRECTORY_SIGNATURE ) {
+			UINT64 directoryEnd = end;
+			UINT64 directorySize = ReadValue<UINT32>( _view + end + 12 );
+			UINT64 directoryOffset = ReadValue<UINT32>( _view + end + 16 );
+
+			// zip64 archives keep the location of the central directory in a separate record, which is found
+			// using the locator immediately before the end of central directory record
+			if ( end >= ZIP64_LOCATOR_SIZE && ReadValue<UINT32>( _view + end - ZIP64_LOCATOR_SIZE ) == ZIP64_LOCATOR_SIGNATURE ) {
+				UINT64 record = ReadValue<UINT64>( _view + end - ZIP64_LOCATOR_SIZE + 8 );
+				if ( record + ZIP64_END_OF_CENTRAL_DIRECTORY_SIZE > end || ReadValue<UINT32>( _view + record ) != ZIP64_END_OF_CENTRAL_DIRECTORY_SIGNATURE ) break;
+				directoryEnd = record;
+				directorySize = ReadValue<UINT64>( _view + record + 40 );
+				directoryOffset = ReadValue<UINT64>( _view + record + 48 );
+			}
+
+			if ( directorySize + directoryOffset > directoryEnd ) break;
+			_bytesBeforeArchive = directoryEnd - directorySize - directoryOffset;
+			_directoryOffset = directoryOffset;
+			_directorySize = directorySize;
+			return true;
+		}
+	}
+
+	LOG( "Unable to find central directory in " << Resources::ToString( _root->GetPhysicalPath() ), LOG_ERROR );
+	DestroyView();
+	return false;
+}
+
+void ZipArchive::DestroyView()
+{
+	if ( _view ) {
+		UnmapViewOfFile( _view );
+		_view = nullptr;
+	}
+	if ( _viewMapping ) {
+		CloseHandle( _viewMapping );
+		_viewMapping = nullptr;
+	}
+	_viewSize = 0;
+}
+
+const char *ZipArchive::GetStoredData( const ZipFileHeader &header )
+{
+	{
+		std::lock_guard<std::mutex> lock( _viewMutex );
+		if ( !_viewCreated ) {
+			_viewCreated = true;
+			CreateView();
+		}
+	}
+	if ( !_view ) return nullptr;
+
+	UINT64 central = _bytesBeforeArchive + header.filePosition.pos_in_zip_directory;
+	if ( central + CENTRAL_HEADER_SIZE > _viewSize || ReadValue<UINT32>( _view + central ) != CENTRAL_HEADER_SIGNATURE ) {
+		return nullptr;
+	}
+
+	// only entries which are stored uncompressed and unencrypted can be read in place
+	UINT16 flags = ReadValue<UINT16>( _view + central + 8 );
+	UINT16 method = ReadValue<UINT16>( _view + central + 10 );
+	UINT64 compressedSize = ReadValue<UINT32>( _view + central + 20 );
+	UINT64 uncompressedSize = ReadValue<UINT32>( _view + central + 24 );
+	UINT64 localOffset = ReadValue<UINT32>( _view + central + 42 );
+	if ( compressedSize == ZIP64_MARKER || uncompressedSize == ZIP64_MARKER || localOffset == ZIP64_MARKER ) {
+		UINT16 nameLength = ReadValue<UINT16>( _view + central + 28 );
+		UINT16 extraLength = ReadValue<UINT16>( _view + central + 30 );
+		UINT64 extra = central + CENTRAL_HEADER_SIZE + nameLength;
+		if ( extra + extraLength > _viewSize || !ReadZip64Values( _view + extra, extraLength, &uncompressedSize, &compressedSize, &localOffset ) ) {
+			return nullptr;
+		}
+	}
+	if ( method != 0 || ( flags & ENCRYPTED_FLAG ) || compressedSize != uncompressedSize || uncompressedSize != static_cast<UINT64>( header.size ) ) {
+		return nullptr;
+	}
+
+	UINT64 local = _bytesBeforeArchive + localOffset;
+	if ( local + LOCAL_HEADER_SIZE > _viewSize || ReadValue<UINT32>( _view + local ) != LOCAL_HEADER_SIGNATURE ) {
+		return nullptr;
+	}
+	UINT64 data = local + LOCAL_HEADER_SIZE + ReadValue<UINT16>( _view + local + 26 ) + ReadValue<UINT16>( _view + local + 28 );
+	if ( data + static_cast<UINT64>( header.size ) > _viewSize ) {
+		return nullptr;
+	}
+	return _view + data;
 }
 
-ZipFileRoot *ZipArchive::MapArchive( const wchar_t *name, const wchar_t * physicalPath, IFile *parent )
+unzFile ZipArchive::AcquireHandle()
+{
+	{
+		std::lock_guard<std::mutex> lock( _handlesMutex );
+		if ( !_handles.empty() ) {
+			unzFile handle = _handles.back();
+			_handles.pop_back();
+			return handle;
+		}
+	}
+	// every pooled handle is in use, so open another one
+	return unzOpen( _root->GetPhysicalPath() );
+}
+
+void ZipArchive::ReleaseHandle( unzFile handle )
+{
+	if ( !handle ) return;
+	std::lock_guard<std::mutex> lock( _handlesMutex );
+	_handles.push_back( handle );
+}
+
+ZipFileRoot *ZipArchive::MapArchive( const wchar_t *name, const wchar_t * physicalPath, IFile *parent, Manifest *manifest )
 {
 	_ASSERTE( name );
 	_ASSERTE( physicalPath );
@@ -47,33 +262,69 @@ ZipFileRoot *ZipArchive::MapArchive( const wchar_t *name, const wchar_t * physic
 	_zip = unzOpen( physicalPath );
 
 	if ( _zip ) {
-		_root = new ZipFileRoot( name, physicalPath, parent, _errorHandler );
-
-		// We need to map file positions to speed up opening later
-		for ( INT32 ret = unzGoToFirstFile( _zip ); ret == UNZ_OK; ret = unzGoToNextFile( _zip ) ) {
-			unz_file_info info;
-			char name[FILENAME_BUFFER];
-
-			unzGetCurrentFileInfo( _zip, &info, name, FILENAME_BUFFER, nullptr, 0, nullptr, 0 );
-
-			//if the path is for a folder the last element will be a "" element (because all path element names
-			//found using zlib include a trailing "/") this means that the entire folder tree will be created
-			//in the case of folders, and that the last element will be excluded for files which is the desired behaviour
-			const wchar_t *filename = nullptr;
-			std::wstring path = Resources::ToWString( name );
-			IFile *parentFile = CreateParentFile( path, _root, &filename );
-
-			if ( info.uncompressed_size > 0 ) {
-				_ASSERTE( filename );
-				ZipFileHeader header;
-				unzGetFilePos( _zip, &header.filePosition );
-				header.size = info.uncompressed_size;
-				header.name = filename;//the name is the last part of the path
-
-				ZipFileImpl *zipFile = new ZipFileImpl( parentFile, this, std::move( header ) );
-				static_cast<FileBaseImpl *>( parentFile )->AddChild( zipFile );
+		_root = _arena.New<ZipFileRoot>( _arena.Intern( name, wcslen( name ) ), _arena.Copy( physicalPath, wcslen( physicalPath ) ), parent, &_arena, _errorHandler );
+
+		INT64 lastWriteTime = 0;
+		INT64 size = 0;
+		std::vector<ManifestEntry> records;
+		if ( manifest ) {
+			std::error_code error;
+			lastWriteTime = Manifest::GetLastWriteTime( physicalPath );
+			size = static_cast<INT64>( std::filesystem::file_size( physicalPath, error ) );
+		}
+
+		std::vector<MappedEntry> entries;
+		std::vector<wchar_t> paths;
+		if ( manifest && manifest->GetRecord( physicalPath, lastWriteTime, size, records ) ) {
+			//the archive hasn't changed since it was recorded, so there is no need to read its central directory
+			entries.reserve( records.size() );
+			for ( auto &record : records ) {
+				MappedEntry entry;
+				entry.path = paths.size();
+				entry.length = wcslen( record.name );
+				entry.size = record.size;
+				entry.dosTime = static_cast<UINT32>( record.lastWriteTime );
+				entry.stored = ( record.flags & ManifestEntry::STORED ) != 0;
+				entry.position.pos_in_zip_directory = record.position;
+				entry.position.num_of_file = record.index;
+				paths.insert( paths.end(), record.name, record.name + entry.length + 1 );
+				entries.push_back( entry );
+			}
+		} else {
+			// the central directory is read straight out of a view where possible, otherwise each entry
+			// is read through minizip instead
+			if ( !CreateView() || !ReadCentralDirectory( entries, paths ) ) {
+				entries.clear();
+				paths.clear();
+				ReadEntries( entries, paths );
+			}
+			// most archives are entirely compressed, so the view is only kept if a stored entry is opened later
+			DestroyView();
+
+			if ( manifest ) {
+				records.reserve( entries.size() );
+				for ( auto &entry : entries ) {
+					ManifestEntry record;
+					record.name = paths.data() + entry.path;
+					record.flags = entry.stored ? ManifestEntry::STORED : 0;
+					record.size = entry.size;
+					record.position = entry.position.pos_in_zip_directory;
+					record.index = entry.position.num_of_file;
+					record.lastWriteTime = entry.dosTime;
+					records.push_back( record );
+				}
+				manifest->AddRecord( physicalPath, lastWriteTime, size, records );
 			}
 		}
+
+		if ( manifest ) {
+			_root->SetMetadata( size, lastWriteTime );
+		}
+		MapEntries( entries, paths );
+
+		// the handle used for mapping becomes the first handle in the pool
+		ReleaseHandle( _zip );
+		_zip = nullptr;
 	} else {
 		LOG( "Could not open archive " << Resources::ToString( physicalPath ), LOG_ERROR );
 		return nullptr;
@@ -82,79 +333,210 @@ ZipFileRoot *ZipArchive::MapArchive( const wchar_t *name, const wchar_t * physic
 	return _root;
 }
 
-IFile *ZipArchive::CreateParentFile( std::wstring &path, IFile *root, const wchar_t **filename )
+/**
+append a utf8 path from the archive to the path buffer as a null terminated wide string
+\return the length of the wide string
+*/
+static size_t AppendPath( const char *path, size_t length, std::vector<wchar_t> &paths )
 {
-	_ASSERTE( root );
-	_ASSERTE( path.size() );
+	size_t start = paths.size();
 
-	size_t len = path.rfind( '/' );
-	if ( len == std::wstring::npos ) {
-		*filename = path.data();
-		len = 0;
+	// almost all paths are plain ascii, which can be widened without converting them
+	bool ascii = true;
+	for ( size_t i = 0; i < length; ++i ) {
+		if ( static_cast<unsigned char>( path[i] ) >= 0x80 ) {
+			ascii = false;
+			break;
+		}
+	}
+
+	if ( ascii ) {
+		paths.insert( paths.end(), path, path + length );
 	} else {
-		path[len] = '\0';
-		*filename = &path.data() [len + 1];
+		int wideLength = MultiByteToWideChar( CP_UTF8, 0, path, static_cast<int>( length ), nullptr, 0 );
+		paths.resize( start + wideLength );
+		MultiByteToWideChar( CP_UTF8, 0, path, static_cast<int>( length ), paths.data() + start, wideLength );
 	}
+	paths.push_back( L'\0' );
+	return paths.size() - start - 1;
+}
 
-	size_t start = 0;
-	size_t end = 0;
-	IFile *parent = root;
+bool ZipArchive::ReadCentralDirectory( std::vector<MappedEntry> &entries, std::vector<wchar_t> &paths )
+{
+	UINT64 position = _bytesBeforeArchive + _directoryOffset;
+	const UINT64 end = position + _directorySize;
+	if ( end > _viewSize ) return false;
+
+	// the paths take up no more characters than the bytes they occupy in the central directory
+	entries.reserve( static_cast<size_t>( _directorySize / CENTRAL_HEADER_SIZE ) );
+	paths.reserve( static_cast<size_t>( _directorySize ) );
 
-	while ( end < len ) {
-		while ( end < len && path[end] != '/' ) {
-			++end;
+	for ( UINT64 index = 0; position + CENTRAL_HEADER_SIZE <= end; ++index ) {
+		const char *header = _view + position;
+		if ( ReadValue<UINT32>( header ) != CENTRAL_HEADER_SIGNATURE ) {
+			LOG( "Invalid central directory header in " << Resources::ToString( _root->GetPhysicalPath() ), LOG_ERROR );
+			return false;
 		}
-		if ( end != start ) {
-			path[end] = '\0';
-			IFile *child = parent->GetChild( &path[start] );
-			if ( !child ) {
-				child = new ZipFolderImpl( &path[start], parent, this );
-				static_cast<FileBaseImpl *>( parent )->AddChild( child );
+
+		UINT16 nameLength = ReadValue<UINT16>( header + 28 );
+		UINT16 extraLength = ReadValue<UINT16>( header + 30 );
+		UINT16 commentLength = ReadValue<UINT16>( header + 32 );
+		UINT64 next = position + CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+		if ( next > end ) return false;
+
+		UINT64 uncompressedSize = ReadValue<UINT32>( header + 24 );
+		if ( uncompressedSize == ZIP64_MARKER ) {
+			UINT64 compressedSize = ReadValue<UINT32>( header + 20 );
+			UINT64 localOffset = ReadValue<UINT32>( header + 42 );
+			if ( !ReadZip64Values( header + CENTRAL_HEADER_SIZE + nameLength, extraLength, &uncompressedSize, &compressedSize, &localOffset ) ) {
+				return false;
 			}
-			parent = child;
 		}
-		++end;
-		start = end;
+
+		MappedEntry entry;
+		entry.path = paths.size();
+		entry.length = AppendPath( header + CENTRAL_HEADER_SIZE, nameLength, paths );
+		entry.size = static_cast<INT64>( uncompressedSize );
+		entry.dosTime = ReadValue<UINT32>( header + 12 );
+		entry.stored = ReadValue<UINT16>( header + 10 ) == 0 && !( ReadValue<UINT16>( header + 8 ) & ENCRYPTED_FLAG );
+		entry.position.pos_in_zip_directory = position - _bytesBeforeArchive;
+		entry.position.num_of_file = index;
+		entries.push_back( entry );
+
+		position = next;
 	}
+	return true;
+}
+
+void ZipArchive::ReadEntries( std::vector<MappedEntry> &entries, std::vector<wchar_t> &paths )
+{
+	for ( INT32 ret = unzGoToFirstFile( _zip ); ret == UNZ_OK; ret = unzGoToNextFile( _zip ) ) {
+		unz_file_info64 info;
+		char name[FILENAME_BUFFER];
+		unzGetCurrentFileInfo64( _zip, &info, name, FILENAME_BUFFER, nullptr, 0, nullptr, 0 );
 
-	return parent;
+		MappedEntry entry;
+		entry.path = paths.size();
+		entry.length = AppendPath( name, strnlen( name, FILENAME_BUFFER ), paths );
+		entry.size = static_cast<INT64>( info.uncompressed_size );
+		entry.dosTime = static_cast<UINT32>( info.dosDate );
+		entry.stored = info.compression_method == 0 && !( info.flag & ENCRYPTED_FLAG );
+		unzGetFilePos64( _zip, &entry.position );
+		entries.push_back( entry );
+	}
 }
 
-MGDFError ZipArchive::GetFileData( ZipFileHeader &header, ZipFileData &data )
+void ZipArchive::MapEntries( std::vector<MappedEntry> &entries, const std::vector<wchar_t> &paths )
 {
-	//if the entry is already in the map then the file is already open
-	//if its not in the hashmap then open it
-	unzGoToFilePos( _zip, &header.filePosition );
+	// once sorted by path, all the entries within a folder are next to each other. This means the tree can be
+	// built in one pass, keeping track of only the folders which contain the current entry
+	std::stable_sort( entries.begin(), entries.end(), [&paths]( const MappedEntry &a, const MappedEntry &b ) {
+		return wcscmp( paths.data() + a.path, paths.data() + b.path ) < 0;
+	} );
+
+	struct OpenFolder {
+		const wchar_t *path;
+		size_t length; // the length of the folders path, including the trailing '/'
+		FileBaseImpl *folder;
+	};
+	std::vector<OpenFolder> open;
+	std::vector<FileBaseImpl *> folders;
+
+	for ( auto &entry : entries ) {
+		const wchar_t *path = paths.data() + entry.path;
+
+		while ( !open.empty() && ( open.back().length > entry.length || wcsncmp( open.back().path, path, open.back().length ) != 0 ) ) {
+			open.pop_back();
+		}
+		FileBaseImpl *parent = open.empty() ? _root : open.back().folder;
+		size_t start = open.empty() ? 0 : open.back().length;
+
+		//all paths to folders found in the central directory include a trailing "/" so the entire folder tree
+		//is created for folders, while the last element is left over as the name for files
+		for ( size_t end = start; end < entry.length; ++end ) {
+			if ( path[end] != L'/' ) continue;
+			if ( end != start ) {
+				FileBaseImpl *folder = _arena.New<ZipFolderImpl>( _arena.Intern( path + start, end - start ), parent, this );
+				parent->AddChild( folder );
+				folders.push_back( folder );
+				parent = folder;
+			}
+			open.push_back( { path, end + 1, parent } );
+			start = end + 1;
+		}
 
+		if ( entry.size > 0 && start < entry.length ) {
+			ZipFileHeader header;
+			header.filePosition = entry.position;
+			header.size = entry.size;
+			header.dosTime = entry.dosTime;
+			header.stored = entry.stored;
+			header.name = _arena.Intern( path + start, entry.length - start );//the name is the last part of the path
+
+			ZipFileImpl *zipFile = _arena.New<ZipFileImpl>( parent, this, std::move( header ) );
+			parent->AddChild( zipFile );
+		}
+	}
 
-	if ( header.size > UINT32_MAX ) {
-		std::string message = "Archive files cannot be over 4GB in size";
-		LOG( "Archive files cannot be over 4GB in size " << Resources::ToString( header.name ), LOG_ERROR );
+	// the archive contents never change once mapped, so the children of
+	// every node can now be frozen into sorted arrays
+	_root->FreezeChildren();
+	for ( auto folder : folders ) {
+		folder->FreezeChildren();
+	}
+}
+
+MGDFError ZipArchive::GetFileData( ZipFileHeader &header, char **data )
+{
+	// larger entries can still be streamed, but can't be decompressed into a single buffer
+	if ( static_cast<UINT64>( header.size ) > SIZE_MAX ) {
+		LOG( "Archive file is too large to fit in the address space " << Resources::ToString( header.name ), LOG_ERROR );
 		return MGDF_ERR_ARCHIVE_FILE_TOO_LARGE;
 	}
 
-	data.readPosition = 0;
-	data.data = ( char * ) malloc( static_cast<UINT32>( header.size ) );
+	*data = ( char * ) malloc( static_cast<size_t>( header.size ) );
+	MGDFError result = Inflate( header, *data );
+	if ( result != MGDF_OK ) {
+		free( *data );
+		*data = nullptr;
+	}
+	return result;
+}
+
+MGDFError ZipArchive::Inflate( ZipFileHeader &header, char *destination )
+{
+	// each thread inflates using its own handle, so entries can be inflated concurrently
+	unzFile zip = AcquireHandle();
+	if ( !zip ) {
+		LOG( "Unable to open archive for " << Resources::ToString( header.name ), LOG_ERROR );
+		return MGDF_ERR_INVALID_ARCHIVE_FILE;
+	}
+	unzGoToFilePos64( zip, &header.filePosition );
 
 	MGDFError result = MGDF_OK;
-	if ( unzOpenCurrentFile( _zip ) != UNZ_OK ) {
+	if ( unzOpenCurrentFile( zip ) != UNZ_OK ) {
 		result = MGDF_ERR_INVALID_ARCHIVE_FILE;
 		goto cleanup;
 	}
-	if ( unzReadCurrentFile( _zip, data.data, static_cast<UINT32>( header.size ) ) < 0 )  {
-		result = MGDF_ERR_INVALID_ARCHIVE_FILE;
-		goto cleanup;
+	for ( INT64 total = 0; total < header.size; ) {
+		int read = unzReadCurrentFile( zip, destination + total, static_cast<unsigned>( std::min<INT64>( header.size - total, MAX_INFLATE_LENGTH ) ) );
+		if ( read <= 0 ) {
+			unzCloseCurrentFile( zip );
+			result = MGDF_ERR_INVALID_ARCHIVE_FILE;
+			goto cleanup;
+		}
+		total += read;
 	}
-	if ( unzCloseCurrentFile( _zip ) == UNZ_CRCERROR ) {
+	if ( unzCloseCurrentFile( zip ) == UNZ_CRCERROR ) {
 		result = MGDF_ERR_INVALID_ARCHIVE_FILE;
 		goto cleanup;
 	}
+	ReleaseHandle( zip );
 	return result;
 
 cleanup:
+	ReleaseHandle( zip );
 	LOG( "Invalid archive file " << Resources::ToString( header.name ), LOG_ERROR );
-	free( data.data );
-	data.data = nullptr;
 	return result;
 }
 
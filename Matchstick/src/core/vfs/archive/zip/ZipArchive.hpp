@@ -1,9 +1,14 @@
 #pragma once
 
 #include <list>
+#include <vector>
+#include <mutex>
+#include <string>
 #include <unzip.h>
 
 #include "ZipFileRoot.hpp"
+#include "../../MGDFManifest.hpp"
+#include "../../MGDFEntryCache.hpp"
 #include <MGDF/MGDFVirtualFileSystem.hpp>
 
 namespace MGDF
@@ -15,15 +20,15 @@ namespace vfs
 namespace zip
 {
 
+// unzReadCurrentFile returns the bytes read as an int, so large reads are split up
+#define MAX_INFLATE_LENGTH 0x40000000
+
 struct ZipFileHeader {
-	unz_file_pos filePosition;
+	unz64_file_pos filePosition;
 	INT64 size;
-	std::wstring name;
-};
-
-struct ZipFileData {
-	INT64 readPosition;
-	char *data;
+	UINT32 dosTime; // the last write time of the entry as an MS-DOS date and time, in local time
+	bool stored; // stored without compression or encryption, so it can be read in place from a view of the archive
+	const wchar_t *name; //interned in the archives arena
 };
 
 /**
@@ -32,21 +37,98 @@ handles the mapping and access to zip archives by the virtual file
 class ZipArchive
 {
 public:
-	ZipArchive( IErrorHandler *errorHandler );
+	/**
+	\param streamingThreshold entries of at least this size are inflated incrementally as they are read rather than being inflated in full when opened
+	\param entryCache (optional) entries which are inflated in full are kept in this cache after they are closed
+	*/
+	ZipArchive( IErrorHandler *errorHandler, INT64 streamingThreshold, EntryCache *entryCache );
 	virtual ~ZipArchive();
 
-	ZipFileRoot *MapArchive( const wchar_t *name, const wchar_t * physicalPath, IFile *parent );
+	/**
+	map the archive, if a manifest is supplied then the archive is mapped from its manifest record
+	if the record is still valid, otherwise a new record is added after the archive has been scanned
+	*/
+	ZipFileRoot *MapArchive( const wchar_t *name, const wchar_t * physicalPath, IFile *parent, Manifest *manifest = nullptr );
 
 	ZipFileRoot *GetArchiveRoot() const {
 		return _root;
 	}
-	MGDFError GetFileData( ZipFileHeader &header, ZipFileData &data );
+	/**
+	all the nodes (and thier names) in the archive are allocated from this arena
+	*/
+	Arena *GetArena() {
+		return &_arena;
+	}
+	INT64 GetStreamingThreshold() const {
+		return _streamingThreshold;
+	}
+	EntryCache *GetEntryCache() const {
+		return _entryCache;
+	}
+	/**
+	decompress an entry into a buffer allocated with malloc, which the caller must free
+	*/
+	MGDFError GetFileData( ZipFileHeader &header, char **data );
+	/**
+	decompress an entry into a caller supplied buffer
+	\param destination must have room for the uncompressed size of the entry
+	*/
+	MGDFError Inflate( ZipFileHeader &header, char *destination );
+
+	/**
+	get a handle to the archive which is not in use by any other thread. Handles are pooled so that entries
+	can be inflated on as many threads at once as needed, without opening the archive again for every entry.
+	Handles must be returned using ReleaseHandle without an open current file
+	*/
+	unzFile AcquireHandle();
+	void ReleaseHandle( unzFile handle );
+
+	/**
+	get a pointer to the data of an entry which is stored without compression, within a read only mapping of the
+	whole archive. The view is only created the first time this is called, and the pointer remains valid for as
+	long as the archive is mapped
+	\return the data of the entry, or nullptr if the entry is compressed or the archive can't be mapped
+	*/
+	const char *GetStoredData( const ZipFileHeader &header );
 private:
-	unzFile _zip;
+	unzFile _zip; // only used while the archive is being mapped, after which it is added to the pool
+	std::vector<unzFile> _handles;
+	std::mutex _handlesMutex;
+
+	// a view of the whole archive, created the first time a stored entry is opened. The central directory is also
+	// read from a view while the archive is being mapped, but that view is released once mapping is finished
+	std::mutex _viewMutex;
+	bool _viewCreated;
+	HANDLE _viewMapping;
+	const char *_view;
+	UINT64 _viewSize;
+	UINT64 _bytesBeforeArchive; // any data (such as a self extractor) prepended to the archive
+	UINT64 _directoryOffset;
+	UINT64 _directorySize;
 	ZipFileRoot *_root;
 	IErrorHandler *_errorHandler;
+	INT64 _streamingThreshold;
+	EntryCache *_entryCache;
+	Arena _arena;
+
+	/**
+	an entry in the archive which is yet to be added to the tree of nodes. The path is an offset into a
+	buffer of null terminated paths shared by all the entries
+	*/
+	struct MappedEntry {
+		size_t path;
+		size_t length;
+		INT64 size;
+		UINT32 dosTime;
+		bool stored;
+		unz64_file_pos position;
+	};
 
-	IFile *CreateParentFile( std::wstring &path, IFile *root, const wchar_t ** );
+	bool CreateView();
+	void DestroyView();
+	bool ReadCentralDirectory( std::vector<MappedEntry> &entries, std::vector<wchar_t> &paths );
+	void ReadEntries( std::vector<MappedEntry> &entries, std::vector<wchar_t> &paths );
+	void MapEntries( std::vector<MappedEntry> &entries, const std::vector<wchar_t> &paths );
 };
 
 }
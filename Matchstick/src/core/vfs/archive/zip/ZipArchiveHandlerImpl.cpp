@@ -11,6 +11,8 @@
 
 const wchar_t *ZIP_EXT = L".zip";
 
+#define DEFAULT_STREAMING_THRESHOLD 1048576
+
 namespace MGDF
 {
 namespace core
@@ -28,18 +30,26 @@ IArchiveHandler *CreateZipArchiveHandlerImpl( IErrorHandler *errorHandler )
 
 ZipArchiveHandlerImpl::ZipArchiveHandlerImpl( IErrorHandler *errorHandler )
 	: _errorHandler( errorHandler )
+	, _streamingThreshold( DEFAULT_STREAMING_THRESHOLD )
+	, _entryCache( nullptr )
 {
 	_fileExtensions.push_back( ZIP_EXT );
 }
 
 IFile *ZipArchiveHandlerImpl::MapArchive( const wchar_t * name, const wchar_t * physicalPath, IFile *parent )
+{
+	return MapArchive( name, physicalPath, parent, nullptr );
+}
+
+IFile *ZipArchiveHandlerImpl::MapArchive( const wchar_t * name, const wchar_t * physicalPath, IFile *parent, Manifest *manifest )
 {
 	_ASSERTE( name );
 	_ASSERTE( physicalPath );
 
-	ZipArchive *archive = new ZipArchive( _errorHandler );
-	ZipFileRoot *result = archive->MapArchive( name, physicalPath, parent );
+	ZipArchive *archive = new ZipArchive( _errorHandler, _streamingThreshold, _entryCache );
+	ZipFileRoot *result = archive->MapArchive( name, physicalPath, parent, manifest );
 	if ( result ) {
+		std::lock_guard<std::mutex> lock( _mutex );
 		_archives.insert( std::pair<ZipFileRoot *, zip::ZipArchive *> ( result, archive ) );
 	} else {
 		delete archive;
@@ -57,10 +67,11 @@ void ZipArchiveHandlerImpl::DisposeArchive( IFile *archive )
 {
 	if ( !archive ) return;
 
+	std::lock_guard<std::mutex> lock( _mutex );
 	auto it = _archives.find( static_cast<ZipFileRoot *>( archive ) );
 	_ASSERTE( it != _archives.end() );
 	if ( it != _archives.end() ) {
-		delete it->first;
+		// the archive root is allocated in the archives arena so is destroyed along with the archive
 		delete it->second;
 		_archives.erase( it );
 	}
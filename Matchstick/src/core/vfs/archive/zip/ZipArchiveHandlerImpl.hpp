@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <mutex>
 
 #include <MGDF/MGDF.hpp>
 #include <MGDF/MGDFVirtualFileSystem.hpp>
@@ -21,7 +22,7 @@ namespace zip
 /**
 Creates zip archive handlers
 */
-class ZipArchiveHandlerImpl: public IArchiveHandler
+class ZipArchiveHandlerImpl: public IArchiveHandler, public IManifestArchiveHandler, public ICachingArchiveHandler
 {
 public:
 	ZipArchiveHandlerImpl( IErrorHandler *errorHandler );
@@ -30,11 +31,26 @@ public:
 	void DisposeArchive( IFile *archive ) override final;
 	bool IsArchive( const wchar_t *physicalPath ) const override final;
 	IFile *MapArchive( const wchar_t * name, const wchar_t * physicalPath, IFile *parent ) override final;
+	IFile *MapArchive( const wchar_t * name, const wchar_t * physicalPath, IFile *parent, Manifest *manifest ) override final;
+
+	/**
+	entries of at least this size are inflated incrementally as they are read, smaller entries are inflated in full
+	when opened and the inflated data is shared by all readers of the entry. This only affects archives mapped afterwards
+	*/
+	void SetStreamingThreshold( INT64 threshold ) {
+		_streamingThreshold = threshold;
+	}
+	void SetEntryCache( EntryCache *cache ) override final {
+		_entryCache = cache;
+	}
 
 private:
 	std::map<ZipFileRoot *, ZipArchive *> _archives;
+	std::mutex _mutex; // archives can be mapped concurrently when the vfs maps its content in the background
 	std::vector<const wchar_t *> _fileExtensions;
 	IErrorHandler *_errorHandler;
+	INT64 _streamingThreshold;
+	EntryCache *_entryCache;
 
 	/**
 	get the extension of a file
@@ -1,13 +1,7 @@
 #include "StdAfx.h"
-#include <algorithm>
 
 #include "ZipFileImpl.hpp"
-
-// std min&max are used instead of the macros
-#ifdef min
-#undef min
-#undef max
-#endif
+#include "ZipStreamReader.hpp"
 
 
 #if defined(_DEBUG)
@@ -26,70 +20,139 @@ namespace zip
 
 ZipFileImpl::~ZipFileImpl()
 {
-	Close();
+	// any readers which are still open at this point are no longer valid
 }
 
-MGDFError ZipFileImpl::Open( IFileReader **reader )
+const char *ZipFileImpl::FindStoredData()
 {
-	std::lock_guard<std::mutex> lock( _mutex );
-	if ( !_isOpen ) {
-		MGDFError result = _handler->GetFileData( _header, _data );
-		if ( result == MGDF_OK ) {
-			_isOpen = true;
-			*reader = this;
-		}
+	if ( !_storedChecked ) {
+		// compressed entries never need the archive to be viewed
+		_storedData = _header.stored ? _handler->GetStoredData( _header ) : nullptr;
+		_storedChecked = true;
+	}
+	return _storedData;
+}
+
+MGDFError ZipFileImpl::OpenStreamReader( IFileReader **reader )
+{
+	// each stream reader has its own inflate state
+	ZipStreamReader *streamReader = new ZipStreamReader( this, _handler, _header );
+	MGDFError result = streamReader->Open();
+	if ( result != MGDF_OK ) {
+		delete streamReader;
 		return result;
 	}
-	return MGDF_ERR_FILE_IN_USE;
+	++_readers;
+	*reader = streamReader;
+	return MGDF_OK;
 }
 
-void ZipFileImpl::Close()
+time_t ZipFileImpl::GetLastWriteTime() const
 {
-	std::lock_guard<std::mutex> lock( _mutex );
-	if ( _isOpen ) {
-		free( _data.data );
-		_isOpen = false;
+	// the timestamp recorded in the central directory is local time
+	FILETIME local, utc;
+	if ( !DosDateTimeToFileTime( HIWORD( _header.dosTime ), LOWORD( _header.dosTime ), &local ) || !LocalFileTimeToFileTime( &local, &utc ) ) {
+		return _handler->GetArchiveRoot()->GetLastWriteTime();
 	}
+	return FileTimeToTime( ( static_cast<INT64>( utc.dwHighDateTime ) << 32 ) | utc.dwLowDateTime );
 }
 
-UINT32 ZipFileImpl::Read( void* buffer, UINT32 length )
+MGDFError ZipFileImpl::OpenReader( IFileReader **reader )
 {
-	if ( !buffer ) return 0;
+	std::lock_guard<std::mutex> lock( _mutex );
+	if ( FindStoredData() ) {
+		++_readers;
+		*reader = new MemoryFileReader( this, _storedData, _header.size );
+		return MGDF_OK;
+	}
 
-	UINT32 maxRead = 0;
-	if ( _isOpen ) {
-		maxRead = std::min<UINT32> ( length, static_cast<UINT32>( _header.size - _data.readPosition ) );
-		memcpy( buffer, _data.data + _data.readPosition, maxRead );
-		_data.readPosition += maxRead;
+	if ( _header.size >= _handler->GetStreamingThreshold() ) {
+		// large entries are inflated as they are read
+		return OpenStreamReader( reader );
 	}
 
-	return maxRead;
+	// stream readers can be open without the entry being held decompressed
+	if ( !_data ) {
+		EntryCache *cache = _handler->GetEntryCache();
+		if ( cache ) {
+			_data = cache->Find( _handler->GetArchiveRoot(), _header.filePosition.num_of_file );
+		}
+		if ( !_data ) {
+			char *data = nullptr;
+			MGDFError result = _handler->GetFileData( _header, &data );
+			if ( result != MGDF_OK ) {
+				return result;
+			}
+			_data = EntryCache::Data( data, free );
+			if ( cache ) {
+				cache->Insert( _handler->GetArchiveRoot(), _header.filePosition.num_of_file, _data, static_cast<size_t>( _header.size ) );
+			}
+		}
+	}
+	++_readers;
+	*reader = new MemoryFileReader( this, _data.get(), _header.size );
+	return MGDF_OK;
 }
 
-void ZipFileImpl::SetPosition( INT64 pos )
+MGDFError ZipFileImpl::OpenUnbufferedReader( IFileReader **reader )
 {
-	if ( _isOpen ) {
-		_data.readPosition = pos;
+	std::lock_guard<std::mutex> lock( _mutex );
+	const char *data = FindStoredData();
+	if ( !data ) {
+		// if the entry is already decompressed for other readers then share that copy rather than inflating it again
+		data = _data.get();
 	}
+	if ( data ) {
+		++_readers;
+		*reader = new MemoryFileReader( this, data, _header.size );
+		return MGDF_OK;
+	}
+	return OpenStreamReader( reader );
 }
 
-INT64 ZipFileImpl::GetPosition() const
+MGDFError ZipFileImpl::ReadData( void *buffer, UINT64 *length )
 {
-	if ( _isOpen ) {
-		return _data.readPosition;
+	const UINT64 size = static_cast<UINT64>( _header.size );
+	if ( !buffer || *length < size ) {
+		*length = size;
+		return buffer ? MGDF_ERR_BUFFER_TOO_SMALL : MGDF_OK;
 	}
-	return -1;
+	*length = size;
+
+	const char *data = nullptr;
+	EntryCache::Data decompressed;
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+		data = FindStoredData();
+		if ( !data ) {
+			decompressed = _data;
+			EntryCache *cache = _handler->GetEntryCache();
+			if ( !decompressed && cache ) {
+				decompressed = cache->Find( _handler->GetArchiveRoot(), _header.filePosition.num_of_file );
+			}
+			data = decompressed.get();
+		}
+	}
+	if ( data ) {
+		memcpy( buffer, data, static_cast<size_t>( size ) );
+		return MGDF_OK;
+	}
+
+	// nothing holds a decompressed copy of the entry, so it can be inflated straight into the callers buffer
+	return _handler->Inflate( _header, static_cast<char *>( buffer ) );
 }
 
-bool ZipFileImpl::EndOfFile() const
+void ZipFileImpl::ReleaseReader()
 {
-	if ( _isOpen ) {
-		return _data.readPosition >= _header.size;
+	std::lock_guard<std::mutex> lock( _mutex );
+	_ASSERTE( _readers );
+	if ( --_readers == 0 ) {
+		// if the data is cached then the cache now holds the only reference to it
+		_data.reset();
 	}
-	return true;
 }
 
 }
 }
 }
-}
\ No newline at end of file
+}
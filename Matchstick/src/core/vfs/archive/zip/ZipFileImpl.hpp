@@ -2,6 +2,7 @@
 
 #include "ZipArchive.hpp"
 #include "../../MGDFFileBaseImpl.hpp"
+#include "../../MGDFFileReaderImpl.hpp"
 
 namespace MGDF
 {
@@ -13,16 +14,23 @@ namespace zip
 {
 
 /**
-implementation of a file in a zipped archive
+implementation of a file in a zipped archive. Entries which are stored without compression are read in place
+from a mapping of the archive, so opening them requires no copying at all. Small compressed entries are decompressed when the first reader is opened
+and every reader shares the decompressed data until the last reader is closed, after which the data is kept
+in the entry cache (if there is one) in case the entry is opened again. Large entries are decompressed
+incrementally by each reader as it is read. Unbuffered readers and ReadAll always inflate into the callers
+buffer, unless the entry is already held decompressed for other readers
 */
-class ZipFileImpl: public FileBaseImpl, public IFileReader
+class ZipFileImpl: public FileBaseImpl, public IFileReaderOwner
 {
 public:
 	ZipFileImpl( IFile *parent, ZipArchive *handler, ZipFileHeader && header )
-		: FileBaseImpl( parent )
+		: FileBaseImpl( parent, handler->GetArena() )
 		, _handler( handler )
 		, _header( header )
-		, _isOpen( false ) {
+		, _readers( 0 )
+		, _storedData( nullptr )
+		, _storedChecked( false ) {
 	}
 	virtual ~ZipFileImpl();
 
@@ -35,21 +43,14 @@ public:
 
 	bool IsOpen() const override final {
 		std::lock_guard<std::mutex> lock( _mutex );
-		return _isOpen;
+		return _readers > 0;
 	}
 
-	MGDFError Open( IFileReader **reader ) override final;
-	void Close() override final;
-	UINT32 Read( void* buffer, UINT32 length ) override final;
-	void SetPosition( INT64 pos ) override final;
-	INT64 GetPosition() const override final;
-	bool EndOfFile() const override final;
-	INT64 GetSize() const override {
-		return _header.size;
-	}
+	void ReleaseReader() override final;
 
-	time_t GetLastWriteTime() const override final {
-		return _handler->GetArchiveRoot()->GetLastWriteTime();
+	time_t GetLastWriteTime() const override final;
+	INT64 GetSize() const override final {
+		return _header.size;
 	}
 	const wchar_t *GetArchiveName() const override final {
 		return _handler->GetArchiveRoot()->GetName();
@@ -58,16 +59,26 @@ public:
 		return _handler->GetArchiveRoot()->GetPhysicalPath();
 	}
 	const wchar_t *GetName() const override final {
-		return _header.name.c_str();
+		return _header.name;
 	}
+protected:
+	MGDFError OpenReader( IFileReader **reader ) override final;
+	MGDFError OpenUnbufferedReader( IFileReader **reader ) override final;
+	MGDFError ReadData( void *buffer, UINT64 *length ) override final;
 private:
+	// these must be called with the lock held
+	const char *FindStoredData();
+	MGDFError OpenStreamReader( IFileReader **reader );
+
 	ZipArchive *_handler;
 	ZipFileHeader _header;
-	ZipFileData _data;
-	bool _isOpen;
+	EntryCache::Data _data;
+	UINT32 _readers;
+	const char *_storedData;
+	bool _storedChecked;
 };
 
 }
 }
 }
-}
\ No newline at end of file
+}
@@ -19,19 +19,16 @@ namespace zip
 class ZipFileRoot: public DefaultFileImpl
 {
 public:
-	ZipFileRoot( const std::wstring &name, const std::wstring &physicalPath, IFile *parent, IErrorHandler *errorHandler )
-		: DefaultFileImpl( name, physicalPath, parent, errorHandler )
-		, _archiveName( name ) {
+	ZipFileRoot( const wchar_t *name, const wchar_t *physicalPath, IFile *parent, Arena *arena, IErrorHandler *errorHandler )
+		: DefaultFileImpl( name, physicalPath, parent, arena, errorHandler ) {
 	}
 	virtual ~ZipFileRoot();
 	bool IsArchive() const override final {
 		return true;
 	}
 	const wchar_t *GetArchiveName() const override final {
-		return _archiveName.c_str();
+		return GetName();
 	}
-private:
-	std::wstring _archiveName;
 };
 
 }
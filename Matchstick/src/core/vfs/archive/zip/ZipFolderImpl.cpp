@@ -17,10 +17,7 @@ namespace zip
 
 ZipFolderImpl::~ZipFolderImpl()
 {
-	if ( !_children ) return;
-	for ( auto child : *_children ) {
-		delete static_cast<FileBaseImpl *>( child.second );
-	}
+	// children are owned by the archives arena
 }
 
 }
@@ -20,7 +20,7 @@ class ZipFolderImpl: public FolderBaseImpl
 {
 public:
 	ZipFolderImpl( const wchar_t *name, IFile *parent, ZipArchive *handler )
-		: FolderBaseImpl( name, handler->GetArchiveRoot()->GetPhysicalPath(), parent )
+		: FolderBaseImpl( handler->GetArena()->Intern( name, wcslen( name ) ), handler->GetArchiveRoot()->GetPhysicalPath(), parent, handler->GetArena() )
 		, _handler( handler ) {
 	}
 	virtual ~ZipFolderImpl();
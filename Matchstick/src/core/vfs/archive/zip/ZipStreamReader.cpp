@@ -0,0 +1,177 @@
+#include "StdAfx.h"
+
+#include <algorithm>
+#include "../../../common/MGDFResources.hpp"
+#include "../../../common/MGDFLoggerImpl.hpp"
+#include "../../MGDFFileReaderImpl.hpp"
+#include "ZipStreamReader.hpp"
+
+// std min&max are used instead of the macros
+#ifdef min
+#undef min
+#undef max
+#endif
+
+
+#if defined(_DEBUG)
+#define new new(_NORMAL_BLOCK,__FILE__, __LINE__)
+#pragma warning(disable:4291)
+#endif
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace zip
+{
+
+// the size of the buffer that data is inflated into and discarded when seeking forward
+#define SKIP_WINDOW_SIZE 65536
+
+ZipStreamReader::ZipStreamReader( IFileReaderOwner *owner, ZipArchive *archive, const ZipFileHeader &header )
+	: _owner( owner )
+	, _archive( archive )
+	, _header( header )
+	, _zip( nullptr )
+	, _isOpen( false )
+	, _position( 0 )
+{
+	_ASSERTE( owner );
+	_ASSERTE( archive );
+}
+
+ZipStreamReader::~ZipStreamReader()
+{
+	if ( _zip ) {
+		if ( _isOpen ) {
+			unzCloseCurrentFile( _zip );
+		}
+		_archive->ReleaseHandle( _zip );
+	}
+}
+
+MGDFError ZipStreamReader::Open()
+{
+	_zip = _archive->AcquireHandle();
+	if ( !_zip || !Restart() ) {
+		LOG( "Invalid archive file " << Resources::ToString( _header.name ), LOG_ERROR );
+		return MGDF_ERR_INVALID_ARCHIVE_FILE;
+	}
+	return MGDF_OK;
+}
+
+bool ZipStreamReader::Restart()
+{
+	if ( _isOpen ) {
+		unzCloseCurrentFile( _zip );
+		_isOpen = false;
+	}
+	_position = 0;
+	if ( unzGoToFilePos64( _zip, &_header.filePosition ) != UNZ_OK || unzOpenCurrentFile( _zip ) != UNZ_OK ) {
+		return false;
+	}
+	_isOpen = true;
+	return true;
+}
+
+void ZipStreamReader::Close()
+{
+	_owner->ReleaseReader();
+	delete this;
+}
+
+UINT64 ZipStreamReader::Read( void* buffer, UINT64 length )
+{
+	if ( !buffer || !_isOpen ) return 0;
+
+	UINT64 total = 0;
+	while ( total < length ) {
+		int read = unzReadCurrentFile( _zip, static_cast<char *>( buffer ) + total, static_cast<unsigned>( std::min<UINT64>( length - total, MAX_INFLATE_LENGTH ) ) );
+		if ( read <= 0 ) {
+			if ( read < 0 ) {
+				LOG( "Error inflating archive file " << Resources::ToString( _header.name ) << " - " << read, LOG_ERROR );
+			}
+			break;
+		}
+		total += static_cast<UINT64>( read );
+	}
+	_position += static_cast<INT64>( total );
+	return total;
+}
+
+UINT64 ZipStreamReader::ReadMany( ReadRange *ranges, UINT32 count )
+{
+	// the ranges are read in offset order, so the entry is inflated in a single pass (restarting at most once, if the
+	// first range is behind the current position)
+	std::vector<ReadRange *> sorted;
+	SortRanges( ranges, count, sorted );
+
+	UINT64 total = 0;
+	const ReadRange *furthest = nullptr; // the range read so far which reaches furthest into the entry
+	INT64 furthestStart = 0;
+	INT64 furthestEnd = 0;
+	for ( auto range : sorted ) {
+		range->read = 0;
+		if ( !range->buffer ) continue;
+
+		INT64 offset = std::max<INT64>( 0, range->offset );
+		const INT64 start = offset;
+		char *buffer = static_cast<char *>( range->buffer );
+		UINT64 length = range->length;
+
+		// the start of a range which overlaps an earlier range has already been inflated, so it is copied rather than inflated again
+		if ( furthest && offset < furthestEnd ) {
+			UINT64 overlap = std::min<UINT64>( length, static_cast<UINT64>( furthestEnd - offset ) );
+			memcpy( buffer, static_cast<const char *>( furthest->buffer ) + ( offset - furthestStart ), static_cast<size_t>( overlap ) );
+			offset += static_cast<INT64>( overlap );
+			buffer += overlap;
+			length -= overlap;
+			range->read = overlap;
+		}
+
+		if ( length && offset < _header.size ) {
+			SetPosition( offset );
+			if ( _position == offset ) {
+				range->read += Read( buffer, length );
+			}
+		}
+		total += range->read;
+
+		if ( start + static_cast<INT64>( range->read ) > furthestEnd ) {
+			furthest = range;
+			furthestStart = start;
+			furthestEnd = start + static_cast<INT64>( range->read );
+		}
+	}
+	return total;
+}
+
+void ZipStreamReader::SetPosition( INT64 pos )
+{
+	pos = std::max<INT64>( 0, std::min<INT64>( pos, _header.size ) );
+	if ( pos < _position && !Restart() ) {
+		LOG( "Unable to seek in archive file " << Resources::ToString( _header.name ), LOG_ERROR );
+		return;
+	}
+	Skip( pos - _position );
+}
+
+void ZipStreamReader::Skip( INT64 length )
+{
+	if ( length <= 0 ) return;
+	if ( _window.empty() ) {
+		_window.resize( SKIP_WINDOW_SIZE );
+	}
+	while ( length > 0 ) {
+		UINT64 read = Read( _window.data(), std::min<INT64>( length, SKIP_WINDOW_SIZE ) );
+		if ( !read ) break;
+		length -= read;
+	}
+}
+
+}
+}
+}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <unzip.h>
+
+#include "ZipArchive.hpp"
+#include "../../MGDFFileReaderImpl.hpp"
+
+namespace MGDF
+{
+namespace core
+{
+namespace vfs
+{
+namespace zip
+{
+
+/**
+reads a zip entry by inflating it incrementally as it is read, rather than inflating the whole entry up front.
+Each reader takes its own handle to the archive from the archives pool so readers are independent of each other. Seeking forward
+inflates and discards the data up to the new position using a small fixed size window, while seeking
+backward restarts the inflation from the beginning of the entry
+*/
+class ZipStreamReader : public IFileReader
+{
+public:
+	ZipStreamReader( IFileReaderOwner *owner, ZipArchive *archive, const ZipFileHeader &header );
+	virtual ~ZipStreamReader();
+
+	/**
+	acquire a handle to the archive and position it at the start of the entry
+	*/
+	MGDFError Open();
+
+	void Close() override final;
+	UINT64 Read( void* buffer, UINT64 length ) override final;
+	UINT64 ReadMany( ReadRange *ranges, UINT32 count ) override final;
+	void SetPosition( INT64 pos ) override final;
+	INT64 GetPosition() const override final {
+		return _position;
+	}
+	bool EndOfFile() const override final {
+		return _position >= _header.size;
+	}
+	INT64 GetSize() const override final {
+		return _header.size;
+	}
+private:
+	bool Restart();
+	void Skip( INT64 length );
+
+	IFileReaderOwner *_owner;
+	ZipArchive *_archive;
+	ZipFileHeader _header;
+	unzFile _zip;
+	bool _isOpen;
+	INT64 _position;
+	std::vector<char> _window;
+};
+
+}
+}
+}
+}
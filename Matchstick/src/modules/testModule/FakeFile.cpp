@@ -148,6 +148,30 @@ MGDF::MGDFError FakeFile::Open( IFileReader **reader )
 	return MGDF::MGDF_ERR_FILE_IN_USE;
 }
 
+MGDF::MGDFError FakeFile::OpenUnbuffered( IFileReader **reader )
+{
+	return Open( reader );
+}
+
+MGDF::MGDFError FakeFile::ReadAll( void *buffer, UINT64 *length )
+{
+	if ( !length ) {
+		return MGDF::MGDF_ERR_INVALID_PARAMETER;
+	}
+	if ( !_data ) {
+		return MGDF::MGDF_ERR_IS_FOLDER;
+	}
+	if ( buffer && *length < _dataLength ) {
+		*length = _dataLength;
+		return MGDF::MGDF_ERR_BUFFER_TOO_SMALL;
+	}
+	if ( buffer ) {
+		memcpy( buffer, _data, _dataLength );
+	}
+	*length = _dataLength;
+	return MGDF::MGDF_OK;
+}
+
 void FakeFile::Close()
 {
 	std::lock_guard<std::mutex> lock( _mutex );
@@ -156,12 +180,12 @@ void FakeFile::Close()
 	}
 }
 
-UINT32 FakeFile::Read( void* buffer, UINT32 length )
+UINT64 FakeFile::Read( void* buffer, UINT64 length )
 {
 	if ( _isOpen ) {
 		INT32 oldPosition = _position;
-		if ( ( static_cast<UINT32>( oldPosition ) + length ) > _dataLength ) length = static_cast<INT32>( _dataLength ) - oldPosition;
-		memcpy( buffer, & ( ( char * ) _data ) [oldPosition], length );
+		if ( ( static_cast<UINT64>( oldPosition ) + length ) > _dataLength ) length = static_cast<INT32>( _dataLength ) - oldPosition;
+		memcpy( buffer, & ( ( char * ) _data ) [oldPosition], static_cast<size_t>( length ) );
 		_position = oldPosition + static_cast<INT32>( length );
 		return _position;
 	}
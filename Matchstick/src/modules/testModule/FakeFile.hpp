@@ -31,10 +31,12 @@ public:
 	const wchar_t* GetLogicalPath() const override final;
 
 	MGDF::MGDFError Open( IFileReader **reader ) override final;
+	MGDF::MGDFError OpenUnbuffered( IFileReader **reader ) override final;
+	MGDF::MGDFError ReadAll( void *buffer, UINT64 *length ) override final;
 
 	bool IsOpen() const override final;
 	void Close() override final;
-	UINT32 Read( void* buffer, UINT32 length ) override final;
+	UINT64 Read( void* buffer, UINT64 length ) override final;
 	void SetPosition( INT64 pos ) override final;
 	INT64 GetPosition() const override final;
 	bool EndOfFile() const override final;
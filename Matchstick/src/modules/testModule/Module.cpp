@@ -114,6 +114,11 @@ bool Module::RTDeviceReset( IRenderHost* host )
 	return true;
 }
 
+bool Module::STContentChanged( ISimHost* host, const wchar_t * const *logicalPaths, UINT32 count )
+{
+	return true;
+}
+
 void Module::Panic()
 {
 }
@@ -36,6 +36,7 @@ public:
 	bool STDispose( ISimHost * simHost ) override final;
 	bool STUpdate( ISimHost * simHost, double elapsedTime ) override final;
 	void STShutDown( ISimHost * simHost ) override final;
+	bool STContentChanged( ISimHost * simHost, const wchar_t * const *logicalPaths, UINT32 count ) override final;
 
 	bool RTBeforeFirstDraw( MGDF::IRenderHost *renderHost ) override final;
 	bool RTDraw( IRenderHost *renderHost, double alpha ) override final;
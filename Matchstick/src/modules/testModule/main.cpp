@@ -20,7 +20,7 @@ BOOL APIENTRY DllMain( HMODULE hModule,
 // Function that returns if this module is compatible with the framework calling it
 bool MGDF::IsCompatibleInterfaceVersion( INT32 interfaceVersion )
 {
-	return interfaceVersion == 1; //compatible with v1 interface
+	return interfaceVersion == 2; //compatible with v2 interface
 }
 
 //create module instances as they are requested by the framework
@@ -40,6 +40,12 @@ bool Module::STDispose(MGDF::ISimHost *host)
 	delete this;
 	return true;
 }
+bool Module::STContentChanged(MGDF::ISimHost *host, const wchar_t * const *logicalPaths, UINT32 count)
+{
+	// Called by the host when files in the vfs have changed, so that the
+	// module can reload any content which it has already loaded
+	return true;
+}
 bool Module::RTBeforeFirstDraw(MGDF::IRenderHost *host)
 {
 	// Called by the host before any rendering occurs on the render thread
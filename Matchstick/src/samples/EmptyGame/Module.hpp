@@ -17,6 +17,7 @@ public:
 	bool STUpdate( MGDF::ISimHost *host, double elapsedTime ) override final;
 	void STShutDown( MGDF::ISimHost *host ) override final;
 	bool STDispose( MGDF::ISimHost *host ) override final;
+	bool STContentChanged( MGDF::ISimHost *host, const wchar_t * const *logicalPaths, UINT32 count ) override final;
 
 	bool RTBeforeFirstDraw( MGDF::IRenderHost *host ) override final;
 	bool RTDraw( MGDF::IRenderHost *host, double alpha ) override final;
@@ -18,7 +18,7 @@ BOOL APIENTRY DllMain( HMODULE hModule,
 // Function that returns if this module is compatible with the framework calling it
 bool MGDF::IsCompatibleInterfaceVersion( INT32 interfaceVersion )
 {
-	return interfaceVersion == 1; //compatible with v1 interface
+	return interfaceVersion == 2; //compatible with v2 interface
 }
 
 //specify to the framework what kind of d3d device features we want/require
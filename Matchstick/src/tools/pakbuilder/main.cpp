@@ -0,0 +1,97 @@
+#include "stdafx.h"
+
+#include <stdio.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "../../core/vfs/archive/pak/PakWriter.hpp"
+#include "../../core/vfs/archive/pak/PakLayout.hpp"
+
+using namespace MGDF::core::vfs::pak;
+using namespace std::filesystem;
+
+#define DEFAULT_PHASE_GAP 1000
+
+void PrintUsage()
+{
+	printf( "Builds a .mgdfpak archive from the contents of a folder\n" );
+	printf( "usage: pakbuilder <content folder> <output file> [--store] [--block-size <bytes>] [--trace <file>]... [--phase-gap <ms>]\n" );
+	printf( "  --store       store every entry without compression\n" );
+	printf( "  --block-size  the size of the blocks which compressed entries are split into (default %d)\n", PAK_BLOCK_SIZE );
+	printf( "  --trace       a vfs access trace (recorded with host.vfsTrace), entries are laid out in the order they\n" );
+	printf( "                were first accessed in the traces. Can be given more than once\n" );
+	printf( "  --phase-gap   the milliseconds without any accesses which separate two load phases in a trace (default %d)\n", DEFAULT_PHASE_GAP );
+}
+
+int wmain( int argc, wchar_t **argv )
+{
+	if ( argc < 3 ) {
+		PrintUsage();
+		return 1;
+	}
+
+	path content( argv[1] );
+	path output( argv[2] );
+	PakWriter writer;
+	std::vector<std::wstring> traces;
+	UINT64 phaseGap = DEFAULT_PHASE_GAP;
+
+	for ( int i = 3; i < argc; ++i ) {
+		std::wstring option( argv[i] );
+		if ( option == L"--store" ) {
+			writer.SetCompression( false );
+		} else if ( option == L"--block-size" && i + 1 < argc ) {
+			UINT32 blockSize = wcstoul( argv[++i], nullptr, 10 );
+			if ( !blockSize ) {
+				printf( "Invalid block size '%ls'\n", argv[i] );
+				return 1;
+			}
+			writer.SetBlockSize( blockSize );
+		} else if ( option == L"--trace" && i + 1 < argc ) {
+			traces.push_back( argv[++i] );
+		} else if ( option == L"--phase-gap" && i + 1 < argc ) {
+			phaseGap = wcstoul( argv[++i], nullptr, 10 );
+		} else {
+			printf( "Invalid option '%ls'\n", option.c_str() );
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if ( !is_directory( content ) ) {
+		printf( "Content folder '%ls' does not exist\n", content.c_str() );
+		return 1;
+	}
+
+	std::error_code error;
+	std::vector<std::wstring> entries;
+	for ( recursive_directory_iterator itr( content ), end; itr != end; ++itr ) {
+		if ( !itr->is_regular_file() || equivalent( itr->path(), output, error ) ) continue;
+		// paths in the pack are relative to the content folder and always use '/' as the separator
+		entries.push_back( relative( itr->path(), content ).generic_wstring() );
+		writer.AddFile( entries.back(), itr->path().wstring() );
+	}
+
+	if ( !traces.empty() ) {
+		PakLayout layout( phaseGap * 1000 );
+		for ( auto &trace : traces ) {
+			if ( !layout.AddTrace( trace ) ) {
+				printf( "Unable to load trace '%ls'\n", trace.c_str() );
+				return 1;
+			}
+		}
+		std::vector<std::wstring> order;
+		layout.GetOrder( entries, order );
+		writer.SetLayout( order );
+		printf( "Laying out %zu traced entries in access order (%zu load phases)\n", order.size(), layout.GetPhaseCount() );
+	}
+
+	if ( !writer.Save( output.wstring() ) ) {
+		printf( "Unable to build pack - %s\n", writer.GetError().c_str() );
+		return 1;
+	}
+
+	printf( "Packed %zu entries into %ls (%zu compressed, %zu duplicates)\n", writer.GetEntryCount(), output.c_str(), writer.GetCompressedCount(), writer.GetDuplicateCount() );
+	return 0;
+}
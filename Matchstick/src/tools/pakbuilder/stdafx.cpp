@@ -0,0 +1 @@
+#include "StdAfx.h"
\ No newline at end of file
@@ -0,0 +1,715 @@
+#include "stdafx.h"
+
+#include <chrono>
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
+#include <map>
+#include <thread>
+#include <psapi.h>
+
+#include "MGDFMockErrorHandler.hpp"
+#include "VFSTestArchive.hpp"
+#include "../../src/core/common/MGDFResources.hpp"
+#include "../../src/core/vfs/MGDFVirtualFileSystemComponentImpl.hpp"
+#include "../../src/core/vfs/MGDFArena.hpp"
+#include "../../src/core/vfs/archive/zip/ZipArchiveHandlerImpl.hpp"
+#include "../../src/core/vfs/archive/pak/PakArchiveHandlerImpl.hpp"
+#include "../../src/core/vfs/archive/pak/PakLayout.hpp"
+#include "../../src/core/vfs/archive/pak/PakWriter.hpp"
+#include "../../src/core/vfs/MGDFAccessTrace.hpp"
+#include "../../src/core/vfs/MGDFPathFilter.hpp"
+
+using namespace MGDF;
+using namespace MGDF::core;
+using namespace MGDF::core::vfs;
+
+/**
+these benchmarks are excluded from the default test run, use +VFSBenchmarks to run them
+*/
+SUITE( VFSBenchmarks )
+{
+	const UINT32 ARCHIVE_COUNT = 2;
+	const UINT32 FOLDER_COUNT = 50;
+	const UINT32 SUBFOLDER_COUNT = 10;
+	const UINT32 FILE_COUNT = 100;
+	const UINT32 WIDE_FOLDER_COUNT = 4;
+	const UINT32 WIDE_FILE_COUNT = 5000;
+	const UINT32 COMPRESSED_ENTRY_COUNT = 256;
+	const UINT32 COMPRESSED_ENTRY_SIZE = 256 * 1024;
+	const UINT32 REPLAY_ENTRY_COUNT = 4096;
+	const UINT32 REPLAY_ENTRY_SIZE = 64 * 1024;
+	const UINT32 REPLAY_LOAD_COUNT = 1024;
+
+	template <typename T>
+	double TimeMilliseconds( T func )
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		func();
+		auto end = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double, std::milli>( end - start ).count();
+	}
+
+	void Report( const char *benchmark, const char *measurement, double value, const char *units )
+	{
+		printf( "[VFSBenchmarks] %s - %s: %.3f %s\n", benchmark, measurement, value, units );
+	}
+
+	size_t GetPrivateBytes()
+	{
+		PROCESS_MEMORY_COUNTERS_EX counters;
+		if ( !GetProcessMemoryInfo( GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS *>( &counters ), sizeof( counters ) ) ) {
+			return 0;
+		}
+		return counters.PrivateUsage;
+	}
+
+	struct VFSBenchmarkFixture {
+		VFSBenchmarkFixture() {
+			HINSTANCE inst;
+			inst = ( HINSTANCE ) GetModuleHandleW( L"core.tests.exe" );
+			Resources::Instance( inst );
+			Resources::Instance().SetUserBaseDir( true, "junkship" );
+
+			_errorHandler = new MGDF::core::tests::MockErrorHandler();
+		}
+
+		virtual ~VFSBenchmarkFixture() {
+			delete _errorHandler;
+		}
+
+		IVirtualFileSystemComponent *CreateVFS() {
+			IVirtualFileSystemComponent *vfs = CreateVirtualFileSystemComponentImpl();
+			vfs->RegisterArchiveHandler( zip::CreateZipArchiveHandlerImpl( ( IErrorHandler * ) _errorHandler ) );
+			vfs->RegisterArchiveHandler( pak::CreatePakArchiveHandlerImpl( ( IErrorHandler * ) _errorHandler ) );
+			return vfs;
+		}
+
+		/**
+		generates (if not already present) a content folder containing 100k files spread across
+		two archives and fills paths with the logical path of every file
+		*/
+		std::wstring GetLargeContent( std::vector<std::wstring> &paths ) {
+			std::filesystem::path root = std::filesystem::temp_directory_path() / L"mgdf.vfsbenchmarks" / L"large";
+			std::filesystem::create_directories( root );
+
+			for ( UINT32 a = 0; a < ARCHIVE_COUNT; ++a ) {
+				std::wostringstream archiveName;
+				archiveName << L"archive" << a << L".zip";
+				std::filesystem::path archivePath = root / archiveName.str();
+				bool exists = std::filesystem::exists( archivePath );
+
+				tests::TestArchiveWriter writer;
+				for ( UINT32 f = 0; f < FOLDER_COUNT; ++f ) {
+					for ( UINT32 s = 0; s < SUBFOLDER_COUNT; ++s ) {
+						for ( UINT32 i = 0; i < FILE_COUNT; ++i ) {
+							std::ostringstream name;
+							name << "folder" << std::setw( 2 ) << std::setfill( '0' ) << f
+							     << "/sub" << std::setw( 2 ) << std::setfill( '0' ) << s
+							     << "/file" << std::setw( 3 ) << std::setfill( '0' ) << i << ".dat";
+							paths.push_back( archiveName.str() + L"/" + Resources::ToWString( name.str() ) );
+							if ( !exists ) writer.AddFile( name.str(), "x" );
+						}
+					}
+				}
+				if ( !exists ) {
+					writer.Save( archivePath.wstring() );
+				}
+			}
+			return root.wstring();
+		}
+
+		/**
+		generates (if not already present) an archive containing a few folders with thousands of files each
+		*/
+		std::wstring GetWideContent() {
+			std::filesystem::path root = std::filesystem::temp_directory_path() / L"mgdf.vfsbenchmarks";
+			std::filesystem::create_directories( root );
+			std::filesystem::path archivePath = root / L"wide.zip";
+
+			if ( !std::filesystem::exists( archivePath ) ) {
+				tests::TestArchiveWriter writer;
+				for ( UINT32 f = 0; f < WIDE_FOLDER_COUNT; ++f ) {
+					for ( UINT32 i = 0; i < WIDE_FILE_COUNT; ++i ) {
+						std::ostringstream name;
+						name << "folder" << f << "/file" << std::setw( 4 ) << std::setfill( '0' ) << i << ".dat";
+						writer.AddFile( name.str(), "x" );
+					}
+				}
+				writer.Save( archivePath.wstring() );
+			}
+			return archivePath.wstring();
+		}
+
+		/**
+		generates (if not already present) an archive of deflated entries made up of pseudo random words,
+		so that inflating them takes a realistic amount of work
+		*/
+		std::wstring GetCompressedContent() {
+			static const char *words[] = { "the", "mesh", "texture", "sound", "level", "entity", "shader", "script", "asset", "stream", "frame", "buffer" };
+			std::filesystem::path root = std::filesystem::temp_directory_path() / L"mgdf.vfsbenchmarks";
+			std::filesystem::create_directories( root );
+			std::filesystem::path archivePath = root / L"compressed.zip";
+
+			if ( !std::filesystem::exists( archivePath ) ) {
+				tests::TestArchiveWriter writer;
+				UINT32 seed = 1;
+				std::string data;
+				for ( UINT32 e = 0; e < COMPRESSED_ENTRY_COUNT; ++e ) {
+					data.clear();
+					while ( data.size() < COMPRESSED_ENTRY_SIZE ) {
+						seed = seed * 1103515245 + 12345;
+						data += words[( seed >> 16 ) % ( sizeof( words ) / sizeof( words[0] ) )];
+						data += ' ';
+					}
+					data.resize( COMPRESSED_ENTRY_SIZE );
+					std::ostringstream name;
+					name << "entry" << std::setw( 4 ) << std::setfill( '0' ) << e << ".txt";
+					writer.AddFile( name.str(), data, true );
+				}
+				writer.Save( archivePath.wstring() );
+			}
+			return archivePath.wstring();
+		}
+	protected:
+		MGDF::core::tests::MockErrorHandler *_errorHandler;
+	};
+
+	/**
+	compare looking up every file in a 100k entry tree by walking the tree against using the path index
+	*/
+	TEST_FIXTURE( VFSBenchmarkFixture, PathIndexLookup ) {
+		std::vector<std::wstring> paths;
+		std::wstring content = GetLargeContent( paths );
+		const UINT32 passes = 5;
+
+		for ( UINT32 indexed = 0; indexed < 2; ++indexed ) {
+			IVirtualFileSystemComponent *vfs = CreateVFS();
+			vfs->EnablePathIndex( indexed != 0 );
+			vfs->Mount( content.c_str() );
+
+			//the first pass ensures that the whole tree is mapped
+			UINT32 found = 0;
+			for ( auto &path : paths ) {
+				if ( vfs->GetFile( path.c_str() ) ) ++found;
+			}
+			CHECK_EQUAL( paths.size(), found );
+
+			double elapsed = TimeMilliseconds( [&]() {
+				for ( UINT32 pass = 0; pass < passes; ++pass ) {
+					for ( auto &path : paths ) {
+						vfs->GetFile( path.c_str() );
+					}
+				}
+			} );
+			Report( "PathIndexLookup", indexed ? "path index" : "tree walk", ( elapsed * 1000000.0 ) / static_cast<double>( paths.size() * passes ), "ns/lookup" );
+			delete vfs;
+		}
+	}
+
+	/**
+	measure the throughput of walking the tree to look up every file in a 100k entry tree from 16 threads at
+	once, against looking them up from a single thread. Once a folder is mapped its children are read without
+	taking any locks, so the throughput should scale with the number of threads
+	*/
+	TEST_FIXTURE( VFSBenchmarkFixture, ContendedLookup ) {
+		std::vector<std::wstring> paths;
+		std::wstring content = GetLargeContent( paths );
+		const UINT32 threadCounts[] = { 1, 16 };
+
+		IVirtualFileSystemComponent *vfs = CreateVFS();
+		vfs->EnablePathIndex( false );
+		vfs->Mount( content.c_str() );
+
+		//the first pass ensures that the whole tree is mapped
+		UINT32 found = 0;
+		for ( auto &path : paths ) {
+			if ( vfs->GetFile( path.c_str() ) ) ++found;
+		}
+		CHECK_EQUAL( paths.size(), found );
+
+		for ( UINT32 threads : threadCounts ) {
+			std::atomic<size_t> lookups( 0 );
+
+			double elapsed = TimeMilliseconds( [&]() {
+				std::vector<std::thread> readers;
+				for ( UINT32 t = 0; t < threads; ++t ) {
+					readers.push_back( std::thread( [&, t]() {
+						//each thread starts at a different point so they aren't all walking the same folders in lockstep
+						size_t hits = 0;
+						const size_t start = ( paths.size() / threads ) * t;
+						for ( size_t i = 0; i < paths.size(); ++i ) {
+							if ( vfs->GetFile( paths[( start + i ) % paths.size()].c_str() ) ) ++hits;
+						}
+						lookups += hits;
+					} ) );
+				}
+				for ( auto &reader : readers ) {
+					reader.join();
+				}
+			} );
+
+			std::ostringstream measurement;
+			measurement << threads << ( threads == 1 ? " thread" : " threads" );
+			CHECK_EQUAL( paths.size() * threads, lookups );
+			Report( "ContendedLookup", measurement.str().c_str(), static_cast<double>( lookups ) / ( elapsed * 1000.0 ), "million lookups/s" );
+		}
+		delete vfs;
+	}
+
+	/**
+	measure the time and memory taken to mount and fully map a 100k entry tree, and the time taken to tear it down again
+	*/
+	TEST_FIXTURE( VFSBenchmarkFixture, MountLargeContent ) {
+		std::vector<std::wstring> paths;
+		std::wstring content = GetLargeContent( paths );
+
+		size_t before = GetPrivateBytes();
+		IVirtualFileSystemComponent *vfs = CreateVFS();
+		double elapsed = TimeMilliseconds( [&]() {
+			vfs->Mount( content.c_str() );
+			for ( UINT32 a = 0; a < ARCHIVE_COUNT; ++a ) {
+				std::wostringstream archiveName;
+				archiveName << L"archive" << a << L".zip";
+				CHECK( vfs->GetFile( archiveName.str().c_str() ) != nullptr );
+			}
+		} );
+		size_t after = GetPrivateBytes();
+		Report( "MountLargeContent", "mount", elapsed, "ms" );
+		Report( "MountLargeContent", "memory", after > before ? static_cast<double>( after - before ) / static_cast<double>( paths.size() ) : 0.0, "bytes/file" );
+
+		elapsed = TimeMilliseconds( [&]() {
+			delete vfs;
+		} );
+		Report( "MountLargeContent", "teardown", elapsed, "ms" );
+	}
+
+	/**
+	compare storing the nodes of a 100k entry tree as individually allocated objects holding thier own copies of each name and
+	path (as nodes were stored before the arena) against storing them in an arena with interned names, from one thread and from
+	several threads at once
+	*/
+	TEST_FIXTURE( VFSBenchmarkFixture, ArenaNodeAllocation ) {
+		std::vector<std::wstring> paths;
+		std::wstring content = GetLargeContent( paths );
+		const UINT32 threadCount = 4;
+
+		struct HeapNode {
+			std::wstring name;
+			std::wstring path;
+			HeapNode *parent;
+			void *children;
+			std::mutex mutex;
+		};
+		struct ArenaNode {
+			const wchar_t *name;
+			const wchar_t *path;
+			ArenaNode *parent;
+			void *children;
+			std::mutex mutex;
+		};
+
+		auto getName = []( const std::wstring & path ) {
+			return path.substr( path.find_last_of( L'/' ) + 1 );
+		};
+
+		std::vector<HeapNode *> heapNodes( paths.size() );
+		size_t before = GetPrivateBytes();
+		double elapsed = TimeMilliseconds( [&]() {
+			for ( size_t i = 0; i < paths.size(); ++i ) {
+				HeapNode *node = new HeapNode();
+				node->name = getName( paths[i] );
+				node->path = content + L"\\" + paths[i];
+				heapNodes[i] = node;
+			}
+		} );
+		size_t after = GetPrivateBytes();
+		const double heapBytes = after > before ? static_cast<double>( after - before ) / static_cast<double>( paths.size() ) : 0.0;
+		Report( "ArenaNodeAllocation", "heap allocate", elapsed, "ms" );
+		Report( "ArenaNodeAllocation", "heap memory", heapBytes, "bytes/file" );
+		elapsed = TimeMilliseconds( [&]() {
+			for ( auto node : heapNodes ) {
+				delete node;
+			}
+		} );
+		Report( "ArenaNodeAllocation", "heap teardown", elapsed, "ms" );
+
+		for ( UINT32 threads = 1; threads <= threadCount; threads += threadCount - 1 ) {
+			Arena *arena = new Arena();
+			before = GetPrivateBytes();
+			elapsed = TimeMilliseconds( [&]() {
+				std::vector<std::thread> workers;
+				for ( UINT32 t = 0; t < threads; ++t ) {
+					workers.push_back( std::thread( [&, t]() {
+						for ( size_t i = t; i < paths.size(); i += threads ) {
+							ArenaNode *node = arena->New<ArenaNode>();
+							node->name = arena->Intern( getName( paths[i] ) );
+							node->path = arena->Copy( content + L"\\" + paths[i] );
+						}
+					} ) );
+				}
+				for ( auto &worker : workers ) {
+					worker.join();
+				}
+			} );
+			after = GetPrivateBytes();
+			const double arenaBytes = after > before ? static_cast<double>( after - before ) / static_cast<double>( paths.size() ) : 0.0;
+			Report( "ArenaNodeAllocation", threads > 1 ? "arena allocate (4 threads)" : "arena allocate", elapsed, "ms" );
+			if ( threads == 1 ) {
+				Report( "ArenaNodeAllocation", "arena memory", arenaBytes, "bytes/file" );
+				Report( "ArenaNodeAllocation", "memory saved", heapBytes - arenaBytes, "bytes/file" );
+				Report( "ArenaNodeAllocation", "interned bytes saved", static_cast<double>( arena->GetInternedBytesSaved() ) / static_cast<double>( paths.size() ), "bytes/file" );
+			}
+			elapsed = TimeMilliseconds( [&]() {
+				delete arena;
+			} );
+			Report( "ArenaNodeAllocation", threads > 1 ? "arena teardown (4 threads)" : "arena teardown", elapsed, "ms" );
+		}
+	}
+
+
+	/**
+	compare mapping the whole of a large tree on demand from a single thread against mapping it in the background
+	*/
+	TEST_FIXTURE( VFSBenchmarkFixture, EagerMapping ) {
+		std::vector<std::wstring> paths;
+		std::wstring content = GetLargeContent( paths );
+
+		for ( UINT32 eager = 0; eager < 2; ++eager ) {
+			IVirtualFileSystemComponent *vfs = CreateVFS();
+			vfs->EnableEagerMapping( eager != 0 );
+
+			double elapsed = TimeMilliseconds( [&]() {
+				vfs->Mount( content.c_str() );
+				if ( eager ) {
+					vfs->WaitForMapping();
+				} else {
+					for ( UINT32 a = 0; a < ARCHIVE_COUNT; ++a ) {
+						std::wostringstream archiveName;
+						archiveName << L"archive" << a << L".zip";
+						vfs->GetFile( archiveName.str().c_str() );
+					}
+				}
+			} );
+			Report( "EagerMapping", eager ? "background" : "on demand", elapsed, "ms" );
+
+			UINT32 found = 0;
+			for ( auto &path : paths ) {
+				if ( vfs->GetFile( path.c_str() ) ) ++found;
+			}
+			CHECK_EQUAL( paths.size(), found );
+			delete vfs;
+		}
+	}
+
+	/**
+	compare fully mapping a large tree by scanning it against mapping it from a saved manifest
+	*/
+	TEST_FIXTURE( VFSBenchmarkFixture, ManifestMapping ) {
+		std::vector<std::wstring> paths;
+		std::wstring content = GetLargeContent( paths );
+		std::wstring manifest = ( std::filesystem::temp_directory_path() / L"mgdf.vfsbenchmarks" / L"manifest.bin" ).wstring();
+		std::filesystem::remove( manifest );
+
+		for ( UINT32 run = 0; run < 2; ++run ) {
+			IVirtualFileSystemComponent *vfs = CreateVFS();
+			vfs->EnableManifest( manifest.c_str() );
+
+			double elapsed = TimeMilliseconds( [&]() {
+				vfs->Mount( content.c_str() );
+				for ( UINT32 a = 0; a < ARCHIVE_COUNT; ++a ) {
+					std::wostringstream archiveName;
+					archiveName << L"archive" << a << L".zip";
+					vfs->GetFile( archiveName.str().c_str() );
+				}
+			} );
+			Report( "ManifestMapping", run ? "from manifest" : "scan", elapsed, "ms" );
+
+			UINT32 found = 0;
+			for ( auto &path : paths ) {
+				if ( vfs->GetFile( path.c_str() ) ) ++found;
+			}
+			CHECK_EQUAL( paths.size(), found );
+			delete vfs;
+		}
+	}
+
+	class ExtensionFilter: public MGDF::IFileFilter
+	{
+	public:
+		virtual ~ExtensionFilter() {}
+		virtual bool Accept( const wchar_t *file ) const {
+			size_t length = wcslen( file );
+			return length > 4 && wcscmp( file + length - 4, L".dat" ) == 0;
+		}
+	};
+
+	/**
+	measure child lookups and enumeration in folders with thousands of entries
+	*/
+	TEST_FIXTURE( VFSBenchmarkFixture, WideFolderLookup ) {
+		std::wstring content = GetWideContent();
+		const UINT32 passes = 20;
+
+		IVirtualFileSystemComponent *vfs = CreateVFS();
+		vfs->Mount( content.c_str() );
+
+		std::vector<std::wstring> names;
+		for ( UINT32 i = 0; i < WIDE_FILE_COUNT; ++i ) {
+			std::wostringstream name;
+			name << L"file" << std::setw( 4 ) << std::setfill( L'0' ) << i << L".dat";
+			names.push_back( name.str() );
+		}
+
+		std::vector<IFile *> folders;
+		for ( UINT32 f = 0; f < WIDE_FOLDER_COUNT; ++f ) {
+			std::wostringstream name;
+			name << L"folder" << f;
+			IFile *folder = vfs->GetRoot()->GetChild( name.str().c_str() );
+			CHECK( folder != nullptr );
+			if ( !folder ) {
+				delete vfs;
+				return;
+			}
+			CHECK_EQUAL( WIDE_FILE_COUNT, folder->GetChildCount() );
+			folders.push_back( folder );
+		}
+
+		UINT32 found = 0;
+		double elapsed = TimeMilliseconds( [&]() {
+			for ( UINT32 pass = 0; pass < passes; ++pass ) {
+				for ( auto folder : folders ) {
+					for ( auto &name : names ) {
+						if ( folder->GetChild( name.c_str() ) ) ++found;
+					}
+				}
+			}
+		} );
+		CHECK_EQUAL( passes * WIDE_FOLDER_COUNT * WIDE_FILE_COUNT, found );
+		Report( "WideFolderLookup", "GetChild", ( elapsed * 1000000.0 ) / static_cast<double>( passes * WIDE_FOLDER_COUNT * WIDE_FILE_COUNT ), "ns/lookup" );
+
+		// the same lookups against a std::map keyed by name, as folders used to hold thier children
+		struct NameLess {
+			bool operator()( const wchar_t *a, const wchar_t *b ) const {
+				return std::wcscmp( a, b ) < 0;
+			}
+		};
+		std::vector<std::map<const wchar_t *, IFile *, NameLess>> maps( folders.size() );
+		for ( size_t f = 0; f < folders.size(); ++f ) {
+			size_t length = WIDE_FILE_COUNT;
+			std::vector<IFile *> children( length );
+			folders[f]->GetAllChildren( nullptr, children.data(), &length );
+			for ( size_t i = 0; i < length; ++i ) {
+				maps[f].insert( std::make_pair( children[i]->GetName(), children[i] ) );
+			}
+		}
+		found = 0;
+		elapsed = TimeMilliseconds( [&]() {
+			for ( UINT32 pass = 0; pass < passes; ++pass ) {
+				for ( auto &map : maps ) {
+					for ( auto &name : names ) {
+						if ( map.find( name.c_str() ) != map.end() ) ++found;
+					}
+				}
+			}
+		} );
+		CHECK_EQUAL( passes * WIDE_FOLDER_COUNT * WIDE_FILE_COUNT, found );
+		Report( "WideFolderLookup", "std::map (baseline)", ( elapsed * 1000000.0 ) / static_cast<double>( passes * WIDE_FOLDER_COUNT * WIDE_FILE_COUNT ), "ns/lookup" );
+
+		std::vector<IFile *> buffer( WIDE_FILE_COUNT );
+		ExtensionFilter filter;
+		for ( UINT32 filtered = 0; filtered < 2; ++filtered ) {
+			elapsed = TimeMilliseconds( [&]() {
+				for ( UINT32 pass = 0; pass < passes; ++pass ) {
+					for ( auto folder : folders ) {
+						size_t length = buffer.size();
+						folder->GetAllChildren( filtered ? &filter : nullptr, buffer.data(), &length );
+					}
+				}
+			} );
+			Report( "WideFolderLookup", filtered ? "GetAllChildren (filtered)" : "GetAllChildren", ( elapsed * 1000000.0 ) / static_cast<double>( passes * WIDE_FOLDER_COUNT * WIDE_FILE_COUNT ), "ns/child" );
+		}
+
+		delete vfs;
+	}
+
+	/**
+	measure the throughput of inflating every entry of one archive as the number of threads reading from it increases
+	*/
+	TEST_FIXTURE( VFSBenchmarkFixture, ParallelZipExtraction ) {
+		std::wstring archive = GetCompressedContent();
+		IVirtualFileSystemComponent *vfs = CreateVFS();
+		vfs->Mount( archive.c_str() );
+
+		size_t length = vfs->GetRoot()->GetChildCount();
+		std::vector<IFile *> files( length );
+		vfs->GetRoot()->GetAllChildren( nullptr, files.data(), &length );
+		CHECK_EQUAL( COMPRESSED_ENTRY_COUNT, length );
+
+		UINT32 maxThreads = std::thread::hardware_concurrency();
+		if ( !maxThreads ) maxThreads = 1;
+		for ( UINT32 threads = 1; threads <= maxThreads; threads *= 2 ) {
+			std::atomic<size_t> next( 0 );
+			std::atomic<UINT64> bytes( 0 );
+
+			double elapsed = TimeMilliseconds( [&]() {
+				std::vector<std::thread> workers;
+				for ( UINT32 t = 0; t < threads; ++t ) {
+					workers.push_back( std::thread( [&]() {
+						std::vector<char> buffer;
+						for ( size_t i = next++; i < length; i = next++ ) {
+							IFileReader *reader = nullptr;
+							if ( files[i]->Open( &reader ) != MGDF_OK ) continue;
+							buffer.resize( static_cast<size_t>( reader->GetSize() ) );
+							bytes += reader->Read( buffer.data(), static_cast<UINT32>( buffer.size() ) );
+							reader->Close();
+						}
+					} ) );
+				}
+				for ( auto &worker : workers ) {
+					worker.join();
+				}
+			} );
+
+			std::ostringstream measurement;
+			measurement << threads << ( threads == 1 ? " thread" : " threads" );
+			Report( "ParallelZipExtraction", measurement.str().c_str(), ( static_cast<double>( bytes ) / ( 1024.0 * 1024.0 ) ) / ( elapsed / 1000.0 ), "MB/s" );
+			CHECK_EQUAL( static_cast<UINT64>( COMPRESSED_ENTRY_COUNT ) * COMPRESSED_ENTRY_SIZE, bytes );
+		}
+		delete vfs;
+	}
+
+	/**
+	record a trace of a simulated level load which reads entries scattered throughout a pack, then compare replaying
+	the trace against the pack laid out in path order and against a pack laid out from the trace. The packs are stored
+	rather than compressed so every read comes straight from the mapping of the pack. Both packs will usually be in
+	the os file cache, flush it before running the benchmark to measure cold loads where the layout matters most
+	*/
+	TEST_FIXTURE( VFSBenchmarkFixture, TraceReplay ) {
+		std::filesystem::path root = std::filesystem::temp_directory_path() / L"mgdf.vfsbenchmarks" / L"replay";
+		std::filesystem::path pathOrdered = root / L"path";
+		std::filesystem::path traceOrdered = root / L"trace";
+		std::filesystem::create_directories( pathOrdered );
+		std::filesystem::create_directories( traceOrdered );
+		std::wstring trace = ( root / L"level.trace" ).wstring();
+
+		std::vector<std::wstring> entries;
+		pak::PakWriter writer;
+		writer.SetCompression( false );
+		UINT32 seed = 1;
+		std::string data( REPLAY_ENTRY_SIZE, '\0' );
+		for ( UINT32 e = 0; e < REPLAY_ENTRY_COUNT; ++e ) {
+			for ( auto &c : data ) {
+				seed = seed * 1103515245 + 12345;
+				c = static_cast<char>( seed >> 16 );
+			}
+			std::wostringstream name;
+			name << L"entry" << std::setw( 4 ) << std::setfill( L'0' ) << e << L".dat";
+			entries.push_back( name.str() );
+			writer.AddData( name.str(), data );
+		}
+		CHECK( writer.Save( ( pathOrdered / L"level.mgdfpak" ).wstring() ) );
+
+		//the level load reads a pseudo random selection of entries, so in path order they are spread across the whole pack
+		IVirtualFileSystemComponent *vfs = CreateVFS();
+		vfs->EnableTrace( trace.c_str() );
+		vfs->Mount( pathOrdered.c_str() );
+		std::vector<char> buffer( REPLAY_ENTRY_SIZE );
+		for ( UINT32 i = 0; i < REPLAY_LOAD_COUNT; ++i ) {
+			seed = seed * 1103515245 + 12345;
+			std::wstring path = L"level.mgdfpak/" + entries[( seed >> 8 ) % REPLAY_ENTRY_COUNT];
+			IFileReader *reader = nullptr;
+			if ( vfs->GetFile( path.c_str() )->Open( &reader ) == MGDF_OK ) {
+				reader->Read( buffer.data(), buffer.size() );
+				reader->Close();
+			}
+		}
+		delete vfs;
+
+		pak::PakLayout layout( 1000000 );
+		CHECK( layout.AddTrace( trace ) );
+		std::vector<std::wstring> order;
+		layout.GetOrder( entries, order );
+		writer.SetLayout( order );
+		CHECK( writer.Save( ( traceOrdered / L"level.mgdfpak" ).wstring() ) );
+
+		std::vector<std::wstring> paths;
+		std::vector<TraceEvent> events;
+		CHECK( AccessTrace::Load( trace, paths, events ) );
+
+		for ( UINT32 traced = 0; traced < 2; ++traced ) {
+			vfs = CreateVFS();
+			vfs->Mount( ( traced ? traceOrdered : pathOrdered ).c_str() );
+			UINT64 bytes = 0;
+			double elapsed = TimeMilliseconds( [&]() {
+				for ( auto &event : events ) {
+					if ( event.type != TraceEvent::READ ) continue;
+					IFileReader *reader = nullptr;
+					if ( vfs->GetFile( paths[event.path].c_str() )->Open( &reader ) == MGDF_OK ) {
+						reader->SetPosition( static_cast<INT64>( event.offset ) );
+						bytes += reader->Read( buffer.data(), std::min<UINT64>( event.length, buffer.size() ) );
+						reader->Close();
+					}
+				}
+			} );
+			CHECK_EQUAL( static_cast<UINT64>( REPLAY_LOAD_COUNT ) * REPLAY_ENTRY_SIZE, bytes );
+			Report( "TraceReplay", traced ? "trace order" : "path order", elapsed, "ms" );
+			delete vfs;
+		}
+		std::filesystem::remove_all( root );
+	}
+
+	/**
+	measure looking up paths which don't exist (as localization and mod fallbacks do) with and without the path filter, and
+	the false positive rate of the filter
+	*/
+	TEST_FIXTURE( VFSBenchmarkFixture, PathFilterLookup ) {
+		std::vector<std::wstring> paths;
+		std::wstring content = GetLargeContent( paths );
+
+		// half of the missing paths are in folders which exist, half are in folders which don't
+		std::vector<std::wstring> missing;
+		for ( size_t i = 0; i < paths.size(); i += 10 ) {
+			std::wstring path = paths[i];
+			missing.push_back( path.substr( 0, path.size() - 4 ) + L".fr.dat" );
+			missing.push_back( L"localized/fr/" + path );
+		}
+
+		for ( UINT32 mode = 0; mode < 3; ++mode ) {
+			const char *name = mode == 0 ? "on demand" : ( mode == 1 ? "mapped" : "filtered" );
+			IVirtualFileSystemComponent *vfs = CreateVFS();
+			vfs->EnableEagerMapping( mode == 1 );
+			vfs->EnablePathFilter( mode == 2 );
+			vfs->Mount( content.c_str() );
+			vfs->WaitForMapping();
+
+			UINT32 found = 0;
+			double elapsed = TimeMilliseconds( [&]() {
+				for ( auto &path : missing ) {
+					if ( vfs->GetFile( path.c_str() ) ) ++found;
+				}
+			} );
+			CHECK_EQUAL( 0, found );
+			Report( "PathFilterLookup", name, ( elapsed * 1000000.0 ) / static_cast<double>( missing.size() ), "ns/lookup" );
+
+			const PathFilter *filter = vfs->GetPathFilter();
+			if ( filter ) {
+				Report( "PathFilterLookup", "filter size", static_cast<double>( filter->GetSizeInBytes() ) / 1024.0, "KB" );
+				Report( "PathFilterLookup", "expected false positive rate", filter->GetFalsePositiveRate() * 100.0, "%" );
+				Report( "PathFilterLookup", "measured false positive rate", static_cast<double>( filter->GetFalsePositives() ) * 100.0 / static_cast<double>( missing.size() ), "%" );
+			}
+
+			// existing paths which pass through the filter pay for hashing the path on top of the normal lookup
+			found = 0;
+			elapsed = TimeMilliseconds( [&]() {
+				for ( auto &path : paths ) {
+					if ( vfs->GetFile( path.c_str() ) ) ++found;
+				}
+			} );
+			CHECK_EQUAL( paths.size(), found );
+			Report( "PathFilterLookup", mode == 2 ? "existing (filtered)" : "existing", ( elapsed * 1000000.0 ) / static_cast<double>( paths.size() ), "ns/lookup" );
+			delete vfs;
+		}
+	}
+
+}
\ No newline at end of file
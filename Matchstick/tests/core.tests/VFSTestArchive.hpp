@@ -0,0 +1,180 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <zlib.h>
+
+namespace MGDF
+{
+namespace core
+{
+namespace tests
+{
+
+/**
+writes simple zip archives so that tests can generate content of any size on demand. Entries are stored
+uncompressed unless they are added with deflate enabled. Archives can also be saved using the zip64
+records, which are otherwise only written for archives too large to generate in a test
+*/
+class TestArchiveWriter
+{
+public:
+	TestArchiveWriter() {}
+	virtual ~TestArchiveWriter() {}
+
+	void AddFile( const std::string &name, const std::string &data, bool deflate = false ) {
+		Entry entry;
+		entry.name = name;
+		entry.data = data;
+		entry.deflate = deflate;
+		_entries.push_back( entry );
+	}
+
+	size_t GetEntryCount() const {
+		return _entries.size();
+	}
+
+	bool Save( const std::wstring &path, bool zip64 = false ) const {
+		std::string out;
+		std::string centralDirectory;
+
+		for ( auto &entry : _entries ) {
+			UINT32 crc = crc32( 0, reinterpret_cast<const Bytef *>( entry.data.data() ), static_cast<uInt>( entry.data.size() ) );
+			UINT32 size = static_cast<UINT32>( entry.data.size() );
+			std::string compressed = entry.deflate ? Deflate( entry.data ) : std::string();
+			const std::string &stored = entry.deflate ? compressed : entry.data;
+			UINT16 method = entry.deflate ? 8 : 0;
+			UINT16 nameLength = static_cast<UINT16>( entry.name.size() );
+			UINT32 offset = static_cast<UINT32>( out.size() );
+
+			Write32( out, 0x04034b50 );
+			Write16( out, 20 );       // version needed
+			Write16( out, 0 );        // flags
+			Write16( out, method );
+			Write16( out, 0 );        // time
+			Write16( out, 0x21 );     // date (1980-01-01)
+			Write32( out, crc );
+			Write32( out, zip64 ? ZIP64_MARKER : static_cast<UINT32>( stored.size() ) );
+			Write32( out, zip64 ? ZIP64_MARKER : size );
+			Write16( out, nameLength );
+			Write16( out, zip64 ? 20 : 0 ); // extra length
+			out += entry.name;
+			if ( zip64 ) {
+				Write16( out, 1 );
+				Write16( out, 16 );
+				Write64( out, size );
+				Write64( out, stored.size() );
+			}
+			out += stored;
+
+			Write32( centralDirectory, 0x02014b50 );
+			Write16( centralDirectory, 20 );  // version made by
+			Write16( centralDirectory, 20 );  // version needed
+			Write16( centralDirectory, 0 );
+			Write16( centralDirectory, method );
+			Write16( centralDirectory, 0 );
+			Write16( centralDirectory, 0x21 );
+			Write32( centralDirectory, crc );
+			Write32( centralDirectory, zip64 ? ZIP64_MARKER : static_cast<UINT32>( stored.size() ) );
+			Write32( centralDirectory, zip64 ? ZIP64_MARKER : size );
+			Write16( centralDirectory, nameLength );
+			Write16( centralDirectory, zip64 ? 28 : 0 ); // extra length
+			Write16( centralDirectory, 0 );   // comment length
+			Write16( centralDirectory, 0 );   // disk number
+			Write16( centralDirectory, 0 );   // internal attributes
+			Write32( centralDirectory, 0 );   // external attributes
+			Write32( centralDirectory, zip64 ? ZIP64_MARKER : offset );
+			centralDirectory += entry.name;
+			if ( zip64 ) {
+				Write16( centralDirectory, 1 );
+				Write16( centralDirectory, 24 );
+				Write64( centralDirectory, size );
+				Write64( centralDirectory, stored.size() );
+				Write64( centralDirectory, offset );
+			}
+		}
+
+		UINT32 centralDirectoryOffset = static_cast<UINT32>( out.size() );
+		out += centralDirectory;
+
+		if ( zip64 ) {
+			UINT32 recordOffset = static_cast<UINT32>( out.size() );
+			Write32( out, 0x06064b50 );
+			Write64( out, 44 );       // size of the remaining record
+			Write16( out, 45 );       // version made by
+			Write16( out, 45 );       // version needed
+			Write32( out, 0 );
+			Write32( out, 0 );
+			Write64( out, _entries.size() );
+			Write64( out, _entries.size() );
+			Write64( out, centralDirectory.size() );
+			Write64( out, centralDirectoryOffset );
+
+			Write32( out, 0x07064b50 );
+			Write32( out, 0 );
+			Write64( out, recordOffset );
+			Write32( out, 1 );
+		}
+
+		Write32( out, 0x06054b50 );
+		Write16( out, 0 );
+		Write16( out, 0 );
+		Write16( out, zip64 ? 0xffff : static_cast<UINT16>( _entries.size() ) );
+		Write16( out, zip64 ? 0xffff : static_cast<UINT16>( _entries.size() ) );
+		Write32( out, zip64 ? ZIP64_MARKER : static_cast<UINT32>( centralDirectory.size() ) );
+		Write32( out, zip64 ? ZIP64_MARKER : centralDirectoryOffset );
+		Write16( out, 0 );
+
+		std::ofstream file( path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+		if ( !file.is_open() ) return false;
+		file.write( out.data(), out.size() );
+		return !file.bad();
+	}
+private:
+	static const UINT32 ZIP64_MARKER = 0xffffffff;
+
+	struct Entry {
+		std::string name;
+		std::string data;
+		bool deflate;
+	};
+
+	static std::string Deflate( const std::string &data ) {
+		z_stream stream;
+		memset( &stream, 0, sizeof( stream ) );
+		deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY );
+
+		std::string out;
+		out.resize( deflateBound( &stream, static_cast<uLong>( data.size() ) ) );
+		stream.next_in = reinterpret_cast<Bytef *>( const_cast<char *>( data.data() ) );
+		stream.avail_in = static_cast<uInt>( data.size() );
+		stream.next_out = reinterpret_cast<Bytef *>( &out[0] );
+		stream.avail_out = static_cast<uInt>( out.size() );
+		deflate( &stream, Z_FINISH );
+		out.resize( stream.total_out );
+		deflateEnd( &stream );
+		return out;
+	}
+
+	static void Write16( std::string &out, UINT16 value ) {
+		out += static_cast<char>( value & 0xff );
+		out += static_cast<char>( ( value >> 8 ) & 0xff );
+	}
+
+	static void Write32( std::string &out, UINT32 value ) {
+		Write16( out, static_cast<UINT16>( value & 0xffff ) );
+		Write16( out, static_cast<UINT16>( ( value >> 16 ) & 0xffff ) );
+	}
+
+	static void Write64( std::string &out, UINT64 value ) {
+		Write32( out, static_cast<UINT32>( value & 0xffffffff ) );
+		Write32( out, static_cast<UINT32>( value >> 32 ) );
+	}
+
+	std::vector<Entry> _entries;
+};
+
+}
+}
+}
@@ -1,10 +1,24 @@
 #include "stdafx.h"
 
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
 #include "MGDFMockLogger.hpp"
 #include "MGDFMockErrorHandler.hpp"
+#include "VFSTestArchive.hpp"
 #include "../../src/core/common/MGDFResources.hpp"
 #include "../../src/core/vfs/MGDFVirtualFileSystemComponentImpl.hpp"
+#include "../../src/core/vfs/MGDFArena.hpp"
+#include "../../src/core/vfs/MGDFFolderBaseImpl.hpp"
+#include "../../src/core/vfs/MGDFEntryCache.hpp"
 #include "../../src/core/vfs/archive/zip/ZipArchiveHandlerImpl.hpp"
+#include "../../src/core/vfs/archive/pak/PakArchiveHandlerImpl.hpp"
+#include "../../src/core/vfs/archive/pak/PakWriter.hpp"
+#include "../../src/core/vfs/archive/pak/PakLayout.hpp"
+#include "../../src/core/vfs/MGDFAccessTrace.hpp"
+#include "../../src/core/vfs/MGDFPathFilter.hpp"
 
 using namespace MGDF;
 using namespace MGDF::core;
@@ -24,6 +38,7 @@ SUITE( VFSTests )
 
 			_vfs = CreateVirtualFileSystemComponentImpl();
 			_vfs->RegisterArchiveHandler( zip::CreateZipArchiveHandlerImpl( ( IErrorHandler * ) _errorHandler ) );
+			_vfs->RegisterArchiveHandler( pak::CreatePakArchiveHandlerImpl( ( IErrorHandler * ) _errorHandler ) );
 		}
 
 		virtual ~VFSTestFixture() {
@@ -180,4 +195,1219 @@ SUITE( VFSTests )
 		CHECK_EQUAL( "}", list[16] );
 	}
 
+	/**
+	check that lookups using the path index find the same files as walking the tree
+	*/
+	TEST_FIXTURE( VFSTestFixture, PathIndexTests ) {
+		_vfs->EnablePathIndex( true );
+		_vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content" ).c_str() );
+
+		IFile *file = _vfs->GetFile( L"test.zip/content/test.lua" );
+		CHECK( file != nullptr );
+		CHECK_WS_EQUAL( L"test.lua", file->GetName() );
+		CHECK( file == _vfs->GetFile( L"test.zip/content/test.lua" ) );
+		CHECK( file == _vfs->GetRoot()->GetChild( L"test.zip" )->GetChild( L"content" )->GetChild( L"test.lua" ) );
+		CHECK( _vfs->GetRoot() == _vfs->GetFile( L"" ) );
+		CHECK( _vfs->GetFile( L"test.zip/content/missing.lua" ) == nullptr );
+
+		// adding a path which is already indexed replaces the file it refers to
+		PathIndex index;
+		IFile *other = _vfs->GetFile( L"console.json" );
+		index.Add( L"a/b", file );
+		index.Add( L"a/b", other );
+		CHECK_EQUAL( 1, index.GetSize() );
+		CHECK( other == index.Find( L"a/b" ) );
+	}
+
+	/**
+	check that mapping the content tree in the background produces the same tree as mapping it on demand
+	*/
+	TEST_FIXTURE( VFSTestFixture, EagerMappingTests ) {
+		_vfs->EnableEagerMapping( true );
+		_vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content" ).c_str() );
+		_vfs->WaitForMapping();
+
+		CHECK_EQUAL( 5, _vfs->GetRoot()->GetChildCount() );
+		CHECK_EQUAL( true, _vfs->GetFile( L"test.zip" )->IsArchive() );
+		CHECK_WS_EQUAL( L"test.lua", _vfs->GetFile( L"test.zip/content/test.lua" )->GetName() );
+		CHECK_WS_EQUAL( L"console.json", _vfs->GetFile( L"console.json" )->GetName() );
+	}
+
+	/**
+	check that a vfs mapped from a saved manifest matches the vfs that was scanned to produce it
+	*/
+	TEST_FIXTURE( VFSTestFixture, ManifestTests ) {
+		std::wstring manifest = ( std::filesystem::temp_directory_path() / L"mgdf.vfstests.manifest" ).wstring();
+		std::filesystem::remove( manifest );
+
+		for ( UINT32 run = 0; run < 2; ++run ) {
+			_vfs->EnableManifest( manifest.c_str() );
+			_vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content" ).c_str() );
+
+			CHECK_EQUAL( 5, _vfs->GetRoot()->GetChildCount() );
+			CHECK_EQUAL( true, _vfs->GetFile( L"test.zip" )->IsArchive() );
+			CHECK_EQUAL( 6, _vfs->GetFile( L"test.zip" )->GetChildCount() );
+			CHECK_WS_EQUAL( L"gameState.xml", _vfs->GetFile( L"test.zip/boot/gameState.xml" )->GetName() );
+
+			IFile *file = _vfs->GetFile( L"test.zip/content/test.lua" );
+			IFileReader *reader = nullptr;
+			CHECK_EQUAL( MGDF_OK, file->Open( &reader ) );
+			std::vector<std::string> list;
+			ReadLines( reader, list );
+			CHECK_EQUAL( 20, list.size() );
+
+			//destroying the vfs saves the manifest
+			delete _vfs;
+			CHECK( std::filesystem::exists( manifest ) );
+			_vfs = CreateVirtualFileSystemComponentImpl();
+			_vfs->RegisterArchiveHandler( zip::CreateZipArchiveHandlerImpl( ( IErrorHandler * ) _errorHandler ) );
+		}
+		std::filesystem::remove( manifest );
+	}
+
+	/**
+	check that a view of a file exposes the same contents as reading it, for both mapped files and archive members
+	*/
+	TEST_FIXTURE( VFSTestFixture, FileViewTests ) {
+		_vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content" ).c_str() );
+
+		const wchar_t *paths[] = { L"console.json", L"test.zip/content/test.lua" };
+		for ( auto path : paths ) {
+			IFileReader *reader = nullptr;
+			CHECK_EQUAL( MGDF_OK, _vfs->GetFile( path )->Open( &reader ) );
+
+			const IFileView *view = reader->GetView();
+			CHECK( view != nullptr );
+			CHECK_EQUAL( reader->GetSize(), view->GetDataSize() );
+
+			std::vector<char> data( static_cast<size_t>( reader->GetSize() ) );
+			CHECK_EQUAL( data.size(), reader->Read( data.data(), static_cast<UINT32>( data.size() ) ) );
+			CHECK( reader->EndOfFile() );
+			CHECK( memcmp( data.data(), view->GetData(), data.size() ) == 0 );
+
+			reader->SetPosition( 1 );
+			CHECK_EQUAL( 1, reader->GetPosition() );
+			char c;
+			CHECK_EQUAL( 1, reader->Read( &c, 1 ) );
+			CHECK_EQUAL( data[1], c );
+			reader->Close();
+		}
+	}
+
+	/**
+	check that a file can have more than one reader open at once, each with its own position
+	*/
+	TEST_FIXTURE( VFSTestFixture, MultipleReaderTests ) {
+		_vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content" ).c_str() );
+
+		const wchar_t *paths[] = { L"console.json", L"test.zip/content/test.lua" };
+		for ( auto path : paths ) {
+			IFile *file = _vfs->GetFile( path );
+			IFileReader *reader1 = nullptr;
+			IFileReader *reader2 = nullptr;
+			CHECK_EQUAL( MGDF_OK, file->Open( &reader1 ) );
+			CHECK_EQUAL( MGDF_OK, file->Open( &reader2 ) );
+			CHECK( reader1 != reader2 );
+			CHECK( file->IsOpen() );
+
+			char c1[2], c2[2];
+			CHECK_EQUAL( 2, reader1->Read( c1, 2 ) );
+			CHECK_EQUAL( 2, reader1->GetPosition() );
+			CHECK_EQUAL( 0, reader2->GetPosition() );
+			CHECK_EQUAL( 1, reader2->Read( c2, 1 ) );
+			CHECK_EQUAL( c1[0], c2[0] );
+
+			reader1->Close();
+			CHECK( file->IsOpen() );
+			CHECK_EQUAL( 1, reader2->Read( c2 + 1, 1 ) );
+			CHECK_EQUAL( c1[1], c2[1] );
+			reader2->Close();
+			CHECK( !file->IsOpen() );
+		}
+	}
+
+	class CountingReadHandler: public IReadCompletionHandler
+	{
+	public:
+		CountingReadHandler()
+			: Completed( 0 )
+			, BytesRead( 0 ) {
+		}
+		virtual ~CountingReadHandler() {}
+		void OnReadComplete( MGDFError result, UINT64 bytesRead ) override {
+			if ( result == MGDF_OK ) {
+				BytesRead += bytesRead;
+			}
+			++Completed;
+		}
+		std::atomic<UINT32> Completed;
+		std::atomic<UINT64> BytesRead;
+	};
+
+	/**
+	check that asynchronous reads return the same data as reading the file directly
+	*/
+	TEST_FIXTURE( VFSTestFixture, AsyncReadTests ) {
+		_vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content" ).c_str() );
+
+		const wchar_t *paths[] = { L"console.json", L"test.zip/content/test.lua" };
+		for ( auto path : paths ) {
+			IFile *file = _vfs->GetFile( path );
+			IFileReader *reader = nullptr;
+			CHECK_EQUAL( MGDF_OK, file->Open( &reader ) );
+			std::vector<char> expected( static_cast<size_t>( reader->GetSize() ) );
+			reader->Read( expected.data(), static_cast<UINT32>( expected.size() ) );
+			reader->Close();
+
+			CountingReadHandler handler;
+			std::vector<char> head( 16 ), tail( expected.size() );
+			IAsyncRead *headRead = nullptr;
+			IAsyncRead *tailRead = nullptr;
+			CHECK_EQUAL( MGDF_OK, _vfs->ReadAsync( file, 0, 16, head.data(), &handler, &headRead ) );
+			CHECK_EQUAL( MGDF_OK, _vfs->ReadAsync( file, 16, tail.size(), tail.data(), &handler, &tailRead ) );
+
+			UINT64 bytesRead = 0;
+			CHECK_EQUAL( MGDF_OK, headRead->GetResult( &bytesRead ) );
+			CHECK_EQUAL( 16, bytesRead );
+			CHECK( memcmp( expected.data(), head.data(), 16 ) == 0 );
+			CHECK_EQUAL( MGDF_OK, tailRead->GetResult( &bytesRead ) );
+			CHECK_EQUAL( expected.size() - 16, bytesRead );
+			CHECK( memcmp( expected.data() + 16, tail.data(), bytesRead ) == 0 );
+			CHECK( headRead->IsComplete() && tailRead->IsComplete() );
+			CHECK_EQUAL( 2, handler.Completed );
+			CHECK_EQUAL( expected.size(), handler.BytesRead );
+			headRead->Dispose();
+			tailRead->Dispose();
+			CHECK( !file->IsOpen() );
+		}
+
+		IAsyncRead *folderRead = nullptr;
+		char buffer[1];
+		CHECK_EQUAL( MGDF_OK, _vfs->ReadAsync( _vfs->GetFile( L"test.zip/content" ), 0, 1, buffer, nullptr, &folderRead ) );
+		CHECK_EQUAL( MGDF_ERR_IS_FOLDER, folderRead->GetResult( nullptr ) );
+		folderRead->Dispose();
+	}
+
+	/**
+	check that zip entries which are inflated as they are read return the same data as entries inflated in full
+	*/
+	TEST_FIXTURE( VFSTestFixture, ZipStreamingTests ) {
+		_vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content/test.zip" ).c_str() );
+		IFileReader *reader = nullptr;
+		CHECK_EQUAL( MGDF_OK, _vfs->GetFile( L"content/test.lua" )->Open( &reader ) );
+		CHECK( reader->GetView() != nullptr );
+		std::vector<char> expected( static_cast<size_t>( reader->GetSize() ) );
+		reader->Read( expected.data(), static_cast<UINT32>( expected.size() ) );
+		reader->Close();
+
+		// stream every entry regardless of its size
+		zip::ZipArchiveHandlerImpl *handler = static_cast<zip::ZipArchiveHandlerImpl *>( zip::CreateZipArchiveHandlerImpl( ( IErrorHandler * ) _errorHandler ) );
+		handler->SetStreamingThreshold( 0 );
+		IVirtualFileSystemComponent *vfs = CreateVirtualFileSystemComponentImpl();
+		vfs->RegisterArchiveHandler( handler );
+		vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content/test.zip" ).c_str() );
+
+		IFile *file = vfs->GetFile( L"content/test.lua" );
+		IFileReader *stream1 = nullptr;
+		IFileReader *stream2 = nullptr;
+		CHECK_EQUAL( MGDF_OK, file->Open( &stream1 ) );
+		CHECK_EQUAL( MGDF_OK, file->Open( &stream2 ) );
+		CHECK( stream1->GetView() == nullptr );
+		CHECK_EQUAL( expected.size(), stream1->GetSize() );
+
+		std::vector<char> actual( expected.size() );
+		CHECK_EQUAL( actual.size(), stream1->Read( actual.data(), static_cast<UINT32>( actual.size() ) ) );
+		CHECK( stream1->EndOfFile() );
+		CHECK( memcmp( expected.data(), actual.data(), actual.size() ) == 0 );
+
+		//seeking forward skips data and seeking backward restarts the entry
+		char c;
+		stream2->SetPosition( 10 );
+		CHECK_EQUAL( 10, stream2->GetPosition() );
+		CHECK_EQUAL( 1, stream2->Read( &c, 1 ) );
+		CHECK_EQUAL( expected[10], c );
+		stream2->SetPosition( 3 );
+		CHECK_EQUAL( 1, stream2->Read( &c, 1 ) );
+		CHECK_EQUAL( expected[3], c );
+
+		stream1->Close();
+		stream2->Close();
+		CHECK( !file->IsOpen() );
+		delete vfs;
+	}
+
+	/**
+	check that entries from one archive can be inflated from several threads at once
+	*/
+	TEST_FIXTURE( VFSTestFixture, ParallelZipTests ) {
+		_vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content/test.zip" ).c_str() );
+
+		const wchar_t *paths[] = { L"game.xml", L"preferences.xml", L"boot/gameState.xml", L"content/test.lua" };
+		std::vector<std::vector<char>> expected;
+		for ( auto path : paths ) {
+			IFileReader *reader = nullptr;
+			_vfs->GetFile( path )->Open( &reader );
+			expected.push_back( std::vector<char>( static_cast<size_t>( reader->GetSize() ) ) );
+			reader->Read( expected.back().data(), static_cast<UINT32>( expected.back().size() ) );
+			reader->Close();
+		}
+
+		std::atomic<UINT32> failures( 0 );
+		std::vector<std::thread> threads;
+		for ( UINT32 t = 0; t < 4; ++t ) {
+			threads.push_back( std::thread( [&, t]() {
+				for ( UINT32 i = 0; i < 100; ++i ) {
+					size_t index = ( i + t ) % expected.size();
+					IFileReader *reader = nullptr;
+					if ( _vfs->GetFile( paths[index] )->Open( &reader ) != MGDF_OK ) {
+						++failures;
+						continue;
+					}
+					std::vector<char> actual( expected[index].size() );
+					if ( reader->Read( actual.data(), static_cast<UINT32>( actual.size() ) ) != actual.size() || actual != expected[index] ) {
+						++failures;
+					}
+					reader->Close();
+				}
+			} ) );
+		}
+		for ( auto &thread : threads ) {
+			thread.join();
+		}
+		CHECK_EQUAL( 0, failures );
+	}
+
+	/**
+	check that when several threads look up paths in an archive which hasn't been mapped yet, the archive is only
+	mapped once and every thread gets the same files
+	*/
+	TEST_FIXTURE( VFSTestFixture, ContendedMappingTests ) {
+		const wchar_t *paths[] = { L"test.zip/game.xml", L"test.zip/boot/gameState.xml", L"test.zip/content/test.lua", L"test.zip/content" };
+		const size_t pathCount = sizeof( paths ) / sizeof( paths[0] );
+		const UINT32 threadCount = 16;
+
+		for ( UINT32 round = 0; round < 20; ++round ) {
+			IVirtualFileSystemComponent *vfs = CreateVirtualFileSystemComponentImpl();
+			vfs->RegisterArchiveHandler( zip::CreateZipArchiveHandlerImpl( ( IErrorHandler * ) _errorHandler ) );
+			vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content" ).c_str() );
+
+			// the threads all start looking up the paths at once, so they race to map the archive
+			std::atomic<bool> start( false );
+			std::vector<std::vector<IFile *>> found( threadCount, std::vector<IFile *>( pathCount ) );
+			std::vector<std::thread> threads;
+			for ( UINT32 t = 0; t < threadCount; ++t ) {
+				threads.push_back( std::thread( [&, t]() {
+					while ( !start ) {
+						std::this_thread::yield();
+					}
+					for ( size_t i = 0; i < pathCount; ++i ) {
+						found[t][i] = vfs->GetFile( paths[( i + t ) % pathCount] );
+					}
+				} ) );
+			}
+			start = true;
+			for ( auto &thread : threads ) {
+				thread.join();
+			}
+
+			for ( UINT32 t = 0; t < threadCount; ++t ) {
+				for ( size_t i = 0; i < pathCount; ++i ) {
+					IFile *file = found[t][i];
+					CHECK( file != nullptr );
+					CHECK( file == vfs->GetFile( paths[( i + t ) % pathCount] ) );
+				}
+			}
+			delete vfs;
+		}
+	}
+
+	/**
+	check that reopening an archive entry uses the cached contents from the previous open
+	*/
+	TEST_FIXTURE( VFSTestFixture, EntryCacheTests ) {
+		_vfs->EnableEntryCache( 1024 * 1024 );
+		_vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content/test.zip" ).c_str() );
+
+		for ( UINT32 i = 0; i < 2; ++i ) {
+			IFileReader *reader = nullptr;
+			CHECK_EQUAL( MGDF_OK, _vfs->GetFile( L"content/test.lua" )->Open( &reader ) );
+			std::vector<std::string> list;
+			ReadLines( reader, list );
+			CHECK_EQUAL( 20, list.size() );
+		}
+		CHECK_EQUAL( 1, _vfs->GetEntryCache()->GetMisses() );
+		CHECK_EQUAL( 1, _vfs->GetEntryCache()->GetHits() );
+		CHECK( _vfs->GetEntryCache()->GetSize() > 0 );
+	}
+
+	/**
+	check that the entry cache evicts the least recently used entries once it is over budget
+	*/
+	TEST( EntryCacheEvictionTests ) {
+		EntryCache cache( 100 );
+		IFile *archive = reinterpret_cast<IFile *>( 1 );
+		IFile *other = reinterpret_cast<IFile *>( 2 );
+		EntryCache::Data data( static_cast<char *>( malloc( 50 ) ), free );
+
+		cache.Insert( archive, 0, data, 40 );
+		cache.Insert( archive, 1, data, 40 );
+		CHECK( cache.Find( archive, 0 ) != nullptr ); // entry 0 is now more recently used than entry 1
+		cache.Insert( archive, 2, data, 40 );
+		CHECK_EQUAL( 1, cache.GetEvictions() );
+		CHECK( cache.Find( archive, 1 ) == nullptr );
+		CHECK( cache.Find( archive, 0 ) != nullptr );
+		CHECK( cache.Find( archive, 2 ) != nullptr );
+		CHECK( cache.Find( other, 0 ) == nullptr ); // entries with the same index in another archive are distinct
+		CHECK_EQUAL( 80, cache.GetSize() );
+
+		cache.Insert( archive, 1, data, 101 ); // larger than the whole budget so not cached
+		CHECK( cache.Find( archive, 1 ) == nullptr );
+		CHECK_EQUAL( 3, cache.GetHits() );
+		CHECK_EQUAL( 3, cache.GetMisses() );
+
+		// removing an archive releases all of its entries without touching those of other archives
+		cache.Insert( other, 0, data, 10 );
+		cache.Remove( archive );
+		CHECK_EQUAL( 10, cache.GetSize() );
+		CHECK( cache.Find( archive, 0 ) == nullptr );
+		CHECK( cache.Find( other, 0 ) != nullptr );
+	}
+
+	/**
+	check that entries stored without compression are read in place from the archive
+	*/
+	TEST_FIXTURE( VFSTestFixture, StoredZipTests ) {
+		std::filesystem::path archivePath = std::filesystem::temp_directory_path() / L"mgdf.vfstests.stored.zip";
+		tests::TestArchiveWriter writer;
+		writer.AddFile( "stored.txt", "stored content" );
+		writer.AddFile( "deflated.txt", "deflated content", true );
+		CHECK( writer.Save( archivePath.wstring() ) );
+		_vfs->Mount( archivePath.c_str() );
+
+		IFile *file = _vfs->GetFile( L"stored.txt" );
+		IFileReader *reader1 = nullptr;
+		IFileReader *reader2 = nullptr;
+		CHECK_EQUAL( MGDF_OK, file->Open( &reader1 ) );
+		CHECK_EQUAL( MGDF_OK, file->Open( &reader2 ) );
+		CHECK_EQUAL( 14, reader1->GetSize() );
+		CHECK( reader1->GetView()->GetData() == reader2->GetView()->GetData() );
+		CHECK( memcmp( "stored content", reader1->GetView()->GetData(), 14 ) == 0 );
+
+		char buffer[16];
+		reader2->SetPosition( 7 );
+		CHECK_EQUAL( 7, reader2->Read( buffer, sizeof( buffer ) ) );
+		CHECK( memcmp( "content", buffer, 7 ) == 0 );
+		reader1->Close();
+		reader2->Close();
+		CHECK( !file->IsOpen() );
+
+		// compressed entries still go through the normal decompression path
+		IFileReader *reader = nullptr;
+		CHECK_EQUAL( MGDF_OK, _vfs->GetFile( L"deflated.txt" )->Open( &reader ) );
+		CHECK_EQUAL( 16, reader->Read( buffer, sizeof( buffer ) ) );
+		CHECK( memcmp( "deflated content", buffer, 16 ) == 0 );
+		reader->Close();
+
+		//the archive stays open until the vfs is destroyed
+		delete _vfs;
+		_vfs = nullptr;
+		std::filesystem::remove( archivePath );
+	}
+
+	/**
+	check that archives and entries using the zip64 records can be mapped and read
+	*/
+	TEST_FIXTURE( VFSTestFixture, Zip64Tests ) {
+		std::filesystem::path archivePath = std::filesystem::temp_directory_path() / L"mgdf.vfstests.zip64.zip";
+		std::string deflated( 100000, 'z' );
+		tests::TestArchiveWriter writer;
+		writer.AddFile( "stored.txt", "stored content" );
+		writer.AddFile( "folder/deflated.txt", deflated, true );
+		CHECK( writer.Save( archivePath.wstring(), true ) );
+		_vfs->Mount( archivePath.c_str() );
+
+		IFile *file = _vfs->GetFile( L"folder/deflated.txt" );
+		CHECK( file != nullptr );
+		IFileReader *reader = nullptr;
+		CHECK_EQUAL( MGDF_OK, file->Open( &reader ) );
+		CHECK_EQUAL( deflated.size(), reader->GetSize() );
+		std::vector<char> data( deflated.size() );
+		CHECK_EQUAL( data.size(), reader->Read( data.data(), data.size() ) );
+		CHECK( memcmp( deflated.data(), data.data(), data.size() ) == 0 );
+		reader->Close();
+
+		// stored entries are still read in place when their location is in the zip64 extra field
+		CHECK_EQUAL( MGDF_OK, _vfs->GetFile( L"stored.txt" )->Open( &reader ) );
+		CHECK( reader->GetView() != nullptr );
+		CHECK_EQUAL( 14, reader->GetView()->GetDataSize() );
+		CHECK( memcmp( "stored content", reader->GetView()->GetData(), 14 ) == 0 );
+		reader->Close();
+
+		//the archive stays open until the vfs is destroyed
+		delete _vfs;
+		_vfs = nullptr;
+		std::filesystem::remove( archivePath );
+	}
+
+	/**
+	check that the folder tree is built correctly from a central directory whose entries aren't in path order
+	*/
+	TEST_FIXTURE( VFSTestFixture, ZipCentralDirectoryTests ) {
+		std::filesystem::path archivePath = std::filesystem::temp_directory_path() / L"mgdf.vfstests.directory.zip";
+		tests::TestArchiveWriter writer;
+		writer.AddFile( "a/b/c.txt", "c" );
+		writer.AddFile( "a.txt", "a" );
+		writer.AddFile( "empty/", "" );
+		writer.AddFile( "a/d.txt", "d", true );
+		writer.AddFile( "a/b/e.txt", "e" );
+		writer.AddFile( "a/\xc3\xbc.txt", "u" );
+		CHECK( writer.Save( archivePath.wstring() ) );
+		_vfs->Mount( archivePath.c_str() );
+
+		IFile *folder = _vfs->GetFile( L"a" );
+		CHECK( folder != nullptr && folder->IsFolder() );
+		CHECK_EQUAL( 3, folder->GetChildCount() );
+		CHECK_EQUAL( 2, _vfs->GetFile( L"a/b" )->GetChildCount() );
+		CHECK( _vfs->GetFile( L"a/b/c.txt" ) != nullptr );
+		CHECK( _vfs->GetFile( L"a/b/e.txt" ) != nullptr );
+		CHECK( _vfs->GetFile( L"a/d.txt" ) != nullptr );
+		CHECK( _vfs->GetFile( L"a/\u00fc.txt" ) != nullptr );
+		CHECK( _vfs->GetFile( L"a.txt" ) != nullptr );
+		CHECK( _vfs->GetFile( L"empty" )->IsFolder() );
+		CHECK_EQUAL( 0, _vfs->GetFile( L"empty" )->GetChildCount() );
+
+		IFileReader *reader = nullptr;
+		char buffer[1];
+		CHECK_EQUAL( MGDF_OK, _vfs->GetFile( L"a/d.txt" )->Open( &reader ) );
+		CHECK_EQUAL( 1, reader->Read( buffer, sizeof( buffer ) ) );
+		CHECK_EQUAL( 'd', buffer[0] );
+		reader->Close();
+
+		//the archive stays open until the vfs is destroyed
+		delete _vfs;
+		_vfs = nullptr;
+		std::filesystem::remove( archivePath );
+	}
+
+	/**
+	check that packs can be written and mapped, and that stored, compressed and duplicate entries can be read
+	*/
+	TEST_FIXTURE( VFSTestFixture, PakArchiveTests ) {
+		std::filesystem::path archivePath = std::filesystem::temp_directory_path() / L"mgdf.vfstests.pak.mgdfpak";
+		std::string compressible( 200000, 'p' );
+		for ( size_t i = 0; i < compressible.size(); i += 7 ) {
+			compressible[i] = static_cast<char>( 'a' + i % 26 );
+		}
+		pak::PakWriter writer;
+		writer.AddData( L"stored.txt", "stored content" );
+		writer.AddData( L"folder/compressed.txt", compressible );
+		writer.AddData( L"folder/sub/duplicate.txt", compressible );
+		writer.AddData( L"folder/copy.txt", "stored content" );
+		CHECK( writer.Save( archivePath.wstring() ) );
+		CHECK_EQUAL( 2, writer.GetDuplicateCount() );
+		CHECK_EQUAL( 1, writer.GetCompressedCount() );
+		_vfs->Mount( archivePath.c_str() );
+
+		IFile *folder = _vfs->GetFile( L"folder" );
+		CHECK( folder != nullptr && folder->IsFolder() );
+		CHECK_EQUAL( 3, folder->GetChildCount() );
+		IFile *duplicate = _vfs->GetFile( L"folder/sub/duplicate.txt" );
+		CHECK( duplicate != nullptr );
+		CHECK( duplicate == folder->GetChild( L"sub" )->GetChild( L"duplicate.txt" ) );
+
+		// duplicate stored entries share the same data in the mapping of the pack
+		IFileReader *reader1 = nullptr;
+		IFileReader *reader2 = nullptr;
+		CHECK_EQUAL( MGDF_OK, _vfs->GetFile( L"stored.txt" )->Open( &reader1 ) );
+		CHECK_EQUAL( MGDF_OK, _vfs->GetFile( L"folder/copy.txt" )->Open( &reader2 ) );
+		CHECK( reader1->GetView() != nullptr );
+		CHECK( reader1->GetView()->GetData() == reader2->GetView()->GetData() );
+		CHECK( memcmp( "stored content", reader1->GetView()->GetData(), 14 ) == 0 );
+		reader1->Close();
+		reader2->Close();
+
+		IFileReader *reader = nullptr;
+		CHECK_EQUAL( MGDF_OK, duplicate->Open( &reader ) );
+		CHECK_EQUAL( compressible.size(), reader->GetSize() );
+		std::vector<char> data( compressible.size() );
+		CHECK_EQUAL( data.size(), reader->Read( data.data(), data.size() ) );
+		CHECK( memcmp( compressible.data(), data.data(), data.size() ) == 0 );
+		CHECK( reader->EndOfFile() );
+
+		// seeking only decompresses the block containing the new position
+		reader->SetPosition( 150000 );
+		CHECK_EQUAL( 10, reader->Read( data.data(), 10 ) );
+		CHECK( memcmp( compressible.data() + 150000, data.data(), 10 ) == 0 );
+		reader->SetPosition( 10 );
+		CHECK_EQUAL( 10, reader->Read( data.data(), 10 ) );
+		CHECK( memcmp( compressible.data() + 10, data.data(), 10 ) == 0 );
+		reader->Close();
+		CHECK( !duplicate->IsOpen() );
+
+		//the archive stays open until the vfs is destroyed
+		delete _vfs;
+		_vfs = nullptr;
+		std::filesystem::remove( archivePath );
+	}
+
+	/**
+	check that packs with a corrupt bucket table are rejected, as lookups in them might never find an empty bucket
+	*/
+	TEST_FIXTURE( VFSTestFixture, PakCorruptBucketTests ) {
+		std::filesystem::path archivePath = std::filesystem::temp_directory_path() / L"mgdf.vfstests.corrupt.mgdfpak";
+		pak::PakWriter writer;
+		writer.AddData( L"a.txt", "a" );
+		writer.AddData( L"b.txt", "b" );
+		CHECK( writer.Save( archivePath.wstring() ) );
+
+		std::vector<char> original;
+		{
+			std::ifstream in( archivePath, std::ios::binary );
+			original.assign( std::istreambuf_iterator<char>( in ), std::istreambuf_iterator<char>() );
+		}
+		const UINT32 bucketCount = reinterpret_cast<const pak::PakHeader *>( original.data() )->bucketCount;
+
+		IArchiveHandler *handler = pak::CreatePakArchiveHandlerImpl( ( IErrorHandler * ) _errorHandler );
+		for ( UINT32 corruption = 0; corruption < 2; ++corruption ) {
+			std::vector<char> corrupt( original );
+			UINT32 *buckets = reinterpret_cast<UINT32 *>( corrupt.data() + pak::PakBucketsOffset() );
+			if ( corruption == 0 ) {
+				// every bucket is full
+				std::fill( buckets, buckets + bucketCount, 0 );
+			} else {
+				// the first entry is in two buckets
+				*std::find( buckets, buckets + bucketCount, PAK_EMPTY_BUCKET ) = 0;
+			}
+			{
+				std::ofstream out( archivePath, std::ios::binary | std::ios::trunc );
+				out.write( corrupt.data(), corrupt.size() );
+			}
+			CHECK( handler->MapArchive( L"corrupt.mgdfpak", archivePath.c_str(), nullptr ) == nullptr );
+		}
+		handler->Dispose();
+		std::filesystem::remove( archivePath );
+	}
+
+	/**
+	check that overlays shadow files in the layers below them, and that folders in different layers are merged
+	*/
+	TEST_FIXTURE( VFSTestFixture, OverlayTests ) {
+		std::filesystem::path basePath = std::filesystem::temp_directory_path() / L"mgdf.vfstests.base.mgdfpak";
+		std::filesystem::path patchPath = std::filesystem::temp_directory_path() / L"mgdf.vfstests.patch.mgdfpak";
+		pak::PakWriter base;
+		base.AddData( L"a/x.txt", "base" );
+		base.AddData( L"a/y.txt", "base" );
+		base.AddData( L"b.txt", "base" );
+		base.AddData( L"c/z.txt", "base" );
+		base.AddData( L"e/f/g.txt", "base" );
+		CHECK( base.Save( basePath.wstring() ) );
+		pak::PakWriter patch;
+		patch.AddData( L"a/x.txt", "patch" );
+		patch.AddData( L"c", "patch" );
+		patch.AddData( L"d.txt", "patch" );
+		CHECK( patch.Save( patchPath.wstring() ) );
+
+		_vfs->EnablePathIndex( true );
+		_vfs->AddOverlay( patchPath.c_str() );
+		_vfs->Mount( basePath.c_str() );
+
+		CHECK_EQUAL( 5, _vfs->GetRoot()->GetChildCount() );
+		IFile *folder = _vfs->GetFile( L"a" );
+		CHECK( folder != nullptr && folder->IsFolder() );
+		CHECK_EQUAL( 2, folder->GetChildCount() );
+
+		IFile *file = _vfs->GetFile( L"a/x.txt" );
+		CHECK( file != nullptr );
+		CHECK( file == folder->GetChild( L"x.txt" ) );
+		CHECK( file->GetParent() == folder );
+		CHECK_WS_EQUAL( L"a/x.txt", file->GetLogicalPath() );
+		IFileReader *reader = nullptr;
+		char buffer[16];
+		CHECK_EQUAL( MGDF_OK, file->Open( &reader ) );
+		CHECK_EQUAL( 5, reader->Read( buffer, sizeof( buffer ) ) );
+		CHECK( memcmp( "patch", buffer, 5 ) == 0 );
+		reader->Close();
+
+		// files in lower layers are still visible where they aren't shadowed
+		CHECK( _vfs->GetFile( L"a/y.txt" ) != nullptr );
+		CHECK( _vfs->GetFile( L"b.txt" ) != nullptr );
+		CHECK( _vfs->GetFile( L"d.txt" ) != nullptr );
+
+		// content which is only in one layer still has the merged folders as its parents
+		IFile *nested = _vfs->GetFile( L"e/f/g.txt" );
+		CHECK( nested != nullptr );
+		CHECK( nested->GetParent() == _vfs->GetFile( L"e/f" ) );
+		CHECK( nested->GetParent()->GetParent() == _vfs->GetFile( L"e" ) );
+		CHECK( _vfs->GetFile( L"e" )->GetParent() == _vfs->GetRoot() );
+		CHECK( _vfs->GetFile( L"b.txt" )->GetParent() == _vfs->GetRoot() );
+		CHECK_WS_EQUAL( L"e/f/g.txt", nested->GetLogicalPath() );
+
+		// a file shadows a folder with the same path in a lower layer, along with everything in it
+		CHECK( _vfs->GetFile( L"c" ) != nullptr && !_vfs->GetFile( L"c" )->IsFolder() );
+		CHECK( _vfs->GetFile( L"c/z.txt" ) == nullptr );
+
+		//the packs stay open until the vfs is destroyed
+		delete _vfs;
+		_vfs = nullptr;
+		std::filesystem::remove( basePath );
+		std::filesystem::remove( patchPath );
+	}
+
+	/**
+	check that changes to watched content are applied to the vfs without remapping the rest of the folder
+	*/
+	TEST_FIXTURE( VFSTestFixture, WatcherTests ) {
+		std::filesystem::path contentPath = std::filesystem::temp_directory_path() / L"mgdf.vfstests.watched";
+		std::filesystem::remove_all( contentPath );
+		std::filesystem::create_directories( contentPath / L"folder" );
+		std::ofstream( ( contentPath / L"folder" / L"existing.txt" ).wstring() ) << "existing";
+
+		_vfs->EnablePathIndex( true );
+		_vfs->EnableWatcher( true );
+		_vfs->Mount( contentPath.c_str() );
+
+		IFile *existing = _vfs->GetFile( L"folder/existing.txt" );
+		CHECK( existing != nullptr );
+		CHECK( _vfs->GetFile( L"folder/added.txt" ) == nullptr );
+
+		std::ofstream( ( contentPath / L"folder" / L"added.txt" ).wstring() ) << "added";
+		std::vector<std::wstring> changes;
+		for ( UINT32 i = 0; i < 100 && std::find( changes.begin(), changes.end(), L"folder/added.txt" ) == changes.end(); ++i ) {
+			std::vector<std::wstring> batch;
+			std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+			_vfs->ProcessChanges( batch );
+			changes.insert( changes.end(), batch.begin(), batch.end() );
+		}
+		CHECK( std::find( changes.begin(), changes.end(), L"folder/added.txt" ) != changes.end() );
+		IFile *added = _vfs->GetFile( L"folder/added.txt" );
+		CHECK( added != nullptr );
+		CHECK( added == _vfs->GetFile( L"folder" )->GetChild( L"added.txt" ) );
+		CHECK( existing == _vfs->GetFile( L"folder/existing.txt" ) );
+
+		std::filesystem::remove( contentPath / L"folder" / L"added.txt" );
+		changes.clear();
+		for ( UINT32 i = 0; i < 100 && _vfs->GetFile( L"folder/added.txt" ) != nullptr; ++i ) {
+			std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+			_vfs->ProcessChanges( changes );
+		}
+		CHECK( _vfs->GetFile( L"folder/added.txt" ) == nullptr );
+		CHECK_EQUAL( 1, _vfs->GetFile( L"folder" )->GetChildCount() );
+	}
+
+	/**
+	check that prefetching a folder or archive warms up everything in it, so opening its files afterwards hits the entry cache
+	*/
+	TEST_FIXTURE( VFSTestFixture, PrefetchTests ) {
+		_vfs->EnableEntryCache( 1024 * 1024 );
+		_vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content" ).c_str() );
+
+		const wchar_t *paths[] = { L"test.zip", L"console.json", L"missing.json" };
+		IPrefetch *prefetch = nullptr;
+		CHECK_EQUAL( MGDF_OK, _vfs->Prefetch( paths, 3, PREFETCH_HIGH, &prefetch ) );
+		prefetch->Wait();
+		CHECK( prefetch->IsComplete() );
+		CHECK( prefetch->GetPrefetchedCount() > 1 );
+		prefetch->Dispose();
+
+		const size_t misses = _vfs->GetEntryCache()->GetMisses();
+		IFileReader *reader = nullptr;
+		CHECK_EQUAL( MGDF_OK, _vfs->GetFile( L"test.zip/content/test.lua" )->Open( &reader ) );
+		reader->Close();
+		CHECK_EQUAL( misses, _vfs->GetEntryCache()->GetMisses() );
+		CHECK( _vfs->GetEntryCache()->GetHits() > 0 );
+
+		// a cancelled prefetch still completes, without prefetching anything which hadn't already started
+		CHECK_EQUAL( MGDF_OK, _vfs->Prefetch( paths, 3, PREFETCH_LOW, &prefetch ) );
+		prefetch->Cancel();
+		prefetch->Wait();
+		CHECK( prefetch->IsComplete() );
+		prefetch->Dispose();
+
+		CHECK_EQUAL( MGDF_ERR_INVALID_PARAMETER, _vfs->Prefetch( nullptr, 0, PREFETCH_NORMAL, nullptr ) );
+	}
+
+	/**
+	check that a prefetch of paths which are looked up straight away isn't completed before all of its paths have been queued
+	*/
+	TEST_FIXTURE( VFSTestFixture, PrefetchMissingTests ) {
+		_vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content" ).c_str() );
+
+		const wchar_t *paths[] = { L"missing1.json", L"missing2.json", L"missing3.json", L"missing4.json", L"missing5.json", L"missing6.json", L"missing7.json", L"missing8.json" };
+		for ( UINT32 i = 0; i < 100; ++i ) {
+			CHECK_EQUAL( MGDF_OK, _vfs->Prefetch( paths, 8, PREFETCH_NORMAL, nullptr ) );
+		}
+
+		// a prefetch with a handle is only complete once every path has been looked up
+		IPrefetch *prefetch = nullptr;
+		CHECK_EQUAL( MGDF_OK, _vfs->Prefetch( paths, 8, PREFETCH_LOW, &prefetch ) );
+		prefetch->Wait();
+		CHECK( prefetch->IsComplete() );
+		CHECK_EQUAL( 0, prefetch->GetPrefetchedCount() );
+		prefetch->Dispose();
+	}
+
+	/**
+	check that queries match glob patterns across folders and archives, and return each match once in name order
+	*/
+	TEST_FIXTURE( VFSTestFixture, QueryTests ) {
+		_vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content" ).c_str() );
+
+		auto count = [this]( const wchar_t *pattern ) {
+			IFileQuery *query = nullptr;
+			if ( _vfs->Query( pattern, &query ) != MGDF_OK ) return -1;
+			int matches = 0;
+			while ( query->Next() ) ++matches;
+			query->Dispose();
+			return matches;
+		};
+
+		CHECK_EQUAL( 4, count( L"*.json" ) );
+		CHECK_EQUAL( 3, count( L"[a-z]*.json" ) );
+		CHECK_EQUAL( 1, count( L"[!a-z]*.json" ) );
+		CHECK_EQUAL( 5, count( L"test.zip/**/*.xml" ) );
+		CHECK_EQUAL( 2, count( L"**/boot/**/*.xml" ) );
+		CHECK_EQUAL( 2, count( L"test.zip/boot/*" ) );
+		CHECK_EQUAL( 0, count( L"missing/**" ) );
+		// a trailing ** matches everything in the folder, but not the folder itself
+		CHECK_EQUAL( 2, count( L"test.zip/boot/**" ) );
+		CHECK_EQUAL( 9, count( L"test.zip/**" ) );
+
+		IFileQuery *query = nullptr;
+		CHECK_EQUAL( MGDF_OK, _vfs->Query( L"**/te?t.lua", &query ) );
+		CHECK( query->Next() == _vfs->GetFile( L"test.zip/content/test.lua" ) );
+		CHECK( query->Next() == nullptr );
+		query->Dispose();
+
+		CHECK_EQUAL( MGDF_OK, _vfs->Query( L"/*.json", &query ) );
+		CHECK_WS_EQUAL( L"Update.json", query->Next()->GetName() );
+		CHECK_WS_EQUAL( L"console.json", query->Next()->GetName() );
+		query->Dispose();
+
+		CHECK_EQUAL( MGDF_ERR_INVALID_PARAMETER, _vfs->Query( L"test.zip/[bc", &query ) );
+		CHECK_EQUAL( MGDF_ERR_INVALID_PARAMETER, _vfs->Query( L"", &query ) );
+	}
+
+	/**
+	check that a trace records the files opened and read through the vfs, and that packs laid out from a trace
+	store thier entries in the order they were first accessed
+	*/
+	TEST_FIXTURE( VFSTestFixture, TraceTests ) {
+		std::filesystem::path archivePath = std::filesystem::temp_directory_path() / L"mgdf.vfstests.trace.mgdfpak";
+		std::filesystem::path layoutPath = std::filesystem::temp_directory_path() / L"mgdf.vfstests.layout.mgdfpak";
+		std::wstring trace = ( std::filesystem::temp_directory_path() / L"mgdf.vfstests.trace" ).wstring();
+		std::filesystem::remove( trace );
+
+		const wchar_t *entries[] = { L"a.txt", L"b.txt", L"c.txt" };
+		pak::PakWriter writer;
+		writer.AddData( entries[0], "aaaa" );
+		writer.AddData( entries[1], "bbbb" );
+		writer.AddData( entries[2], "cccc" );
+		CHECK( writer.Save( archivePath.wstring() ) );
+
+		_vfs->EnableTrace( trace.c_str() );
+		_vfs->Mount( archivePath.c_str() );
+		char buffer[4];
+		for ( auto path : { L"c.txt", L"a.txt" } ) {
+			IFileReader *reader = nullptr;
+			CHECK_EQUAL( MGDF_OK, _vfs->GetFile( path )->Open( &reader ) );
+			CHECK_EQUAL( 4, reader->Read( buffer, 4 ) );
+			reader->Close();
+		}
+
+		//destroying the vfs saves the trace
+		delete _vfs;
+		_vfs = CreateVirtualFileSystemComponentImpl();
+		_vfs->RegisterArchiveHandler( pak::CreatePakArchiveHandlerImpl( ( IErrorHandler * ) _errorHandler ) );
+
+		std::vector<std::wstring> paths;
+		std::vector<TraceEvent> events;
+		CHECK( AccessTrace::Load( trace, paths, events ) );
+		CHECK_EQUAL( 2, paths.size() );
+		CHECK_EQUAL( 4, events.size() );
+		if ( paths.size() == 2 && events.size() == 4 ) {
+			CHECK_WS_EQUAL( L"c.txt", paths[0].c_str() );
+			CHECK_WS_EQUAL( L"a.txt", paths[1].c_str() );
+			CHECK_EQUAL( TraceEvent::OPEN, events[0].type );
+			CHECK_EQUAL( TraceEvent::READ, events[1].type );
+			CHECK_EQUAL( 0, events[1].offset );
+			CHECK_EQUAL( 4, events[1].length );
+			CHECK_EQUAL( 1, events[3].path );
+		}
+
+		pak::PakLayout layout( 1000000 );
+		CHECK( layout.AddTrace( trace ) );
+		CHECK_EQUAL( 1, layout.GetPhaseCount() );
+		std::vector<std::wstring> order;
+		layout.GetOrder( std::vector<std::wstring>( entries, entries + 3 ), order );
+		CHECK_EQUAL( 2, order.size() );
+		if ( order.size() == 2 ) {
+			CHECK_WS_EQUAL( L"c.txt", order[0].c_str() );
+			CHECK_WS_EQUAL( L"a.txt", order[1].c_str() );
+		}
+
+		// the stored entries of the laid out pack are mapped in the traced order, followed by the untraced entries
+		writer.SetLayout( order );
+		CHECK( writer.Save( layoutPath.wstring() ) );
+		_vfs->Mount( layoutPath.c_str() );
+		IFileReader *readers[3];
+		for ( UINT32 i = 0; i < 3; ++i ) {
+			CHECK_EQUAL( MGDF_OK, _vfs->GetFile( entries[i] )->Open( &readers[i] ) );
+		}
+		const char *a = static_cast<const char *>( readers[0]->GetView()->GetData() );
+		const char *b = static_cast<const char *>( readers[1]->GetView()->GetData() );
+		const char *c = static_cast<const char *>( readers[2]->GetView()->GetData() );
+		CHECK( c < a && a < b );
+		CHECK( memcmp( "aaaa", a, 4 ) == 0 );
+		for ( auto reader : readers ) {
+			reader->Close();
+		}
+		std::filesystem::remove( trace );
+
+		//the laid out pack stays open until the vfs is destroyed
+		delete _vfs;
+		_vfs = nullptr;
+		std::filesystem::remove( archivePath );
+		std::filesystem::remove( layoutPath );
+	}
+
+	/**
+	check that reading several ranges at once returns the same data as reading each range separately, for mapped
+	files, streamed zip entries and compressed pack entries, including ranges which overlap or run past the end of the file
+	*/
+	TEST_FIXTURE( VFSTestFixture, ReadManyTests ) {
+		auto checkRanges = []( IFile * file ) {
+			IFileReader *reader = nullptr;
+			CHECK_EQUAL( MGDF_OK, file->Open( &reader ) );
+			std::vector<char> expected( static_cast<size_t>( reader->GetSize() ) );
+			CHECK_EQUAL( expected.size(), reader->Read( expected.data(), expected.size() ) );
+
+			const INT64 size = static_cast<INT64>( expected.size() );
+			char buffers[4][32];
+			ReadRange ranges[4] = {
+				{ 20, 10, buffers[0], 0 },
+				{ 0, 8, buffers[1], 0 },
+				{ 5, 10, buffers[2], 0 },
+				{ size - 4, 32, buffers[3], 0 }
+			};
+			CHECK_EQUAL( 32, reader->ReadMany( ranges, 4 ) );
+			for ( auto &range : ranges ) {
+				CHECK_EQUAL( std::min<UINT64>( range.length, static_cast<UINT64>( size - range.offset ) ), range.read );
+				CHECK( memcmp( expected.data() + range.offset, range.buffer, static_cast<size_t>( range.read ) ) == 0 );
+			}
+			reader->Close();
+		};
+
+		_vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content" ).c_str() );
+		checkRanges( _vfs->GetFile( L"console.json" ) );
+
+		// stream every zip entry regardless of its size
+		zip::ZipArchiveHandlerImpl *handler = static_cast<zip::ZipArchiveHandlerImpl *>( zip::CreateZipArchiveHandlerImpl( ( IErrorHandler * ) _errorHandler ) );
+		handler->SetStreamingThreshold( 0 );
+		IVirtualFileSystemComponent *vfs = CreateVirtualFileSystemComponentImpl();
+		vfs->RegisterArchiveHandler( handler );
+		vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content/test.zip" ).c_str() );
+		checkRanges( vfs->GetFile( L"content/test.lua" ) );
+		delete vfs;
+
+		std::filesystem::path archivePath = std::filesystem::temp_directory_path() / L"mgdf.vfstests.readmany.mgdfpak";
+		std::string compressible( 200000, 'p' );
+		for ( size_t i = 0; i < compressible.size(); i += 7 ) {
+			compressible[i] = static_cast<char>( 'a' + i % 26 );
+		}
+		pak::PakWriter writer;
+		writer.AddData( L"compressed.txt", compressible );
+		CHECK( writer.Save( archivePath.wstring() ) );
+		CHECK_EQUAL( 1, writer.GetCompressedCount() );
+		vfs = CreateVirtualFileSystemComponentImpl();
+		vfs->RegisterArchiveHandler( pak::CreatePakArchiveHandlerImpl( ( IErrorHandler * ) _errorHandler ) );
+		vfs->Mount( archivePath.c_str() );
+		checkRanges( vfs->GetFile( L"compressed.txt" ) );
+		delete vfs;
+		std::filesystem::remove( archivePath );
+	}
+
+	/**
+	check that files can be read in full into a caller supplied buffer, and that unbuffered readers inflate compressed
+	entries as they are read unless the entry is already held decompressed for another reader
+	*/
+	TEST_FIXTURE( VFSTestFixture, ReadAllTests ) {
+		_vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content" ).c_str() );
+
+		auto checkReadAll = []( IFile * file ) {
+			IFileReader *reader = nullptr;
+			CHECK_EQUAL( MGDF_OK, file->Open( &reader ) );
+			std::vector<char> expected( static_cast<size_t>( reader->GetSize() ) );
+			reader->Read( expected.data(), expected.size() );
+			reader->Close();
+
+			UINT64 length = 0;
+			CHECK_EQUAL( MGDF_OK, file->ReadAll( nullptr, &length ) );
+			CHECK_EQUAL( expected.size(), length );
+
+			std::vector<char> buffer( static_cast<size_t>( length ) );
+			length = 1;
+			CHECK_EQUAL( MGDF_ERR_BUFFER_TOO_SMALL, file->ReadAll( buffer.data(), &length ) );
+			CHECK_EQUAL( expected.size(), length );
+			CHECK_EQUAL( MGDF_OK, file->ReadAll( buffer.data(), &length ) );
+			CHECK( buffer == expected );
+			CHECK( !file->IsOpen() );
+		};
+		checkReadAll( _vfs->GetFile( L"console.json" ) );
+		checkReadAll( _vfs->GetFile( L"test.zip/content/test.lua" ) );
+
+		UINT64 length = 0;
+		CHECK_EQUAL( MGDF_ERR_IS_FOLDER, _vfs->GetFile( L"test.zip/content" )->ReadAll( nullptr, &length ) );
+
+		// the entry is inflated as it is read, unless another reader already holds it decompressed
+		IFile *file = _vfs->GetFile( L"test.zip/content/test.lua" );
+		IFileReader *unbuffered = nullptr;
+		CHECK_EQUAL( MGDF_OK, file->OpenUnbuffered( &unbuffered ) );
+		CHECK( unbuffered->GetView() == nullptr );
+		std::vector<char> streamed( static_cast<size_t>( unbuffered->GetSize() ) );
+		CHECK_EQUAL( streamed.size(), unbuffered->Read( streamed.data(), streamed.size() ) );
+		unbuffered->Close();
+
+		IFileReader *reader = nullptr;
+		CHECK_EQUAL( MGDF_OK, file->Open( &reader ) );
+		CHECK_EQUAL( MGDF_OK, file->OpenUnbuffered( &unbuffered ) );
+		CHECK( unbuffered->GetView() != nullptr );
+		CHECK( memcmp( streamed.data(), unbuffered->GetView()->GetData(), streamed.size() ) == 0 );
+		unbuffered->Close();
+		reader->Close();
+
+		// opening a buffered reader while an unbuffered one is inflating the entry still decompresses it
+		CHECK_EQUAL( MGDF_OK, file->OpenUnbuffered( &unbuffered ) );
+		CHECK( unbuffered->GetView() == nullptr );
+		CHECK_EQUAL( MGDF_OK, file->Open( &reader ) );
+		CHECK( reader->GetView() != nullptr );
+		std::vector<char> buffered( streamed.size() );
+		CHECK_EQUAL( buffered.size(), reader->Read( buffered.data(), buffered.size() ) );
+		CHECK( buffered == streamed );
+		CHECK_EQUAL( streamed.size(), unbuffered->Read( buffered.data(), buffered.size() ) );
+		CHECK( buffered == streamed );
+		reader->Close();
+		unbuffered->Close();
+		CHECK( !file->IsOpen() );
+
+		std::filesystem::path archivePath = std::filesystem::temp_directory_path() / L"mgdf.vfstests.readall.mgdfpak";
+		std::string compressible( 200000, 'p' );
+		for ( size_t i = 0; i < compressible.size(); i += 7 ) {
+			compressible[i] = static_cast<char>( 'a' + i % 26 );
+		}
+		pak::PakWriter writer;
+		writer.AddData( L"stored.txt", "stored content" );
+		writer.AddData( L"compressed.txt", compressible );
+		CHECK( writer.Save( archivePath.wstring() ) );
+		CHECK_EQUAL( 1, writer.GetCompressedCount() );
+		IVirtualFileSystemComponent *vfs = CreateVirtualFileSystemComponentImpl();
+		vfs->RegisterArchiveHandler( pak::CreatePakArchiveHandlerImpl( ( IErrorHandler * ) _errorHandler ) );
+		vfs->Mount( archivePath.c_str() );
+		checkReadAll( vfs->GetFile( L"stored.txt" ) );
+		checkReadAll( vfs->GetFile( L"compressed.txt" ) );
+		delete vfs;
+		std::filesystem::remove( archivePath );
+	}
+
+	/**
+	check that the size and last write time of files are recorded when they are mapped, and are read again once a file is known to have changed
+	*/
+	TEST_FIXTURE( VFSTestFixture, MetadataTests ) {
+		_vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content" ).c_str() );
+
+		// archive entries take thier size and last write time from the central directory
+		IFile *entry = _vfs->GetFile( L"test.zip/content/test.lua" );
+		IFileReader *reader = nullptr;
+		CHECK_EQUAL( MGDF_OK, entry->Open( &reader ) );
+		CHECK_EQUAL( reader->GetSize(), entry->GetSize() );
+		reader->Close();
+		CHECK( entry->GetLastWriteTime() > 0 );
+		CHECK_EQUAL( 0, _vfs->GetFile( L"test.zip/content" )->GetSize() );
+
+		std::filesystem::path contentPath = std::filesystem::temp_directory_path() / L"mgdf.vfstests.metadata";
+		std::filesystem::remove_all( contentPath );
+		std::filesystem::create_directories( contentPath / L"folder" );
+		std::ofstream( ( contentPath / L"folder" / L"file.txt" ).wstring() ) << "content";
+		IVirtualFileSystemComponent *vfs = CreateVirtualFileSystemComponentImpl();
+		vfs->Mount( contentPath.c_str() );
+
+		IFile *file = vfs->GetFile( L"folder/file.txt" );
+		CHECK( file != nullptr );
+		CHECK_EQUAL( 7, file->GetSize() );
+		CHECK( file->GetLastWriteTime() > 0 );
+		CHECK_EQUAL( 0, vfs->GetFile( L"folder" )->GetSize() );
+
+		// the recorded metadata is used until the file is known to have been modified
+		std::ofstream( ( contentPath / L"folder" / L"file.txt" ).wstring(), std::ios::app ) << " appended";
+		CHECK_EQUAL( 7, file->GetSize() );
+		dynamic_cast<FileBaseImpl *>( file )->InvalidateMetadata();
+		CHECK_EQUAL( 16, file->GetSize() );
+
+		delete vfs;
+		std::filesystem::remove_all( contentPath );
+	}
+
+	/**
+	check that once the tree has been mapped, lookups of missing paths are failed by the path filter and every path in the tree is still found
+	*/
+	TEST_FIXTURE( VFSTestFixture, PathFilterTests ) {
+		_vfs->EnablePathFilter( true );
+		_vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content" ).c_str() );
+		_vfs->WaitForMapping();
+
+		const PathFilter *filter = _vfs->GetPathFilter();
+		CHECK( filter != nullptr );
+		CHECK( _vfs->GetRoot() == _vfs->GetFile( L"" ) );
+		CHECK_WS_EQUAL( L"console.json", _vfs->GetFile( L"console.json" )->GetName() );
+		CHECK_WS_EQUAL( L"test.lua", _vfs->GetFile( L"test.zip/content/test.lua" )->GetName() );
+		CHECK_WS_EQUAL( L"test.lua", _vfs->GetFile( L"/test.zip//content/test.lua" )->GetName() );
+
+		size_t rejected = filter->GetRejected();
+		CHECK( _vfs->GetFile( L"test.zip/content/missing.lua" ) == nullptr );
+		CHECK( _vfs->GetFile( L"missing/test.lua" ) == nullptr );
+		// each missing path is either rejected by the filter or is a false positive
+		CHECK_EQUAL( 2, filter->GetRejected() - rejected + filter->GetFalsePositives() );
+
+		// archives are mapped when they are mounted, so the filter is built straight away
+		IVirtualFileSystemComponent *vfs = CreateVirtualFileSystemComponentImpl();
+		vfs->RegisterArchiveHandler( zip::CreateZipArchiveHandlerImpl( ( IErrorHandler * ) _errorHandler ) );
+		vfs->EnablePathFilter( true );
+		vfs->Mount( ( Resources::Instance().RootDir() + L"../../../tests/content/test.zip" ).c_str() );
+		CHECK( vfs->GetPathFilter() != nullptr );
+		CHECK_WS_EQUAL( L"test.lua", vfs->GetFile( L"content/test.lua" )->GetName() );
+		CHECK( vfs->GetFile( L"content/missing.lua" ) == nullptr );
+		delete vfs;
+	}
+
+	/**
+	check that the path filter never rejects a path which was added, and that its false positive rate is close to the expected rate
+	*/
+	TEST( PathFilterFalsePositiveTests ) {
+		const size_t count = 10000;
+		PathFilter filter( count );
+		for ( size_t i = 0; i < count; ++i ) {
+			filter.Add( PathFilter::Hash( ( L"content/folder" + std::to_wstring( i % 100 ) + L"/file" + std::to_wstring( i ) ).c_str() ) );
+		}
+		CHECK_EQUAL( count, filter.GetPathCount() );
+		for ( size_t i = 0; i < count; ++i ) {
+			CHECK( filter.MayContain( PathFilter::Hash( ( L"content/folder" + std::to_wstring( i % 100 ) + L"/file" + std::to_wstring( i ) ).c_str() ) ) );
+		}
+
+		size_t falsePositives = 0;
+		for ( size_t i = count; i < count * 11; ++i ) {
+			if ( filter.MayContain( PathFilter::Hash( ( L"content/folder" + std::to_wstring( i % 100 ) + L"/file" + std::to_wstring( i ) ).c_str() ) ) ) {
+				++falsePositives;
+			}
+		}
+		CHECK( filter.GetFalsePositiveRate() < 0.02 );
+		CHECK( falsePositives < count * 10 * 3 / 100 );
+
+		// empty components are ignored, and hashing a tree one component at a time gives the same hashes as hashing whole paths
+		CHECK_EQUAL( PathFilter::Hash( L"a/b" ), PathFilter::Hash( L"/a//b/" ) );
+		CHECK_EQUAL( PathFilter::Hash( L"a/b" ), PathFilter::Append( PathFilter::Append( PathFilter::EMPTY_HASH, L"a" ), L"b" ) );
+		CHECK_EQUAL( PathFilter::EMPTY_HASH, PathFilter::Hash( L"" ) );
+		CHECK( PathFilter::Hash( L"ab" ) != PathFilter::Hash( L"a/b" ) );
+	}
+
+	/**
+	check that a frozen child list is sorted by name, keeps only the first child added with any name and finds every child
+	*/
+	TEST( ChildListTests ) {
+		Arena arena;
+		auto folder = [&arena]( const wchar_t *name ) {
+			return arena.New<FolderBaseImpl>( arena.Intern( std::wstring( name ) ), L"", nullptr, &arena );
+		};
+		IFile *b = folder( L"b.txt" );
+		IFile *a = folder( L"a.txt" );
+		IFile *duplicate = folder( L"b.txt" );
+		IFile *c = folder( L"c" );
+
+		ChildList children( &arena );
+		children.Add( b );
+		children.Add( a );
+		children.Add( duplicate );
+		children.Add( c );
+		CHECK( !children.IsFrozen() );
+		CHECK( b == children.Find( L"b.txt" ) );
+		CHECK( children.Find( L"d" ) == nullptr );
+
+		children.Freeze();
+		CHECK( children.IsFrozen() );
+		CHECK_EQUAL( 3, children.Size() );
+		const wchar_t *expected[] = { L"a.txt", L"b.txt", L"c" };
+		size_t i = 0;
+		for ( auto &entry : children ) {
+			CHECK_WS_EQUAL( expected[i++], entry.name );
+		}
+		CHECK( a == children.Find( L"a.txt" ) );
+		CHECK( b == children.Find( L"b.txt" ) );
+		CHECK( c == children.Find( L"c" ) );
+		CHECK( children.Find( L"" ) == nullptr );
+		CHECK( children.Find( L"a" ) == nullptr );
+		CHECK( children.Find( L"b.txt2" ) == nullptr );
+		CHECK( children.Find( L"d" ) == nullptr );
+	}
+
+	/**
+	check that the arena interns strings and destroys the objects created in it which need destroying
+	*/
+	TEST( ArenaTests ) {
+		struct Counted {
+			Counted( int *count ) : _count( count ) {}
+			~Counted() {
+				++( *_count );
+			}
+			int *_count;
+		};
+		struct Plain {
+			Plain( int *count ) : _count( count ) {}
+			int *_count;
+		};
+
+		int destroyed = 0;
+		{
+			Arena arena( 256 );
+			const wchar_t *a = arena.Intern( std::wstring( L"test.lua" ) );
+			const wchar_t *b = arena.Intern( L"test.lua", 8 );
+			CHECK( a == b );
+			CHECK_WS_EQUAL( L"test.lua", a );
+			CHECK( a != arena.Intern( L"test", 4 ) );
+			CHECK_EQUAL( 9 * sizeof( wchar_t ), arena.GetInternedBytesSaved() );
+
+			// copies are never shared
+			const wchar_t *c = arena.Copy( std::wstring( L"test.lua" ) );
+			CHECK( c != a );
+			CHECK_WS_EQUAL( L"test.lua", c );
+
+			for ( int i = 0; i < 100; ++i ) {
+				arena.New<Counted>( &destroyed );
+				arena.New<Plain>( &destroyed );
+			}
+			// allocations larger than a block get a block of thier own
+			memset( arena.Allocate( 1024, 16 ), 0, 1024 );
+			CHECK( arena.GetUsedBytes() <= arena.GetReservedBytes() );
+			CHECK_EQUAL( 0, destroyed );
+
+			// interning from many threads at once (which grows the tables) still returns one copy of each string
+			std::vector<std::vector<const wchar_t *>> interned( 4 );
+			std::vector<std::thread> threads;
+			for ( size_t t = 0; t < interned.size(); ++t ) {
+				threads.push_back( std::thread( [&arena, &interned, t]() {
+					for ( int i = 0; i < 2000; ++i ) {
+						interned[t].push_back( arena.Intern( L"file" + std::to_wstring( i ) ) );
+					}
+				} ) );
+			}
+			for ( auto &thread : threads ) {
+				thread.join();
+			}
+			for ( size_t t = 1; t < interned.size(); ++t ) {
+				CHECK( interned[t] == interned[0] );
+			}
+			CHECK_WS_EQUAL( L"file1999", interned[0][1999] );
+		}
+		// only the objects which need thier destructors run are destroyed
+		CHECK_EQUAL( 100, destroyed );
+		CHECK( std::is_trivially_destructible<ChildList>::value );
+	}
+
 }
\ No newline at end of file
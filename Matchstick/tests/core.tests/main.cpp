@@ -81,6 +81,7 @@ private:
 };
 
 void BuildTestTree( Node<Test> &tree );
+void DisableBenchmarks( Node<Test> &tree );
 void SetExecute( Node<Test> &tree, bool value );
 void GetTestList( Node<Test> &tree, TestList &list );
 void ParseArguments( Node<Test> &tree, TestFlags &flags, int argc, char **argv );
@@ -94,6 +95,7 @@ int main( int argc, char **argv )
 
 	Node<Test> tree;
 	BuildTestTree( tree );
+	DisableBenchmarks( tree );
 
 	_ASSERTE( argc >= 1 );
 	ParseArguments( tree, flags, argc, argv );
@@ -199,6 +201,18 @@ void SetExecute( Node<Test> &tree, bool value )
 	tree.Execute = value;
 }
 
+//benchmark suites are slow so they are only run when explicitly enabled e.g. +VFSBenchmarks
+void DisableBenchmarks( Node<Test> &tree )
+{
+	const std::string suffix = "Benchmarks";
+	for ( auto iter = tree.Children.begin(); iter != tree.Children.end(); ++iter ) {
+		const std::string &name = iter->first;
+		if ( name.size() >= suffix.size() && name.compare( name.size() - suffix.size(), suffix.size(), suffix ) == 0 ) {
+			SetExecute( iter->second, false );
+		}
+	}
+}
+
 void GetTestList( Node<Test> &tree, TestList &list )
 {
 	if ( !tree.Execute ) return;